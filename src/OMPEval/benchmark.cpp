@@ -2,10 +2,15 @@
 #include "omp/Random.h"
 #include "omp/Hand.h"
 #include "omp/HandEvaluator.h"
+#include "omp/CompactHandEvaluator.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <thread>
 #include <vector>
+#include <string>
 #include <algorithm>
+#include <numeric>
 #if OMP_BENCHMARK_3RD_PARTY
     // Include last because of all the badly named macros. I hate C programmers.
     #include "evaluators/SKPokerEval/SevenEval.h"
@@ -18,6 +23,55 @@
 
 using namespace std;
 
+// Result of one benchmark mode. All of them are collected for the JSON output.
+struct BenchmarkResult
+{
+    string evaluator, mode;
+    unsigned threads;
+    uint64_t evals;
+    double seconds;
+};
+
+static vector<BenchmarkResult> benchmarkResults;
+
+// Prints a result and stores it for the JSON output. The checksum is printed so that the evaluations can't be
+// optimized away.
+static void report(const string& evaluator, const string& mode, uint64_t count, double t, unsigned sum,
+                   unsigned threads = 1)
+{
+    cout << "   " << count << " evals  " << (1e-6 * count / t) << "M/s  " << t << "s  " << sum << endl;
+    benchmarkResults.push_back({evaluator, mode, threads, count, t});
+}
+
+static string jsonString(const string& s)
+{
+    string ret = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            ret += '\\';
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+// Writes all results as JSON, e.g. for tracking the evaluation speed of each mode over time.
+static bool writeJson(const char* filename)
+{
+    ofstream out(filename);
+    out << "{" << endl;
+    out << "  \"kernel\": " << jsonString(omp::HandEvaluator::kernelName(omp::HandEvaluator::kernel())) << "," << endl;
+    out << "  \"hardwareThreads\": " << thread::hardware_concurrency() << "," << endl;
+    out << "  \"results\": [";
+    for (size_t i = 0; i < benchmarkResults.size(); ++i) {
+        const BenchmarkResult& r = benchmarkResults[i];
+        out << (i ? "," : "") << endl << "    {\"evaluator\": " << jsonString(r.evaluator)
+            << ", \"mode\": " << jsonString(r.mode) << ", \"threads\": " << r.threads << ", \"evals\": " << r.evals
+            << ", \"seconds\": " << r.seconds << ", \"evalsPerSecond\": " << r.evals / r.seconds << "}";
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+    return (bool)out;
+}
+
 // Base class for evaluator adaptors utilizing CRTP.
 template<class TEval, class THand = nullptr_t>
 class AdaptorBase
@@ -76,6 +130,27 @@ public:
     }
 };
 
+// OMPEval with the 16kB tables of CompactHandEvaluator.
+class OmpCompact : public omp::CompactHandEvaluator, public AdaptorBase<OmpCompact, omp::Hand>
+{
+public:
+    void initHand(Hand& h) const
+    {
+        h = Hand::empty();
+    }
+
+    void addCard(Hand& h, unsigned cardIdx) const
+    {
+        h += cardIdx;
+    }
+
+    unsigned evaluate(const Hand& h, unsigned c1, unsigned c2, unsigned c3, unsigned c4,
+            unsigned c5, unsigned c6, unsigned c7) const
+    {
+        return omp::CompactHandEvaluator::evaluate(h);
+    }
+};
+
 #if OMP_BENCHMARK_3RD_PARTY
 
 // SKPokerEval
@@ -216,9 +291,10 @@ public:
     typedef typename TEval::Hand Hand;
 
     // Run test and benchmarks.
-    void run()
+    void run(const char* name)
     {
-        cout << endl;
+        mName = name;
+        cout << endl << name << ":" << endl;
         if (!is_same<TEval,Omp>::value)
             test(Omp());
         sequential<false>();
@@ -228,6 +304,29 @@ public:
         sequential<true>();
     }
 
+    // Benchmarks that use the OMPEval API directly (only for the OMPEval evaluators): thread scaling, evaluation with
+    // cold caches, batch evaluation and showdowns like in EquityCalculator::evaluateHands().
+    void runModes(const char* name)
+    {
+        mName = name;
+        cout << endl << name << " (modes):" << endl;
+        vector<omp::Hand> table = generateRandomOmpHands(1 << 20);
+        unsigned maxThreads = max(thread::hardware_concurrency(), 1u);
+        for (unsigned n = 1; ; n = min(2 * n, maxThreads)) {
+            threads(table, n);
+            if (n == maxThreads)
+                break;
+        }
+        coldCache(table);
+        for (unsigned batchSize : {4u, 16u, 64u, 256u})
+            batch(table, batchSize);
+        showdown<2>();
+        showdown<3>();
+        showdown<4>();
+        showdown<5>();
+        showdown<6>();
+    }
+
 private:
     // Benchmark sequential evaluation.
     template<bool tSingleSuit>
@@ -274,7 +373,7 @@ private:
 
         auto t2 = chrono::high_resolution_clock::now();
         double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
-        cout << "   " << count << " evals  " << (1e-6 * count / t) << "M/s  " << t << "s  " << sum << endl;
+        report(mName, tSingleSuit ? "sequential flush" : "sequential", count, t, sum);
     }
 
     // Benchmark random order evaluation using card arrays.
@@ -308,7 +407,7 @@ private:
 
         auto t2 = chrono::high_resolution_clock::now();
         double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
-        cout << "   " << count << " evals  " << (1e-6 * count / t) << "M/s  " << t << "s  " << sum << endl;
+        report(mName, "random card arrays", count, t, sum);
     }
 
     // Benchmark random order evaluation using Hand objects.
@@ -348,7 +447,132 @@ private:
 
         auto t2 = chrono::high_resolution_clock::now();
         double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
-        cout << "   " << count << " evals  " << (1e-6 * count / t) << "M/s  " << t << "s  " << sum << endl;
+        report(mName, "random hands", count, t, sum);
+    }
+
+    // Random order evaluation with multiple threads evaluating the same table at different positions.
+    void threads(const vector<omp::Hand>& table, unsigned threadCount)
+    {
+        cout << "Random order evaluation (" << threadCount << " threads):" << endl;
+        vector<unsigned> sums(threadCount);
+        vector<thread> threads;
+        auto t1 = chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < threadCount; ++i) {
+            threads.emplace_back([&,i]{
+                unsigned sum = 0;
+                size_t start = i * table.size() / threadCount;
+                for (unsigned rep = 0; rep < 64; ++rep) {
+                    for (size_t j = start; j < table.size(); ++j)
+                        sum += mEval.evaluate(table[j], 0, 0, 0, 0, 0, 0, 0);
+                    for (size_t j = 0; j < start; ++j)
+                        sum += mEval.evaluate(table[j], 0, 0, 0, 0, 0, 0, 0);
+                }
+                sums[i] = sum;
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        auto t2 = chrono::high_resolution_clock::now();
+        double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+        report(mName, "random hands, " + to_string(threadCount) + " threads", 64ull * table.size() * threadCount, t,
+               accumulate(sums.begin(), sums.end(), 0u), threadCount);
+    }
+
+    // Random order evaluation of short runs of hands after the caches have been flushed by writing a buffer that is
+    // larger than the last level cache. Only the evaluation is timed.
+    void coldCache(const vector<omp::Hand>& table)
+    {
+        cout << "Random order evaluation (cold cache):" << endl;
+        static const size_t EVICT_SIZE = 64 << 20, RUN_LENGTH = 1024;
+        vector<char> evict(EVICT_SIZE);
+        omp::XoroShiro128Plus rng(0);
+        omp::FastUniformIntDistribution<unsigned> rnd(0, (unsigned)(table.size() - RUN_LENGTH));
+        unsigned sum = 0;
+        uint64_t count = 0;
+        double t = 0;
+        for (unsigned round = 0; round < 200; ++round) {
+            for (size_t i = 0; i < EVICT_SIZE; i += 64)
+                evict[i] += (char)round;
+            size_t start = rnd(rng);
+            auto t1 = chrono::high_resolution_clock::now();
+            for (size_t i = start; i < start + RUN_LENGTH; ++i)
+                sum += mEval.evaluate(table[i], 0, 0, 0, 0, 0, 0, 0);
+            auto t2 = chrono::high_resolution_clock::now();
+            t += 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+            count += RUN_LENGTH;
+        }
+        report(mName, "cold cache", count, t, sum + evict[0]);
+    }
+
+    // Random order evaluation with evaluateBatch().
+    void batch(const vector<omp::Hand>& table, unsigned batchSize)
+    {
+        cout << "Batch evaluation (" << batchSize << " hands):" << endl;
+        vector<uint16_t> ranks(batchSize);
+        unsigned sum = 0;
+        uint64_t count = 0;
+        auto t1 = chrono::high_resolution_clock::now();
+        for (unsigned rep = 0; rep < 64; ++rep) {
+            for (size_t i = 0; i + batchSize <= table.size(); i += batchSize) {
+                mEval.evaluateBatch(table.data() + i, ranks.data(), batchSize);
+                for (uint16_t rank : ranks)
+                    sum += rank;
+                count += batchSize;
+            }
+        }
+        auto t2 = chrono::high_resolution_clock::now();
+        double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+        report(mName, "batch " + to_string(batchSize), count, t, sum);
+    }
+
+    // Showdowns of random deals: the board is combined with the hole cards of each player and the hands are
+    // evaluated with one evaluateBatch() call, same as in EquityCalculator.
+    template<unsigned tPlayers>
+    void showdown()
+    {
+        cout << "Showdown evaluation (board + " << tPlayers << " players):" << endl;
+        struct Deal
+        {
+            omp::Hand board;
+            omp::Hand holes[tPlayers];
+        };
+        vector<Deal> deals(1 << 16);
+        omp::XoroShiro128Plus rng(0);
+        omp::FastUniformIntDistribution<unsigned> rnd(0, 51);
+        for (Deal& deal : deals) {
+            uint64_t usedCardsMask = 0;
+            auto randomCard = [&]{
+                unsigned card;
+                do {
+                    card = rnd(rng);
+                } while (usedCardsMask & (1ull << card));
+                usedCardsMask |= 1ull << card;
+                return (uint8_t)card;
+            };
+            deal.board = omp::Hand::empty();
+            for (unsigned i = 0; i < 5; ++i)
+                deal.board += randomCard();
+            for (unsigned i = 0; i < tPlayers; ++i)
+                deal.holes[i] = omp::Hand(array<uint8_t,2>{{randomCard(), randomCard()}});
+        }
+        unsigned sum = 0;
+        uint64_t count = 0;
+        auto t1 = chrono::high_resolution_clock::now();
+        for (unsigned rep = 0; rep < 64; ++rep) {
+            for (const Deal& deal : deals) {
+                omp::Hand hands[tPlayers];
+                uint16_t ranks[tPlayers];
+                for (unsigned i = 0; i < tPlayers; ++i)
+                    hands[i] = deal.board + deal.holes[i];
+                mEval.evaluateBatch(hands, ranks, tPlayers);
+                for (unsigned i = 0; i < tPlayers; ++i)
+                    sum += ranks[i];
+                count += tPlayers;
+            }
+        }
+        auto t2 = chrono::high_resolution_clock::now();
+        double t = 1e-9 * chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+        report(mName, "showdown " + to_string(tPlayers) + " players", count, t, sum);
     }
 
     // Generate a vector of random hands. The random seed is deterministic on purpose.
@@ -374,6 +598,19 @@ private:
         return table;
     }
 
+    // Random 7-card hands as Hand objects.
+    static vector<omp::Hand> generateRandomOmpHands(size_t count)
+    {
+        vector<omp::Hand> hands;
+        for (auto& cards : generateRandomHands(count)) {
+            omp::Hand h = omp::Hand::empty();
+            for (uint8_t c : cards)
+                h += c;
+            hands.push_back(h);
+        }
+        return hands;
+    }
+
     // Test this evaluator against another one by comparing the order in which they rank random hands.
     template<class TEval2>
     void test(const TEval2& eval2)
@@ -423,15 +660,23 @@ private:
     }
 
     TEval mEval;
+    string mName;
 };
 
-void benchmark()
+// Runs the benchmarks. If jsonFile is given, the results are also written there as JSON.
+void benchmark(const char* jsonFile)
 {
     // Benchmark only one at a time because there's some weird performance interference.
-    Benchmark<Omp>().run();
-    //Benchmark<Skpe>().run();
-    //Benchmark<Tpt>().run();
-    //Benchmark<Ace>().run();
-    //Benchmark<Sbhs>().run();
-    //Benchmark<Pse>().run();
+    Benchmark<Omp>().run("OMPEval");
+    Benchmark<OmpCompact>().run("OMPEval (CompactHandEvaluator)");
+    //Benchmark<Skpe>().run("SKPokerEval");
+    //Benchmark<Tpt>().run("2+2");
+    //Benchmark<Ace>().run("ACE");
+    //Benchmark<Sbhs>().run("HoldemShowdown");
+    //Benchmark<Pse>().run("poker-eval");
+    Benchmark<Omp>().runModes("OMPEval");
+    Benchmark<OmpCompact>().runModes("OMPEval (CompactHandEvaluator)");
+
+    if (jsonFile && !writeJson(jsonFile))
+        cout << "Couldn't write " << jsonFile << endl;
 }
@@ -0,0 +1,38 @@
+// Generates the precalculated results of heads-up preflops (omp/PrecalculatedResults.hxx), which are shipped with the
+// sources and regenerated with `make precalc`. Every canonical heads-up preflop is enumerated once by running random
+// vs random with preflop-major enumeration on all cores, and the entries of the preflop cache are printed as the
+// table. Must be built with OMP_PRECALCULATED_RESULTS=0, because otherwise the calculator would use the table it is
+// generating. Usage:
+//   genpreflop [threads]
+
+#include "omp/EquityCalculator.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    unsigned threads = argc > 1 ? (unsigned)std::atoi(argv[1]) : 0;
+    omp::EquityCalculator eq;
+    eq.setEnumeration(omp::EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+    // Enough for all of the 49608 canonical preflops.
+    eq.setCacheSize((size_t)64 << 20);
+    auto callback = [](const omp::EquityCalculator::Results& r){
+        std::cerr << "\rgenpreflop: " << (int)(r.progress * 100) << "%" << std::flush;
+    };
+    if (!eq.start({"random", "random"}, 0, 0, true, 0, callback, 1, threads)) {
+        std::cerr << "genpreflop: failed to start the enumeration" << std::endl;
+        return 1;
+    }
+    eq.wait();
+    auto r = eq.getResults();
+    std::cerr << std::endl;
+    if (r.progress < 1 || r.cacheEvictions > 0) {
+        std::cerr << "genpreflop: the enumeration didn't finish or the cache was too small" << std::endl;
+        return 1;
+    }
+    std::cerr << "genpreflop: " << r.evaluatedPreflopCombos << " canonical preflops in " << r.time << "s"
+              << std::endl;
+    eq.outputPrecalculatedResults(std::cout);
+    return 0;
+}
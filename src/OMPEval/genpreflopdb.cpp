@@ -0,0 +1,186 @@
+// Generates databases of exact preflop results for EquityCalculator::setPreflopDatabase(). Every canonical preflop
+// of the ranges is enumerated once. The work can be split into shards by preflop id, so that it can be run in many
+// processes or on many machines, and the shards are then merged into one database. Usage:
+//   genpreflopdb [--shard I/N] [--threads T] OUTPUT [RANGE...]
+//                        Enumerates the preflops of shard I (0 to N-1) of N and writes them to OUTPUT. The ranges
+//                        default to random for 3 players. All cores are used by default.
+//   genpreflopdb --merge OUTPUT SHARD...
+//                        Merges shard databases into one.
+// With random ranges for 3 players there are about 15.3 million canonical preflops. Each one is a full enumeration of
+// 1.37 million boards (a few milliseconds), so the full 3-player database takes roughly 10 core-hours and is meant to
+// be generated in shards. It is about 1.2GB.
+
+#include "omp/EquityCalculator.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+using namespace omp;
+
+typedef std::array<std::array<uint8_t,2>,MAX_PLAYERS> Preflop;
+
+// Spreads the ids evenly to the shards.
+static bool inShard(uint64_t preflopId, unsigned shard, unsigned shardCount)
+{
+    return (unsigned)(((preflopId * 0x9e3779b97f4a7c15ull) >> 32) % shardCount) == shard;
+}
+
+struct PreflopSearch
+{
+    const std::vector<CardRange>& ranges;
+    unsigned shard, shardCount;
+    // When all ranges are the same, the order of players doesn't matter, so only increasing combo indexes are used.
+    bool sameRanges;
+    std::unordered_set<uint64_t> seen;
+    std::vector<std::pair<uint64_t,Preflop>> preflops;
+    Preflop hands;
+
+    void search(unsigned player, size_t firstIdx, uint64_t usedCards)
+    {
+        if (player == ranges.size()) {
+            Preflop canonical = hands;
+            uint64_t id = EquityCalculator::canonicalizePreflop(canonical.data(), player);
+            if (inShard(id, shard, shardCount) && seen.insert(id).second)
+                preflops.emplace_back(id, canonical);
+            return;
+        }
+        auto& combos = ranges[player].combinations();
+        for (size_t i = sameRanges ? firstIdx : 0; i < combos.size(); ++i) {
+            uint64_t mask = (1ull << combos[i][0]) | (1ull << combos[i][1]);
+            if (usedCards & mask)
+                continue;
+            hands[player] = combos[i];
+            search(player + 1, i + 1, usedCards | mask);
+        }
+    }
+};
+
+// Finds the canonical preflops of the ranges that belong to a shard, sorted by id.
+static std::vector<std::pair<uint64_t,Preflop>> findPreflops(const std::vector<CardRange>& ranges, unsigned shard,
+                                                             unsigned shardCount)
+{
+    PreflopSearch s{ranges, shard, shardCount, true};
+    for (auto& r : ranges)
+        s.sameRanges &= r.combinations() == ranges[0].combinations();
+    s.search(0, 0, 0);
+    std::sort(s.preflops.begin(), s.preflops.end(), [](const std::pair<uint64_t,Preflop>& lhs,
+              const std::pair<uint64_t,Preflop>& rhs){ return lhs.first < rhs.first; });
+    return s.preflops;
+}
+
+// Enumerates the boards of each preflop on its own thread. The hands are already in canonical order, so the results
+// of the calculator are in the order of the database.
+static std::vector<PreflopDatabase::Entry> enumeratePreflops(const std::vector<std::pair<uint64_t,Preflop>>& preflops,
+                                                             unsigned nplayers, unsigned threadCount)
+{
+    std::vector<PreflopDatabase::Entry> entries(preflops.size());
+    std::atomic<size_t> next(0);
+    std::mutex outputMutex;
+    auto worker = [&]{
+        EquityCalculator eq;
+        eq.setEnumeration(EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+        eq.setCacheSize(1 << 20);
+        for (size_t i; (i = next++) < preflops.size();) {
+            std::vector<CardRange> ranges;
+            for (unsigned j = 0; j < nplayers; ++j)
+                ranges.push_back(CardRange(std::vector<std::array<uint8_t,2>>{preflops[i].second[j]}));
+            eq.start(ranges, 0, 0, true, 0, nullptr, 0.1, 1);
+            eq.wait();
+            auto r = eq.getResults();
+            std::vector<uint32_t>& values = entries[i].second;
+            entries[i].first = preflops[i].first;
+            for (unsigned j = 1; j < (1u << nplayers); ++j)
+                values.push_back((uint32_t)r.winsByPlayerMask[j]);
+            for (unsigned j = 0; j < nplayers; ++j)
+                values.insert(values.end(), r.handCategories[j] + 1, r.handCategories[j] + HAND_CATEGORY_COUNT);
+            if (i % 1000 == 0) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "\rgenpreflopdb: " << i << "/" << preflops.size() << std::flush;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+    std::cerr << "\rgenpreflopdb: " << preflops.size() << "/" << preflops.size() << std::endl;
+    return entries;
+}
+
+static int merge(const std::string& output, const std::vector<std::string>& shards)
+{
+    std::vector<PreflopDatabase::Entry> entries;
+    unsigned players = 0;
+    for (auto& path : shards) {
+        PreflopDatabase db;
+        if (!db.open(path) || (players && db.players() != players)) {
+            std::cerr << "genpreflopdb: invalid shard " << path << std::endl;
+            return 1;
+        }
+        players = db.players();
+        db.forEach([&](uint64_t id, const uint32_t* values){
+            entries.emplace_back(id, std::vector<uint32_t>(values, values + PreflopDatabase::valueCount(players)));
+        });
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const PreflopDatabase::Entry& lhs,
+                  const PreflopDatabase::Entry& rhs){ return lhs.first == rhs.first; }), entries.end());
+    if (!players || !PreflopDatabase::write(output, players, entries)) {
+        std::cerr << "genpreflopdb: failed to write " << output << std::endl;
+        return 1;
+    }
+    std::cerr << "genpreflopdb: " << entries.size() << " preflops" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--merge") {
+        if (args.size() < 3) {
+            std::cerr << "usage: genpreflopdb --merge OUTPUT SHARD..." << std::endl;
+            return 1;
+        }
+        return merge(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+    }
+
+    unsigned shard = 0, shardCount = 1, threadCount = std::thread::hardware_concurrency();
+    size_t i = 0;
+    bool ok = true;
+    for (; ok && i < args.size() && args[i].compare(0, 2, "--") == 0; i += 2) {
+        if (args[i] == "--shard" && i + 1 < args.size())
+            ok = std::sscanf(args[i + 1].c_str(), "%u/%u", &shard, &shardCount) == 2 && shard < shardCount;
+        else if (args[i] == "--threads" && i + 1 < args.size())
+            ok = (threadCount = (unsigned)std::atoi(args[i + 1].c_str())) > 0;
+        else
+            ok = false;
+    }
+    std::vector<CardRange> ranges;
+    for (size_t j = i + 1; j < args.size(); ++j)
+        ranges.push_back(CardRange(args[j]));
+    if (ranges.empty())
+        ranges.assign(3, CardRange("random"));
+    if (!ok || i >= args.size() || ranges.size() < 2 || ranges.size() > MAX_PLAYERS) {
+        std::cerr << "usage: genpreflopdb [--shard I/N] [--threads T] OUTPUT [RANGE...]" << std::endl
+                  << "       genpreflopdb --merge OUTPUT SHARD..." << std::endl;
+        return 1;
+    }
+
+    auto preflops = findPreflops(ranges, shard, shardCount);
+    std::cerr << "genpreflopdb: " << preflops.size() << " canonical preflops in shard " << shard << "/"
+              << shardCount << std::endl;
+    auto entries = enumeratePreflops(preflops, (unsigned)ranges.size(), std::max(threadCount, 1u));
+    if (!PreflopDatabase::write(args[i], (unsigned)ranges.size(), entries)) {
+        std::cerr << "genpreflopdb: failed to write " << args[i] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,372 @@
+// Generates the lookup tables of HandEvaluator and ShortDeckHandEvaluator at build time, so that they can be compiled
+// into the read-only data of the library. Usage:
+//   gentables            Prints the hand value tables (omp/LookupTables.hxx).
+//   gentables --offsets  Recalculates the perfect hashes and prints the offset tables (omp/OffsetTable.hxx). Needed
+//                        if the rank multipliers or the hash parameters are changed.
+
+#include "omp/HandEvaluator.h"
+#include "omp/OffsetTable.hxx"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cstring>
+#include <string>
+
+namespace omp {
+
+constexpr unsigned HandEvaluatorBase::RANKS[];
+constexpr unsigned HandEvaluatorBase::FLUSH_RANKS[];
+
+// Generates the tables of one deck. name is the evaluator type used in the table definitions.
+template<class TDeck>
+class TableGenerator
+{
+public:
+    TableGenerator(const char* name, bool recalculateOffsets)
+        : name(name),
+          recalculateOffsets(recalculateOffsets),
+          LOOKUP(recalculateOffsets ? HE::MAX_KEY + 1 : 0),
+          FLUSH_LOOKUP(HE::FLUSH_LOOKUP_SIZE),
+          ORIG_LOOKUP(recalculateOffsets ? HE::MAX_KEY + 1 : 0)
+    {
+    }
+
+    void generate();
+    void outputLookupTables(std::ostream& out);
+    void calculatePerfectHashOffsets(std::ostream& out);
+
+private:
+    typedef BasicHandEvaluator<TDeck> HE;
+
+    unsigned populateLookup(uint64_t rankCounts, unsigned ncards, unsigned handValue, unsigned endRank,
+                            unsigned maxPair, unsigned maxTrips, unsigned maxStraight, bool flush = false);
+    static unsigned getKey(uint64_t rankCounts, bool flush);
+    static unsigned getBiggestStraight(uint64_t rankCounts);
+    template<class T>
+    static void outputArray(std::ostream& out, const char* declaration, const T* p, size_t count, unsigned perLine,
+                            bool hex);
+    static void outputTableStats(const char* name, const void* p, size_t elementSize, size_t count);
+    std::string declaration(const char* type, const char* table) const;
+
+    static const unsigned PERF_HASH_COLUMN_MASK = (1 << HE::PERF_HASH_ROW_SHIFT) - 1;
+    static const size_t OFFSET_COUNT = (HE::MAX_KEY >> HE::PERF_HASH_ROW_SHIFT) + 1;
+    // Lowest and highest used rank + 1.
+    static const unsigned LR = TDeck::LOWEST_RANK, RC = RANK_COUNT;
+    // Rank counts of the lowest straight, where the ace plays low.
+    static const uint64_t WHEEL = (0x1111ull << 4 * LR) + (1ull << 4 * (RC - 1));
+
+    // Minimum number of cards required for evaluating a hand. Can be set to higher value to decrease lookup
+    // table size (requires hash recalculation).
+    static const unsigned MIN_CARDS = 0;
+
+    const char* name;
+    bool recalculateOffsets;
+    std::vector<uint16_t> LOOKUP, FLUSH_LOOKUP, ORIG_LOOKUP;
+};
+
+// Calculates the hand values of all rank combinations. The order of flush and full house comes from the deck.
+template<class TDeck>
+void TableGenerator<TDeck>::generate()
+{
+    // 1. High card
+    unsigned handValue = HIGH_CARD;
+    handValue = populateLookup(0, 0, handValue, RC, 0, 0, 0);
+
+    // 2. Pair
+    handValue = PAIR;
+    for (unsigned r = LR; r < RC; ++r)
+        handValue = populateLookup(2ull << 4 * r, 2, handValue, RC, 0, 0, 0);
+
+    // 3. Two pairs
+    handValue = TWO_PAIR;
+    for (unsigned r1 = LR; r1 < RC; ++r1)
+        for (unsigned r2 = LR; r2 < r1; ++r2)
+            handValue = populateLookup((2ull << 4 * r1) + (2ull << 4 * r2), 4, handValue, RC, r2, 0, 0);
+
+    // 4. Three of a kind
+    handValue = THREE_OF_A_KIND;
+    for (unsigned r = LR; r < RC; ++r)
+        handValue = populateLookup(3ull << 4 * r, 3, handValue, RC, 0, r, 0);
+
+    // 4. Straight
+    handValue = STRAIGHT;
+    handValue = populateLookup(WHEEL, 5, handValue, RC, RC, RC, LR + 3); // wheel
+    for (unsigned r = LR + 4; r < RC; ++r)
+        handValue = populateLookup(0x11111ull << 4 * (r - 4), 5, handValue, RC, RC, RC, r);
+
+    // 6. FLUSH
+    handValue = TDeck::FLUSH;
+    handValue = populateLookup(0, 0, handValue, RC, 0, 0, 0, true);
+
+    // 7. Full house
+    handValue = TDeck::FULL_HOUSE;
+    for (unsigned r1 = LR; r1 < RC; ++r1)
+        for (unsigned r2 = LR; r2 < RC; ++r2)
+            if (r2 != r1)
+                handValue = populateLookup((3ull << 4 * r1) + (2ull << 4 * r2), 5, handValue, RC, r2, r1, RC);
+
+    // 8. Quads
+    handValue = FOUR_OF_A_KIND;
+    for (unsigned r = LR; r < RC; ++r)
+        handValue = populateLookup(4ull << 4 * r, 4, handValue, RC, RC, RC, RC);
+
+    // 9. Straight flush
+    handValue = STRAIGHT_FLUSH;
+    handValue = populateLookup(WHEEL, 5, handValue, RC, 0, 0, LR + 3, true); // low straight flush
+    for (unsigned r = LR + 4; r < RC; ++r)
+        handValue = populateLookup(0x11111ull << 4 * (r - 4), 5, handValue, RC, 0, 0, r, true);
+}
+
+// Iterates recursively over the the remaining cards ranks in a hand and writes the hand values for each combination
+// to lookup table. Parameters maxPair, maxTrips, maxStraight are used for checking that the hand
+// doesn't improve (except kickers).
+template<class TDeck>
+unsigned TableGenerator<TDeck>::populateLookup(uint64_t ranks, unsigned ncards, unsigned handValue, unsigned endRank,
+                                               unsigned maxPair, unsigned maxTrips, unsigned maxStraight, bool flush)
+{
+    // Only increment hand value counter for every valid 5 card combination. (Or smaller hands if enabled.)
+    if (ncards <= 5 && ncards >= (MIN_CARDS < 5 ? MIN_CARDS : 5))
+        ++handValue;
+
+    // Write hand value to lookup when we have required number of cards.
+    if (ncards >= MIN_CARDS || (flush && ncards >= 5)) {
+        unsigned key = getKey(ranks, flush);
+
+        // Write flush and non-flush hands in different tables
+        if (flush) {
+            FLUSH_LOOKUP[key >> LR] = handValue;
+        } else if (recalculateOffsets) {
+            ORIG_LOOKUP[key] = handValue;
+        } else {
+            // The size of the table isn't known before all keys are hashed. One extra element is left for padding.
+            unsigned idx = HE::perfHash(key);
+            if (idx + 1 >= LOOKUP.size())
+                LOOKUP.resize(idx + 2);
+            if (LOOKUP[idx] != 0 && LOOKUP[idx] != handValue)
+                throw std::runtime_error("perfect hash collision, offsets need to be recalculated");
+            LOOKUP[idx] = handValue;
+        }
+
+        if (ncards == 7)
+            return handValue;
+    }
+
+    // Iterate next card rank.
+    for (unsigned r = LR; r < endRank; ++r) {
+        uint64_t newRanks = ranks + (1ull << (4 * r));
+
+        // Check that hand doesn't improve.
+        unsigned rankCount = ((newRanks >> (r * 4)) & 0xf);
+        if (rankCount == 2 && r >= maxPair)
+            continue;
+        if (rankCount == 3 && r >= maxTrips)
+            continue;
+        if (rankCount >= 4) // Don't allow new quads or more than 4 of same rank.
+            continue;
+        if (getBiggestStraight(newRanks) > maxStraight)
+            continue;
+
+        handValue = populateLookup(newRanks, ncards + 1, handValue, r + 1, maxPair, maxTrips, maxStraight, flush);
+    }
+
+    return handValue;
+}
+
+// Calculate lookup table key from rank counts.
+template<class TDeck>
+unsigned TableGenerator<TDeck>::getKey(uint64_t ranks, bool flush)
+{
+    unsigned key = 0;
+    for (unsigned r = 0; r < RANK_COUNT; ++r)
+        key += ((ranks >> r * 4) & 0xf) * (flush ? HE::FLUSH_RANKS[r] : HE::RANKS[r]);
+    return key;
+}
+
+// Returns index of the highest straight card or 0 when no straight.
+template<class TDeck>
+unsigned TableGenerator<TDeck>::getBiggestStraight(uint64_t ranks)
+{
+    uint64_t rankMask = (0x1111111111111 & ranks) | (0x2222222222222 & ranks) >> 1 | (0x4444444444444 & ranks) >> 2;
+    for (unsigned i = 9; i-- > LR; )
+        if (((rankMask >> 4 * i) & 0x11111ull) == 0x11111ull)
+            return i + 4;
+    if ((rankMask & WHEEL) == WHEEL)
+        return LR + 3;
+    return 0;
+}
+
+// Perfect hashing based on the algorithm described in
+// http://www.drdobbs.com/architecture-and-design/generating-perfect-hash-functions/184404506
+template<class TDeck>
+void TableGenerator<TDeck>::calculatePerfectHashOffsets(std::ostream& out)
+{
+    // Store locations of all non-zero elements in original lookup table, divided into rows.
+    std::vector<std::pair<size_t,std::vector<size_t>>> rows;
+    std::vector<uint32_t> offsets(OFFSET_COUNT);
+    for (size_t i = 0; i < HE::MAX_KEY + 1; ++i) {
+        if (ORIG_LOOKUP[i]) {
+            size_t rowIdx = i >> HE::PERF_HASH_ROW_SHIFT;
+            if (rowIdx >= rows.size())
+                rows.resize(rowIdx + 1);
+            rows[rowIdx].second.push_back(i);
+        }
+    }
+
+    // Need to store the original row indexes because we need them after sorting.
+    for (size_t i = 0; i < rows.size(); ++i)
+        rows[i].first = i;
+
+    // Try to fit the densest rows first. Results in slightly smaller table.
+    std::sort(rows.begin(), rows.end(), [](const std::pair<size_t,std::vector<size_t>>& lhs,
+              const std::pair<size_t,std::vector<size_t>> & rhs){
+        return lhs.second.size() > rhs.second.size();
+    });
+
+    // Goes through every row and for each of them try to find the first offset that doesn't cause any collisions with
+    // previous rows. Does a very naive brute force search.
+    size_t maxIdx = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        size_t offset = 0; //-(rows[i].second[0] & PERF_HASH_COLUMN_MASK); makes no difference so let's avoid negative
+        for (;;++offset) {
+            bool ok = true;
+            for (auto x : rows[i].second) {
+                unsigned val = LOOKUP[(x & PERF_HASH_COLUMN_MASK) + offset];
+                if (val && val != ORIG_LOOKUP[x]) { // Allow collisions if value is the same
+                    ok = false;
+                    break;
+                }
+            }
+            if (ok)
+                break;
+        }
+        //std::cout << "row=" << i << " size=" << rows[i].second.size() << " offset=" << offset << std::endl;
+        offsets[rows[i].first] = (uint32_t)(offset - (rows[i].first << HE::PERF_HASH_ROW_SHIFT));
+        for (size_t key : rows[i].second) {
+            size_t newIdx = (key & PERF_HASH_COLUMN_MASK) + offset;
+            maxIdx = std::max<size_t>(maxIdx, newIdx);
+            LOOKUP[newIdx] = ORIG_LOOKUP[key];
+        }
+    }
+
+    // Output offset array.
+    outputArray(out, declaration("uint32_t", "PERF_HASH_ROW_OFFSETS").c_str(), offsets.data(), OFFSET_COUNT, 8, true);
+
+    // Output stats.
+    std::cerr << name << ":" << std::endl;
+    outputTableStats("FLUSH_LOOKUP", FLUSH_LOOKUP.data(), 2, HE::FLUSH_LOOKUP_SIZE);
+    outputTableStats("ORIG_LOOKUP", ORIG_LOOKUP.data(), 2, HE::MAX_KEY + 1);
+    outputTableStats("LOOKUP", LOOKUP.data(), 2, maxIdx + 1);
+    outputTableStats("OFFSETS", offsets.data(), 4, OFFSET_COUNT);
+    std::cerr << "lookup table size: " << maxIdx + 1 << std::endl;
+    std::cerr << "offset table size: " << OFFSET_COUNT << std::endl;
+}
+
+// Prints the hand value tables and the hand category tables as C++ source.
+template<class TDeck>
+void TableGenerator<TDeck>::outputLookupTables(std::ostream& out)
+{
+    // Categories of the non-flush hands are packed two per byte (even index in the low nibble). Flushes only need
+    // one bit to tell them apart from straight flushes.
+    std::vector<unsigned> categories((LOOKUP.size() + 1) / 2);
+    for (size_t i = 0; i < LOOKUP.size(); ++i)
+        categories[i / 2] |= (LOOKUP[i] >> HAND_CATEGORY_SHIFT) << (i % 2 * 4);
+    std::vector<uint64_t> straightFlushes((HE::FLUSH_LOOKUP_SIZE + 63) / 64);
+    for (size_t i = 0; i < FLUSH_LOOKUP.size(); ++i)
+        straightFlushes[i / 64] |= (uint64_t)(FLUSH_LOOKUP[i] >= STRAIGHT_FLUSH) << (i % 64);
+
+    outputArray(out, declaration("uint16_t", "LOOKUP").c_str(), LOOKUP.data(), LOOKUP.size(), 16, false);
+    out << std::endl;
+    outputArray(out, declaration("uint16_t", "FLUSH_LOOKUP").c_str(), FLUSH_LOOKUP.data(), FLUSH_LOOKUP.size(), 16,
+                false);
+    out << std::endl;
+    outputArray(out, declaration("uint8_t", "CATEGORY_LOOKUP").c_str(), categories.data(), categories.size(), 16,
+                true);
+    out << std::endl;
+    outputArray(out, declaration("uint64_t", "STRAIGHT_FLUSH_KEYS").c_str(), straightFlushes.data(),
+                straightFlushes.size(), 4, true);
+}
+
+// Returns the start of a table definition. The tables are explicit specializations of the evaluator template.
+template<class TDeck>
+std::string TableGenerator<TDeck>::declaration(const char* type, const char* table) const
+{
+    return std::string("template<> alignas(64) const ") + type + " omp::" + name + "::" + table + "[]";
+}
+
+// Prints an array definition.
+template<class TDeck>
+template<class T>
+void TableGenerator<TDeck>::outputArray(std::ostream& out, const char* declaration, const T* p, size_t count,
+                                 unsigned perLine, bool hex)
+{
+    out << declaration << " {";
+    for (size_t i = 0; i < count; ++i) {
+        out << (i % perLine ? " " : "\n    ");
+        if (hex)
+            out << "0x" << std::hex << p[i] << std::dec << ",";
+        else
+            out << p[i] << ",";
+    }
+    out << "\n};" << std::endl;
+}
+
+// Output stats about memory usage of a lookup table.
+template<class TDeck>
+void TableGenerator<TDeck>::outputTableStats(const char* name, const void* p, size_t elementSize, size_t count)
+{
+    char dummy[64]{};
+    size_t totalCacheLines = 0, usedCacheLines = 0, usedElements = 0;
+    for (size_t i = 0; i < elementSize * count; i += 64) {
+        ++totalCacheLines;
+        bool used = false;
+        for (size_t j = 0; j < 64 && i + j < elementSize * count; j += elementSize) {
+            if (std::memcmp((const char*)p + i + j, dummy, elementSize)) {
+                ++usedElements;
+                used = true;
+            }
+        }
+        usedCacheLines += used;
+    }
+    std::cerr << name << ": cachelines: " << usedCacheLines << "/" << totalCacheLines
+         << "  kbytes: " << usedCacheLines / 16  << "/" << totalCacheLines / 16
+         << "  elements: " << usedElements << "/" << count
+         << std::endl;
+}
+
+}
+
+template<class TDeck>
+static void generateTables(const char* name, bool recalculateOffsets)
+{
+    omp::TableGenerator<TDeck> generator(name, recalculateOffsets);
+    generator.generate();
+    if (recalculateOffsets)
+        generator.calculatePerfectHashOffsets(std::cout);
+    else
+        generator.outputLookupTables(std::cout);
+}
+
+int main(int argc, char** argv)
+{
+    bool recalculateOffsets = argc > 1 && std::strcmp(argv[1], "--offsets") == 0;
+    try {
+        std::cout << "#include \"HandEvaluator.h\"" << std::endl << std::endl;
+        if (recalculateOffsets) {
+            std::cout << "// Offset tables for the perfect hashing algorithm used in the evaluators. Generated by"
+                      << std::endl << "// gentables --offsets." << std::endl;
+        } else {
+            std::cout << "// Lookup tables for the evaluators. Generated by gentables.cpp during the build, do not "
+                      << "edit." << std::endl;
+        }
+        generateTables<omp::StandardDeck>("HandEvaluator", recalculateOffsets);
+        std::cout << std::endl;
+        generateTables<omp::ShortDeck>("ShortDeckHandEvaluator", recalculateOffsets);
+    } catch (std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
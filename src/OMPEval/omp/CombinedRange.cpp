@@ -3,7 +3,6 @@
 #include "Random.h"
 #include <algorithm>
 #include <iterator>
-#include <random>
 #include <cassert>
 
 namespace omp {
@@ -52,7 +51,7 @@ CombinedRange CombinedRange::join(const CombinedRange& range2) const
     return newRange;
 }
 
-uint64_t CombinedRange::estimateJoinSize(const CombinedRange& range2) const
+uint64_t CombinedRange::estimateJoinSize(const CombinedRange& range2, uint64_t limit) const
 {
     omp_assert(mPlayerCount + range2.mPlayerCount <= MAX_PLAYERS);
     uint64_t size = 0;
@@ -62,6 +61,8 @@ uint64_t CombinedRange::estimateJoinSize(const CombinedRange& range2) const
                 continue;
             ++size;
         }
+        if (size >= limit)
+            return limit;
     }
     return size;
 }
@@ -78,7 +79,8 @@ std::vector<CombinedRange> CombinedRange::joinRanges(
         unsigned besti = 0, bestj = 0;
         for (unsigned i = 0; i < combinedRanges.size(); ++i) {
             for (unsigned j = 0; j < i; ++j) {
-                uint64_t newSize = combinedRanges[i].estimateJoinSize(combinedRanges[j]);
+                uint64_t limit = std::min<uint64_t>(bestSize, maxSize + 1);
+                uint64_t newSize = combinedRanges[i].estimateJoinSize(combinedRanges[j], limit);
                 if (newSize < bestSize)
                     besti = i, bestj = j, bestSize = newSize;
             }
@@ -95,9 +97,8 @@ std::vector<CombinedRange> CombinedRange::joinRanges(
     return combinedRanges;
 }
 
-void CombinedRange::shuffle()
+void CombinedRange::shuffle(XoroShiro128Plus& rng)
 {
-    XoroShiro128Plus rng(std::random_device{}());
     std::shuffle(mCombos.begin(), mCombos.end(), rng);
 }
 
@@ -2,6 +2,7 @@
 #define OMP_COMBINED_RANGE_H
 
 #include "HandEvaluator.h"
+#include "Random.h"
 #include "Util.h"
 #include <vector>
 #include <array>
@@ -32,15 +33,16 @@ public:
     // Combine with another range and return the result.
     CombinedRange join(const CombinedRange& range2) const;
 
-    // Calculate the size of the joined range without actually doing it.
-    uint64_t estimateJoinSize(const CombinedRange& range2) const;
+    // Calculate the size of the joined range without actually doing it. Stops counting at limit, so that it's cheap
+    // to rule out joins that would be too big.
+    uint64_t estimateJoinSize(const CombinedRange& range2, uint64_t limit = ~0ull) const;
 
     // Takes multiple ranges and combines as many of them as possible, while keeping range sizes below the limit.
     static std::vector<CombinedRange> joinRanges(const std::vector<std::vector<std::array<uint8_t,2>>>& holeCardRanges,
                                               size_t maxSize);
 
     // Randomize order of combos (good for random walk simulation).
-    void shuffle();
+    void shuffle(XoroShiro128Plus& rng);
 
     unsigned playerCount() const
     {
@@ -0,0 +1,38 @@
+#include "CompactHandEvaluator.h"
+
+namespace omp {
+
+alignas(64) uint16_t CompactHandEvaluator::RANK_SETS[]{};
+const unsigned CompactHandEvaluator::DROP_MASKS[]{0, RANK_SET_MASK, RANK_SET_MASK | RANK_SET_MASK << 16};
+
+// The colex index of a set {r_0 < r_1 < ... < r_k-1} is sum(binomial(r_i, i + 1)).
+void CompactHandEvaluator::initRankSets()
+{
+    unsigned binom[RANK_COUNT][6]{};
+    for (unsigned n = 0; n < RANK_COUNT; ++n) {
+        binom[n][0] = 1;
+        for (unsigned k = 1; k <= 5 && k <= n; ++k)
+            binom[n][k] = binom[n - 1][k - 1] + binom[n - 1][k];
+    }
+
+    for (unsigned ranks = 0; ranks <= RANK_SET_MASK; ++ranks) {
+        // The ace also plays below the deuce. The highest run of 5 gives the straight (1 = wheel, 10 = broadway).
+        unsigned r = (ranks << 1) | (ranks >> (RANK_COUNT - 1));
+        unsigned runs = r & (r >> 1) & (r >> 2) & (r >> 3) & (r >> 4);
+        if (runs) {
+            RANK_SETS[ranks] = (uint16_t)(STRAIGHT + highestRank(runs) + 1);
+            continue;
+        }
+
+        unsigned best = ranks;
+        while (bitCount(best) > 5)
+            best &= best - 1;
+        unsigned index = 0, count = 0;
+        for (unsigned i = 0; i < RANK_COUNT; ++i)
+            if (best & (1 << i))
+                index += binom[i][++count];
+        RANK_SETS[ranks] = (uint16_t)(count == 5 ? HIGH_CARD + index : index);
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+#ifndef OMP_COMPACT_HAND_EVALUATOR_H
+#define OMP_COMPACT_HAND_EVALUATOR_H
+
+#include "Util.h"
+#include "Constants.h"
+#include "Hand.h"
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+
+namespace omp {
+
+// Alternative to HandEvaluator with a 16kB working set instead of the 200kB perfect hash tables, so that the tables
+// stay in L1 even when the hands come in random order or the cache is shared with other work. Hold'em hands of 5-7
+// cards.
+//
+// The only table is indexed by a 13-bit rank set. Flushes look up the ranks of the flush suit. Other hands count the
+// cards of each rank with bit operations, look up the set of distinct ranks (high card or straight) and build the
+// values of the other categories from the ranks of the pairs, trips and quads and the table index of the kickers.
+//
+// The order of hands and the hand categories are the same as in HandEvaluator, but the values within a category are
+// different, so ranks from the two evaluators must not be compared with each other.
+class CompactHandEvaluator
+{
+public:
+    typedef StandardDeck Deck;
+
+    // Does a thread-safe (guaranteed by C++11) one time initialization of the rank set table.
+    CompactHandEvaluator()
+    {
+        static bool initVar = (initRankSets(), true);
+        (void)initVar;
+    }
+
+    // Returns the rank of a hand as a 16-bit integer. Higher value is better. Hand category can be extracted by
+    // dividing the value by 4096. 1=highcard, 2=pair, etc.
+    template<bool tFlushPossible = true>
+    OMP_FORCE_INLINE uint16_t evaluate(const Hand& hand) const
+    {
+        omp_assert(hand.count() >= 5 && hand.count() <= 7 && hand.count() == bitCount(hand.mask()));
+
+        // A flush can't coexist with quads or a full house in 7 cards, so it is always the best category (after
+        // straight flush).
+        if (tFlushPossible && hand.hasFlush()) {
+            unsigned value = RANK_SETS[hand.flushKey()];
+            return (uint16_t)(value + (value >= STRAIGHT ? STRAIGHT_FLUSH - STRAIGHT : FLUSH - HIGH_CARD));
+        }
+
+        // Count the cards of each rank with bitsliced adders.
+        #if OMP_SSE2
+        unsigned s0 = _mm_extract_epi16(hand.mData, 4), s1 = _mm_extract_epi16(hand.mData, 5); // sse2
+        unsigned s2 = _mm_extract_epi16(hand.mData, 6), s3 = _mm_extract_epi16(hand.mData, 7);
+        #else
+        uint64_t cards = hand.mask();
+        unsigned s0 = cards & RANK_SET_MASK, s1 = (cards >> 16) & RANK_SET_MASK;
+        unsigned s2 = (cards >> 32) & RANK_SET_MASK, s3 = (cards >> 48) & RANK_SET_MASK;
+        #endif
+        unsigned ranks = s0 | s1 | s2 | s3;
+        unsigned lo1 = s0 ^ s1, hi1 = s0 & s1, lo2 = s2 ^ s3, hi2 = s2 & s3;
+        unsigned odd = lo1 ^ lo2, twoOrThree = hi1 ^ hi2 ^ (lo1 & lo2);
+        unsigned pairs = twoOrThree & ~odd, trips = twoOrThree & odd, quads = hi1 & hi2;
+
+        // Only the best 5 cards count, so the lowest kickers of a pair or trips are dropped before their table
+        // lookup. Hands with trips or quads are rare enough for a branch.
+        unsigned highCard = RANK_SETS[ranks]; // Or a straight.
+        unsigned dropMasks = DROP_MASKS[hand.count() - 5];
+        if (trips | quads) {
+            if (quads) {
+                unsigned q = highestRank(quads);
+                return (uint16_t)(FOUR_OF_A_KIND + q * RANK_COUNT + highestRank(ranks ^ (1u << q)));
+            }
+            unsigned t = highestRank(trips), fullHousePairs = (trips ^ (1u << t)) | pairs;
+            if (fullHousePairs)
+                return (uint16_t)(FULL_HOUSE + t * RANK_COUNT + highestRank(fullHousePairs));
+            unsigned value = THREE_OF_A_KIND + t * SUBSETS_OF_2 + RANK_SETS[dropLowest(ranks ^ (1u << t), dropMasks)];
+            return (uint16_t)std::max(value, highCard);
+        }
+
+        // Random hands are split between high card, one pair and two pairs, so these are selected with masks.
+        unsigned p1 = highestRank(pairs), p2 = highestRank(pairs ^ (1u << p1));
+        unsigned value = select(nonZeroMask(pairs & (pairs - 1)),
+                                TWO_PAIR + (p1 * RANK_COUNT + p2) * RANK_COUNT
+                                + highestRank(ranks ^ (1u << p1) ^ (1u << p2)),
+                                PAIR + p1 * SUBSETS_OF_3 + RANK_SETS[dropLowest(ranks ^ (1u << p1), dropMasks)]);
+        value = select(nonZeroMask(pairs), value, highCard);
+        // A straight beats pairs, and a high card value is always below the pairs.
+        value = select(nonZeroMask(highCard >> (HAND_CATEGORY_SHIFT + 2)), highCard, value);
+        return (uint16_t)value;
+    }
+
+    // Evaluates multiple hands. Same interface as HandEvaluator::evaluateBatch().
+    template<bool tFlushPossible = true>
+    OMP_FORCE_INLINE void evaluateBatch(const Hand* hands, uint16_t* ranks, size_t count) const
+    {
+        for (size_t i = 0; i < count; ++i)
+            ranks[i] = evaluate<tFlushPossible>(hands[i]);
+    }
+
+private:
+    static const unsigned RANK_SET_MASK = (1 << RANK_COUNT) - 1;
+    // Number of 2 and 3 card kicker sets (13 choose k).
+    static const unsigned SUBSETS_OF_2 = 78, SUBSETS_OF_3 = 286;
+
+    // Returns the highest rank in a set, or 0 for an empty set.
+    static unsigned highestRank(unsigned ranks)
+    {
+        return 31 ^ countLeadingZeros(ranks | 1);
+    }
+
+    // Returns all ones if x (less than 2^31) is nonzero, otherwise 0. Written with shifts so that the compiler
+    // doesn't turn the selections into branches.
+    static unsigned nonZeroMask(unsigned x)
+    {
+        return (unsigned)((int)(x | (0u - x)) >> 31);
+    }
+
+    // Returns a where mask is set and b elsewhere.
+    static unsigned select(unsigned mask, unsigned a, unsigned b)
+    {
+        return b ^ ((a ^ b) & mask);
+    }
+
+    // Removes the lowest rank of a set once for each of the two masks that is set (see DROP_MASKS).
+    static unsigned dropLowest(unsigned ranks, unsigned dropMasks)
+    {
+        ranks &= ~(ranks & (0u - ranks) & dropMasks);
+        return ranks & ~(ranks & (0u - ranks) & (dropMasks >> 16));
+    }
+
+    // Masks for dropLowest() by the number of cards above 5.
+    static const unsigned DROP_MASKS[3];
+
+    static void initRankSets();
+
+    // Value of each set of ranks. Sets of 5 or more ranks have the high card or straight value of their best 5
+    // ranks. Smaller sets are kickers and have their colexicographic index among the sets of the same size, which
+    // orders them the same way as comparing the ranks from the highest down.
+    static uint16_t RANK_SETS[1 << RANK_COUNT];
+};
+
+}
+
+#endif // OMP_COMPACT_HAND_EVALUATOR_H
@@ -1,6 +1,8 @@
 #ifndef OMP_CONSTANTS_H
 #define OMP_CONSTANTS_H
 
+#include <cstdint>
+
 namespace omp {
 
 static const unsigned MAX_PLAYERS = 6;
@@ -25,6 +27,31 @@ static const unsigned FLUSH = 6 * HAND_CATEGORY_OFFSET;
 static const unsigned FULL_HOUSE = 7 * HAND_CATEGORY_OFFSET;
 static const unsigned FOUR_OF_A_KIND = 8 * HAND_CATEGORY_OFFSET;
 static const unsigned STRAIGHT_FLUSH = 9 * HAND_CATEGORY_OFFSET;
+static const unsigned HAND_CATEGORY_COUNT = 10; // Categories are numbered from 1, index 0 is unused.
+
+// Decks (rule variants) for the evaluator templates. Card indexes are the same in every deck, smaller decks just
+// leave out the lowest ranks. FLUSH and FULL_HOUSE are the hand category offsets of the deck, because their order
+// depends on the rules.
+struct StandardDeck
+{
+    static const uint32_t ID = 0; // Identifies the deck in files.
+    static const unsigned LOWEST_RANK = 0;
+    static const unsigned CARD_COUNT = omp::CARD_COUNT;
+    static const uint64_t UNUSED_CARDS = 0;
+    static const unsigned FLUSH = omp::FLUSH;
+    static const unsigned FULL_HOUSE = omp::FULL_HOUSE;
+};
+
+// Short deck (6+) hold'em: 36 cards from six to ace. A flush beats a full house and A-6-7-8-9 is the lowest straight.
+struct ShortDeck
+{
+    static const uint32_t ID = 1;
+    static const unsigned LOWEST_RANK = 4;
+    static const unsigned CARD_COUNT = omp::CARD_COUNT - LOWEST_RANK * SUIT_COUNT;
+    static const uint64_t UNUSED_CARDS = (1ull << LOWEST_RANK * SUIT_COUNT) - 1;
+    static const unsigned FLUSH = omp::FULL_HOUSE;
+    static const unsigned FULL_HOUSE = omp::FLUSH;
+};
 
 }
 
@@ -5,25 +5,62 @@
 #include <random>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <cmath>
 
+// The precalculated results are shipped with the sources and regenerated by genpreflop, which is built without them.
+#ifndef OMP_PRECALCULATED_RESULTS
+    #define OMP_PRECALCULATED_RESULTS 1
+#endif
+#if OMP_PRECALCULATED_RESULTS
+#include "PrecalculatedResults.hxx"
+#else
 namespace omp {
+static const size_t PRECALCULATED_2PLAYER_COUNT = 0;
+static const uint64_t PRECALCULATED_2PLAYER_RESULTS[1] = {};
+static const uint32_t PRECALCULATED_2PLAYER_CATEGORIES[1] = {};
+}
+#endif
+
+namespace omp {
+
+// Layout of the precalculated results of heads-up preflops without board and dead cards: the entries are sorted by
+// preflop id and packed as id (22 bits) | wins of player 1 (21 bits) | ties (21 bits). The players are in the order
+// of the canonical preflop. Categories 1-9 of both players are in a separate array in the same order.
+static const unsigned PRECALCULATED_ID_BITS = 22, PRECALCULATED_COUNT_BITS = 21;
+static const unsigned PRECALCULATED_CATEGORIES = 2 * (HAND_CATEGORY_COUNT - 1);
+
+// Optimal sorting networks for each player count, as pairs of positions that are compared and swapped in order.
+static const unsigned SORTING_NETWORK_SIZES[MAX_PLAYERS + 1] = {0, 0, 1, 3, 5, 9, 12};
+static const uint8_t SORTING_NETWORKS[MAX_PLAYERS + 1][12][2] = {
+    {}, {}, {{0,1}}, {{1,2}, {0,2}, {0,1}}, {{0,1}, {2,3}, {0,2}, {1,3}, {1,2}},
+    {{0,1}, {3,4}, {2,4}, {2,3}, {0,3}, {0,2}, {1,4}, {1,3}, {1,2}},
+    {{1,2}, {4,5}, {0,2}, {3,5}, {0,1}, {3,4}, {1,4}, {0,3}, {2,5}, {1,3}, {2,4}, {2,3}}};
+static_assert(MAX_PLAYERS == 6, "There must be a sorting network for each player count.");
 
 // Start new calculation and spawn threads.
-bool EquityCalculator::start(const std::vector<CardRange>& handRanges, uint64_t boardCards, uint64_t deadCards,
-                             bool enumerateAll, double stdevTarget, std::function<void(const Results&)> callback,
-                             double updateInterval, unsigned threadCount)
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::start(const std::vector<CardRange>& handRanges, uint64_t boardCards,
+                                              uint64_t deadCards, bool enumerateAll, double stdevTarget,
+                                              std::function<void(const Results&)> callback, double updateInterval,
+                                              unsigned threadCount)
 {
     if (handRanges.size() == 0 || handRanges.size() > MAX_PLAYERS)
         return false;
-    if (bitCount(boardCards) > BOARD_CARDS)
+    if (bitCount(boardCards) > BOARD_CARDS || (boardCards & TEvaluator::Deck::UNUSED_CARDS))
         return false;
+    deadCards |= TEvaluator::Deck::UNUSED_CARDS;
     if (2 * handRanges.size() + bitCount(deadCards) + BOARD_CARDS > CARD_COUNT)
         return false;
 
+    seedRng(enumerateAll);
+
     // Set up card ranges.
     mDeadCards = deadCards;
     mBoardCards = boardCards;
+    mTransformedBoardCards = boardCards;
+    mTransformedDeadCards = deadCards;
+    mFixedSuitTransform = transformFixedCards(&mTransformedBoardCards, &mTransformedDeadCards);
     mOriginalHandRanges = handRanges;
     mHandRanges = removeInvalidCombos(handRanges, mDeadCards | mBoardCards);
     std::vector<CombinedRange> combinedRanges = CombinedRange::joinRanges(mHandRanges, MAX_COMBINED_RANGE_SIZE);
@@ -31,51 +68,88 @@ bool EquityCalculator::start(const std::vector<CardRange>& handRanges, uint64_t
         if (combinedRanges[i].combos().size() == 0)
             return false;
         if (!enumerateAll)
-            combinedRanges[i].shuffle();
+            combinedRanges[i].shuffle(mRng);
         mCombinedRanges[i] = combinedRanges[i];
     }
     mCombinedRangeCount = (unsigned)combinedRanges.size();
+    mCanonicalCombos.clear();
+    mPreflopPrefixes.clear();
+
+    // Choose the enumeration engine. Preflop-major enumeration only goes through one combo of each class of combos of
+    // the first range that the suit symmetries of the ranges make equivalent, and only through the preflops that
+    // don't share cards. The canonical combos are found first, because the cost estimate needs their number.
+    // Heads-up preflops without board and dead cards always use preflop-major enumeration, which takes their results
+    // from the precalculated table instead of enumerating them. Heads-up turn and river calculations always use
+    // board-major enumeration: there are at most 48 boards, and each one is a single sort and sweep of the ranges.
+    bool boardMajor = enumerateAll && mEnumeration == ENUMERATION_BOARD_MAJOR;
+    if (enumerateAll && !boardMajor) {
+        findCanonicalCombos();
+        boardMajor = mEnumeration == ENUMERATION_AUTO && handRanges.size() == 2 && (boardCards | deadCards)
+                && (bitCount(boardCards) >= BOARD_CARDS - 1 || isBoardMajorFaster());
+        if (boardMajor)
+            mCanonicalCombos.clear();
+        else
+            findPreflopPrefixes();
+    }
 
     // Set up simulation settings.
-    mEnumPosition = 0;
-    mBatchSum = mBatchSumSqr = mBatchCount = 0;
-    mResults = Results();
-    mResults.players = (unsigned)handRanges.size();
-    mResults.enumerateAll = enumerateAll;
-    mUpdateResults = mResults;
-    mStdevTarget = stdevTarget;
-    mCallback = callback;
-    mUpdateInterval = updateInterval;
-    mStopped = false;
-    mLastUpdate = std::chrono::high_resolution_clock::now();
+    uint64_t enumSize = boardMajor ? getBoardCombinationCount() : getPreflopCombinationCount();
     if (threadCount == 0)
         threadCount = std::thread::hardware_concurrency();
-    mUnfinishedThreads = threadCount;
-
-    // Start threads.
-    mThreads.clear();
-    for (unsigned i = 0; i < threadCount; ++i) {
-        mThreads.emplace_back([this,enumerateAll]{
-            if (enumerateAll)
-                enumerate();
-            else
-                simulateRandomWalkMonteCarlo();
-        });
+    // Threads get at least one board each, so there's no use for more threads than boards.
+    if (boardMajor)
+        threadCount = (unsigned)std::min<uint64_t>(threadCount, enumSize);
+
+    // Preflop-major enumeration caches the results of each canonical preflop when the postflop tree is big enough.
+    // Entries are keyed by the board and dead cards too, so a persistent cache can be used by any calculation with
+    // the same deck. Other decks have their own files, which also store the deck.
+    if (enumerateAll && !boardMajor && getPostflopCombinationCount() > 500) {
+        typedef typename TEvaluator::Deck Deck;
+        std::string cacheFile = mCacheDirectory.empty() ? std::string() : mCacheDirectory + "/preflop-"
+                + (Deck::ID == ShortDeck::ID ? "short-" : "") + std::to_string(handRanges.size()) + ".cache";
+        if (cacheFile.empty() || !mLookup.open(cacheFile, getCacheValueSize(), mCacheSize, Deck::ID))
+            mLookup.reset((size_t)getPreflopCombinationCount(), getCacheValueSize(), mCacheSize);
     }
 
+    // Start threads. The player count is a template parameter of the simulation so that the loops over players
+    // get unrolled, and the version for the current player count is chosen here once.
+    static const ThreadFunction ENUMERATE_FUNCTIONS[MAX_PLAYERS] = {
+            &BasicEquityCalculator::enumerate<1>, &BasicEquityCalculator::enumerate<2>,
+            &BasicEquityCalculator::enumerate<3>, &BasicEquityCalculator::enumerate<4>,
+            &BasicEquityCalculator::enumerate<5>, &BasicEquityCalculator::enumerate<6>};
+    static const ThreadFunction BOARD_MAJOR_FUNCTIONS[MAX_PLAYERS] = {
+            &BasicEquityCalculator::enumerateBoardMajor<1>, &BasicEquityCalculator::enumerateBoardMajor<2>,
+            &BasicEquityCalculator::enumerateBoardMajor<3>, &BasicEquityCalculator::enumerateBoardMajor<4>,
+            &BasicEquityCalculator::enumerateBoardMajor<5>, &BasicEquityCalculator::enumerateBoardMajor<6>};
+    static const ThreadFunction MONTE_CARLO_FUNCTIONS[MAX_PLAYERS] = {
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<1>,
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<2>,
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<3>,
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<4>,
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<5>,
+            &BasicEquityCalculator::simulateRandomWalkMonteCarlo<6>};
+    static_assert(MAX_PLAYERS == 6, "Thread function tables must have an entry for each player count.");
+    const ThreadFunction* threadFunctions = boardMajor ? BOARD_MAJOR_FUNCTIONS
+            : enumerateAll ? ENUMERATE_FUNCTIONS : MONTE_CARLO_FUNCTIONS;
+    ThreadFunction threadFunction = threadFunctions[handRanges.size() - 1];
+    startThreads((unsigned)handRanges.size(), enumerateAll, enumSize, getPreflopCombinationCount(), stdevTarget,
+                 callback, updateInterval, threadCount,
+                 [this,threadFunction](unsigned i){ (this->*threadFunction)(i); });
+
     // Started successfully.
     return true;
 }
 
 // Regular monte carlo simulation.
-void EquityCalculator::simulateRegularMonteCarlo()
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::simulateRegularMonteCarlo(unsigned threadIdx)
 {
-    unsigned nplayers = (unsigned)mHandRanges.size();
     Hand fixedBoard = getBoardFromBitmask(mBoardCards);
     unsigned remainingCards = BOARD_CARDS - fixedBoard.count();
-    BatchResults stats(nplayers);
+    BatchResults stats(tPlayers);
 
-    Rng rng{std::random_device{}()};
+    Rng rng = getThreadRng(threadIdx);
     FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
     FastUniformIntDistribution<unsigned,21> comboDists[MAX_PLAYERS];
     unsigned combinedRangeCount = mCombinedRangeCount;
@@ -110,18 +184,18 @@ void EquityCalculator::simulateRegularMonteCarlo()
 
         Hand board = fixedBoard;
         randomizeBoard(board, remainingCards, usedCardsMask | mDeadCards | mBoardCards, rng, cardDist);
-        evaluateHands(playerHands, nplayers, board, &stats, 1);
+        evaluateHands<tPlayers>(playerHands, board, &stats, 1);
 
         // Update periodically.
         if ((stats.evalCount & 0xfff) == 0) {
-            updateResults(stats, false);
-            stats = BatchResults(nplayers);
-            if (mStopped)
+            bool stop = updateResults(stats, threadIdx, false);
+            stats = BatchResults(tPlayers);
+            if (stop)
                 break;
         }
     }
 
-    updateResults(stats, true);
+    updateResults(stats, threadIdx, true);
 }
 
 // Monte carlo simulation using a random walk. On each iteration a random player is chosen and the next feasible
@@ -129,14 +203,17 @@ void EquityCalculator::simulateRegularMonteCarlo()
 // visited the preflop combinations can be thought of as a directed k-regular graph. The transition probability
 // matrix P then has k non-zero values on each row and column, and all non-zero elements have value of 1/k.
 // It is easy to see that (1,1,...,1) * P = (1,1,...,1), i.e. (1,1,...,1) is a stable distribution.
-void EquityCalculator::simulateRandomWalkMonteCarlo()
+// When many cards are blocked the board is dealt from a live deck that is updated when a combo changes, instead of
+// using rejection sampling.
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::simulateRandomWalkMonteCarlo(unsigned threadIdx)
 {
-    unsigned nplayers = (unsigned)mHandRanges.size();
     Hand fixedBoard = getBoardFromBitmask(mBoardCards);
     unsigned remainingCards = 5 - fixedBoard.count();
-    BatchResults stats(nplayers);
+    BatchResults stats(tPlayers);
 
-    Rng rng{std::random_device{}()};
+    Rng rng = getThreadRng(threadIdx);
     FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
     FastUniformIntDistribution<unsigned,21> comboDists[MAX_PLAYERS];
     FastUniformIntDistribution<unsigned,16> combinedRangeDist(0, mCombinedRangeCount - 1);
@@ -146,27 +223,39 @@ void EquityCalculator::simulateRandomWalkMonteCarlo()
     uint64_t usedCardsMask;
     Hand playerHands[MAX_PLAYERS];
     unsigned comboIndexes[MAX_PLAYERS];
+    // Keeping the live deck up to date costs about as much as two rejected draws per board, so it's only used when
+    // rejection sampling would reject more, e.g. with short deck or many dead cards.
+    unsigned blockedCards = bitCount(mDeadCards | mBoardCards) + 2 * tPlayers;
+    bool useLiveDeck = remainingCards * blockedCards > 2 * (CARD_COUNT - blockedCards);
+    LiveDeck deck;
 
     // Set initial state.
     if (randomizeHoleCards(usedCardsMask, comboIndexes, playerHands, rng, comboDists)) {
+        if (useLiveDeck)
+            deck.reset(usedCardsMask);
         // Loop until stopped.
         for (;;) {
             // Randomize board and evaluate for current holecards.
             Hand board = fixedBoard;
-            randomizeBoard(board, remainingCards, usedCardsMask, rng, cardDist);
-            evaluateHands(playerHands, nplayers, board, &stats, 1);
+            if (useLiveDeck)
+                dealBoard(board, remainingCards, deck, rng);
+            else
+                randomizeBoard(board, remainingCards, usedCardsMask, rng, cardDist);
+            evaluateHands<tPlayers>(playerHands, board, &stats, 1);
 
             // Update results periodically.
             if ((stats.evalCount & 0xfff) == 0) {
-                updateResults(stats, false);
-                if (mStopped)
+                bool stop = updateResults(stats, threadIdx, false);
+                stats = BatchResults(tPlayers);
+                if (stop)
                     break;
-                stats = BatchResults(nplayers);
                 // Occasionally do a full randomization, because in some rare cases the random walk might
                 // not be able to visit all preflop combinations by changing just one hand at a time.
                 // This shouldn't happen if MAX_COMBINED_RANGE_SIZE is big enough, but extra randomization never hurts.
                 if (!randomizeHoleCards(usedCardsMask, comboIndexes, playerHands, rng, comboDists))
                     break;
+                if (useLiveDeck)
+                    deck.reset(usedCardsMask);
             }
 
             // Choose random player and iterate to next valid combo. If current combo is the only one that is valid
@@ -174,7 +263,8 @@ void EquityCalculator::simulateRandomWalkMonteCarlo()
             unsigned combinedRangeIdx = combinedRangeDist(rng);
             const CombinedRange& combinedRange = mCombinedRanges[combinedRangeIdx];
             unsigned comboIdx = comboIndexes[combinedRangeIdx]; // Caching array accessess for 3% speedup!
-            usedCardsMask -= combinedRange.combos()[comboIdx].cardMask;
+            uint64_t oldMask = combinedRange.combos()[comboIdx].cardMask;
+            usedCardsMask -= oldMask;
             uint64_t mask = 0;
             do {
                 if (comboIdx == 0)
@@ -183,6 +273,8 @@ void EquityCalculator::simulateRandomWalkMonteCarlo()
                 mask = combinedRange.combos()[comboIdx].cardMask;
             } while (mask & usedCardsMask);
             usedCardsMask |= mask;
+            if (useLiveDeck)
+                deck.replace(oldMask & ~mask, mask & ~oldMask);
             for (unsigned i = 0; i < combinedRange.playerCount(); ++i) {
                 unsigned playerIdx = combinedRange.players()[i];
                 playerHands[playerIdx] = combinedRange.combos()[comboIdx].evalHands[i];
@@ -191,12 +283,14 @@ void EquityCalculator::simulateRandomWalkMonteCarlo()
         }
     }
 
-    updateResults(stats, true);
+    updateResults(stats, threadIdx, true);
 }
 
 // Randomize holecards using rejection sampling. Returns false if maximum number of attempts was reached.
-bool EquityCalculator::randomizeHoleCards(uint64_t &usedCardsMask, unsigned* comboIndexes, Hand* playerHands,
-                                          Rng& rng, FastUniformIntDistribution<unsigned,21>* comboDists)
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::randomizeHoleCards(uint64_t &usedCardsMask, unsigned* comboIndexes,
+                                                           Hand* playerHands, Rng& rng,
+                                                           FastUniformIntDistribution<unsigned,21>* comboDists)
 {
     unsigned n = 0;
     for(bool ok = false; !ok && n < 1000; ++n) {
@@ -221,8 +315,9 @@ bool EquityCalculator::randomizeHoleCards(uint64_t &usedCardsMask, unsigned* com
 }
 
 // Naive method of randomizing the board by using rejection sampling.
-void EquityCalculator::randomizeBoard(Hand& board, unsigned remainingCards, uint64_t usedCardsMask,
-                                      Rng& rng, FastUniformIntDistribution<unsigned,16>& cardDist)
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::randomizeBoard(Hand& board, unsigned remainingCards, uint64_t usedCardsMask,
+                                                       Rng& rng, FastUniformIntDistribution<unsigned,16>& cardDist)
 {
     omp_assert(remainingCards + bitCount(usedCardsMask) <= CARD_COUNT && remainingCards <= BOARD_CARDS);
     for(unsigned i = 0; i < remainingCards; ++i) {
@@ -237,56 +332,85 @@ void EquityCalculator::randomizeBoard(Hand& board, unsigned remainingCards, uint
     }
 }
 
-// Evaluates a single showdown with one or more players and stores the result.
-template<bool tFlushPossible>
-void EquityCalculator::evaluateHands(const Hand* playerHands, unsigned nplayers, const Hand& board, BatchResults* stats,
-                                     unsigned weight)
+// Deals the board from a live deck with a partial Fisher-Yates shuffle, so no draws are rejected. The dealt cards
+// are moved to the front of the deck, which doesn't matter because the order of the live cards is arbitrary. Each
+// card uses 16 random bits, which has a similar bias as FastUniformIntDistribution.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::dealBoard(Hand& board, unsigned remainingCards, LiveDeck& deck, Rng& rng)
 {
-    omp_assert(board.count() == BOARD_CARDS);
-    ++stats->evalCount;
-    unsigned bestRank = 0;
-    unsigned winnersMask = 0;
-    for (unsigned i = 0, m = 1; i < nplayers; ++i, m <<= 1) {
-        Hand hand = board + playerHands[i];
-        unsigned rank = mEval.evaluate<tFlushPossible>(hand);
-        if (rank > bestRank) {
-            bestRank = rank;
-            winnersMask = m;
-        } else if (rank == bestRank) {
-            winnersMask |= m;
+    omp_assert(remainingCards <= deck.size && remainingCards <= BOARD_CARDS);
+    uint64_t bits = deck.randomBits;
+    unsigned bitsLeft = deck.randomBitsLeft;
+    for (unsigned i = 0; i < remainingCards; ++i) {
+        if (bitsLeft == 0) {
+            bits = rng();
+            bitsLeft = 4;
         }
+        unsigned j = i + (unsigned)(((bits & 0xffff) * (deck.size - i)) >> 16);
+        bits >>= 16;
+        --bitsLeft;
+        unsigned card = deck.cards[j], other = deck.cards[i];
+        deck.cards[j] = other;
+        deck.positions[other] = j;
+        deck.cards[i] = card;
+        deck.positions[card] = i;
+        board += Hand(card);
     }
+    deck.randomBits = bits;
+    deck.randomBitsLeft = bitsLeft;
+}
 
-    stats->winsByPlayerMask[winnersMask] += weight;
+// Evaluates a single showdown with one or more players and stores the result.
+template<class TEvaluator>
+template<unsigned tPlayers, bool tFlushPossible>
+void BasicEquityCalculator<TEvaluator>::evaluateHands(const Hand* playerHands, const Hand& board,
+                                                      BatchResults* stats, unsigned weight)
+{
+    omp_assert(board.count() == BOARD_CARDS);
+    Hand hands[MAX_PLAYERS];
+    uint16_t ranks[MAX_PLAYERS + SHOWDOWN_PADDING];
+    for (unsigned i = 0; i < tPlayers; ++i)
+        hands[i] = board + playerHands[i];
+    mEval.template evaluateBatch<tFlushPossible>(hands, ranks, tPlayers);
+    addShowdown<tPlayers>(ranks, stats, weight);
 }
 
 // Calculates exact equities by enumerating through all possible combinations.
-void EquityCalculator::enumerate()
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::enumerate(unsigned threadIdx)
 {
     uint64_t enumPosition = 0, enumEnd = 0;
     uint64_t preflopCombos = getPreflopCombinationCount();
-    unsigned nplayers = (unsigned)mHandRanges.size();
-    BatchResults stats(nplayers);
+    bool usePrefixes = !mPreflopPrefixes.empty();
+    size_t prefixIdx = ~(size_t)0;
+    std::vector<uint64_t> live(mLastRangeWords);
+    BatchResults stats(tPlayers);
     UniqueRng64 urng(preflopCombos);
     Hand fixedBoard = getBoardFromBitmask(mBoardCards);
     libdivide::libdivide_u64_t fastDividers[MAX_PLAYERS];
     unsigned combinedRangeCount = mCombinedRangeCount;
-    for (unsigned i = 0; i < combinedRangeCount; ++i)
-        fastDividers[i] = libdivide::libdivide_u64_gen(mCombinedRanges[i].combos().size());
+    // The first digit of the enumeration index is the canonical combo of the first range.
+    size_t rangeSizes[MAX_PLAYERS];
+    for (unsigned i = 0; i < combinedRangeCount; ++i) {
+        rangeSizes[i] = i == 0 ? mCanonicalCombos.size() : mCombinedRanges[i].combos().size();
+        fastDividers[i] = libdivide::libdivide_u64_gen(rangeSizes[i]);
+    }
 
-    // Lookup overhead becomes too much if postflop tree is very small.
+    // Lookup overhead becomes too much if postflop tree is very small. (Must match the condition in start().)
     uint64_t postflopCombos = getPostflopCombinationCount();
     bool useLookup = postflopCombos > 500;
+    uint64_t pendingHands = 0;
 
     // Disable random preflop enumeration order if postflop is too small (bad for caching). It's also makes no sense
     // if all the combos don't fit in the lookup table.
-    bool randomizeOrder = postflopCombos > 10000 && preflopCombos <= 2 * MAX_LOOKUP_SIZE;
+    bool randomizeOrder = postflopCombos > 10000 && preflopCombos <= 2 * mLookup.capacity();
 
     for (;;++enumPosition) {
         // Ask for more work if we don't have any.
         if (enumPosition >= enumEnd) {
             uint64_t batchSize = std::max<uint64_t>(2000000 / postflopCombos, 1);
-            std::tie(enumPosition, enumEnd) = reserveBatch(batchSize);
+            std::tie(enumPosition, enumEnd) = reserveBatch(threadIdx, batchSize);
             if (enumPosition >= enumEnd)
                 break;
         }
@@ -299,97 +423,131 @@ void EquityCalculator::enumerate()
         bool ok = true;
         uint64_t usedCardsMask = mBoardCards | mDeadCards;
         HandWithPlayerIdx playerHands[MAX_PLAYERS];
-        for (unsigned i = 0; i < combinedRangeCount; ++i) {
-            uint64_t quotient = libdivide_u64_do(randomizedEnumPos, &fastDividers[i]);
-            uint64_t remainder = randomizedEnumPos - quotient * mCombinedRanges[i].combos().size();
-            randomizedEnumPos = quotient;
+        unsigned weight = 1;
+        if (usePrefixes) {
+            weight = unrankPreflop(randomizedEnumPos, playerHands, usedCardsMask, prefixIdx, live.data());
+        } else {
+            for (unsigned i = 0; i < combinedRangeCount; ++i) {
+                uint64_t quotient = libdivide_u64_do(randomizedEnumPos, &fastDividers[i]);
+                size_t remainder = (size_t)(randomizedEnumPos - quotient * rangeSizes[i]);
+                randomizedEnumPos = quotient;
+                if (i == 0) {
+                    weight = mCanonicalCombos[remainder].weight;
+                    remainder = mCanonicalCombos[remainder].comboIdx;
+                }
 
-            const CombinedRange::Combo& combo = mCombinedRanges[i].combos()[(size_t)remainder];
-            if (usedCardsMask & combo.cardMask) {
-                ok = false;
-                break;
-            }
-            usedCardsMask |= combo.cardMask;
-            for (unsigned j = 0; j < mCombinedRanges[i].playerCount(); ++j) {
-                unsigned playerIdx = mCombinedRanges[i].players()[j];
-                playerHands[playerIdx].cards = combo.holeCards[j];
-                playerHands[playerIdx].playerIdx = playerIdx;
+                const CombinedRange::Combo& combo = mCombinedRanges[i].combos()[remainder];
+                if (usedCardsMask & combo.cardMask) {
+                    ok = false;
+                    break;
+                }
+                usedCardsMask |= combo.cardMask;
+                for (unsigned j = 0; j < mCombinedRanges[i].playerCount(); ++j) {
+                    unsigned playerIdx = mCombinedRanges[i].players()[j];
+                    playerHands[playerIdx].cards = combo.holeCards[j];
+                    playerHands[playerIdx].playerIdx = playerIdx;
+                }
             }
         }
 
         if(!ok) {
-            ++stats.skippedPreflopCombos; //TODO fix skipcount
+            ++stats.skippedPreflopCombos;
         } else {
             // Transform preflop into canonical form so that suit and player isomoprhism can be detected.
-            uint64_t boardCards = mBoardCards;
-            uint64_t deadCards = mDeadCards;
             if (useLookup) {
                 // Sort players based on their hand.
-                std::sort(playerHands, playerHands + nplayers, [](const HandWithPlayerIdx& lhs,
-                          const HandWithPlayerIdx& rhs){
-                    if (lhs.cards[0] >> 2 != rhs.cards[0] >> 2)
-                        return lhs.cards[0] >> 2 < rhs.cards[0] >> 2;
-                    if (lhs.cards[1] >> 2 != rhs.cards[1] >> 2)
-                        return lhs.cards[1] >> 2 < rhs.cards[1] >> 2;
-                    if ((lhs.cards[0] & 3) != (rhs.cards[0] & 3))
-                        return (lhs.cards[0] & 3) < (rhs.cards[0] & 3);
-                    return (lhs.cards[1] & 3) < (rhs.cards[1] & 3);
-                });
-
-                // Save original player indexes cause we eventually want the results for the original order.
-                for (unsigned i = 0; i < nplayers; ++i)
-                    stats.playerIds[i] = playerHands[i].playerIdx;
-
-                // Suit isomorphism.
-                transformSuits(playerHands, nplayers, &boardCards, &deadCards);
+                sortPlayerHands(playerHands, tPlayers);
+
+                // The results of each preflop are kept separate so that they can be cached. Save original player
+                // indexes cause we eventually want the results for the original order.
+                BatchResults preflopStats(tPlayers);
+                for (unsigned i = 0; i < tPlayers; ++i)
+                    preflopStats.playerIds[i] = playerHands[i].playerIdx;
+
+                // Suit isomorphism. The suits of the board and dead cards are already mapped.
+                transformSuits(playerHands, tPlayers, mFixedSuitTransform);
+                uint64_t boardCards = mTransformedBoardCards, deadCards = mTransformedDeadCards;
                 usedCardsMask = boardCards | deadCards;
-                for (unsigned j = 0; j < nplayers; ++j)
+                for (unsigned j = 0; j < tPlayers; ++j)
                     usedCardsMask |= (1ull << playerHands[j].cards[0]) | (1ull << playerHands[j].cards[1]);
 
                 // Get cached results if this combo has already been calculated.
-                uint64_t preflopId = calculateUniquePreflopId(playerHands, nplayers);
-                if (lookupResults(preflopId, stats)) {
-                    for (unsigned i = 0; i < nplayers; ++i)
-                        stats.playerIds[i] = playerHands[i].playerIdx;
-                    stats.evalCount = 0;
-                    stats.uniquePreflopCombos = 0;
+                uint64_t preflopId = calculateUniquePreflopId(playerHands, tPlayers);
+                PreflopCache::Key key = {preflopId, boardCards, deadCards};
+                if (lookupResults(key, preflopStats)) {
+                    ++stats.cacheHits;
                 } else {
                     // Do full postflop enumeration.
-                    ++stats.uniquePreflopCombos;
+                    ++stats.cacheMisses;
+                    ++preflopStats.uniquePreflopCombos;
                     Hand board = getBoardFromBitmask(boardCards);
-                    enumerateBoard(playerHands, nplayers, board, usedCardsMask, &stats);
-                    storeResults(preflopId, stats);
+                    enumerateBoard<tPlayers>(playerHands, board, usedCardsMask, &preflopStats, 1);
+                    stats.cacheEvictions += storeResults(key, preflopStats);
                 }
+                addPreflopResults<tPlayers>(preflopStats, &stats, weight);
+                pendingHands += weight * postflopCombos;
             } else {
                 ++stats.uniquePreflopCombos;
-                enumerateBoard(playerHands, nplayers, fixedBoard, usedCardsMask, &stats);
+                enumerateBoard<tPlayers>(playerHands, fixedBoard, usedCardsMask, &stats, weight);
             }
         }
 
-        //TODO combine lookup results here so we don't need update so often
-        if (stats.evalCount >= 10000 || stats.skippedPreflopCombos >= 10000 || useLookup) {
-            updateResults(stats, false);
-            stats = BatchResults(nplayers);
+        // Cached results are combined here, so the counters need to be flushed before they can overflow. The next
+        // preflop can have the largest possible weight.
+        if (stats.evalCount >= 10000 || stats.skippedPreflopCombos >= 10000
+                || pendingHands + SUIT_PERMUTATION_COUNT * postflopCombos > UINT32_MAX) {
+            updateResults(stats, threadIdx, false);
+            stats = BatchResults(tPlayers);
+            pendingHands = 0;
             if (mStopped)
                 break;
         }
     }
 
-    updateResults(stats, true);
+    updateResults(stats, threadIdx, true);
+}
+
+// Estimates whether board-major enumeration is faster than preflop-major enumeration for a heads-up calculation with
+// board or dead cards. The costs are in units of ranking one combo on one board, which board-major enumeration does
+// for every live combo of both ranges on every board, with the sort and the sweep included. It also has a cost of
+// about 50 units per board for dealing the board and finding the live combos. Preflop-major enumeration goes through
+// the boards of each canonical preflop that isn't in the cache, but the suit symmetries and the merging of suits that
+// can't make a flush leave only about one board in 8, and a heads-up showdown costs 1.5 units. Each preflop costs
+// another 25 units for the canonicalization and the cache lookup. A preflop and the same one with the players swapped
+// share a cache entry, so the preflops where both hands are in both ranges are only enumerated once per pair.
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::isBoardMajorFaster()
+{
+    std::vector<uint64_t> masks[2];
+    for (unsigned i = 0; i < 2; ++i) {
+        for (auto& combo : mHandRanges[i])
+            masks[i].push_back((1ull << combo[0]) | (1ull << combo[1]));
+        std::sort(masks[i].begin(), masks[i].end());
+    }
+    std::vector<uint64_t> common;
+    std::set_intersection(masks[0].begin(), masks[0].end(), masks[1].begin(), masks[1].end(),
+                          std::back_inserter(common));
+    double sharedFraction = 0.5 * common.size() * common.size() / ((double)masks[0].size() * masks[1].size());
+
+    double boardMajorCost = getBoardCombinationCount() * (50.0 + masks[0].size() + masks[1].size());
+    double preflopCost = (1 - sharedFraction) * getPostflopCombinationCount() / 8 * 1.5 + 25;
+    return boardMajorCost < getPreflopCombinationCount() * preflopCost;
 }
 
 // Starts the postflop enumeration.
-void EquityCalculator::enumerateBoard(const HandWithPlayerIdx* playerHands, unsigned nplayers,
-                                 const Hand& board, uint64_t usedCardsMask, BatchResults* stats)
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::enumerateBoard(const HandWithPlayerIdx* playerHands, const Hand& board,
+                                                       uint64_t usedCardsMask, BatchResults* stats, unsigned weight)
 {
     Hand hands[MAX_PLAYERS];
-    for (unsigned i = 0; i < nplayers; ++i)
+    for (unsigned i = 0; i < tPlayers; ++i)
         hands[i] = Hand(playerHands[i].cards);
 
     // Take a shortcut when no board cards left to iterate.
     unsigned remainingCards = BOARD_CARDS - board.count();
     if (remainingCards == 0) {
-        evaluateHands(hands, nplayers, board, stats, 1);
+        evaluateHands<tPlayers>(hands, board, stats, weight);
         return;
     }
 
@@ -405,7 +563,7 @@ void EquityCalculator::enumerateBoard(const HandWithPlayerIdx* playerHands, unsi
 
     // Calculate the maximum card count for each suit that any player can have after holecards and fixed board cards.
     unsigned suitCounts[SUIT_COUNT] = {};
-    for (unsigned i = 0; i < nplayers; ++i) {
+    for (unsigned i = 0; i < tPlayers; ++i) {
         if ((playerHands[i].cards[0] & 3) == (playerHands[i].cards[1] & 3)) {
             suitCounts[playerHands[i].cards[0] & 3] = std::max(2u, suitCounts[playerHands[i].cards[0] & 3]);
         } else {
@@ -416,21 +574,329 @@ void EquityCalculator::enumerateBoard(const HandWithPlayerIdx* playerHands, unsi
     for (unsigned i = 0; i < SUIT_COUNT; ++i)
         suitCounts[i] += board.suitCount(i);
 
-    enumerateBoardRec(hands, nplayers, stats, board, deck, ndeck, suitCounts, remainingCards, 0, 1);
+    // Before the flop most preflops leave some suits interchangeable (e.g. the two suits that neither AcAd nor KcKd
+    // has), and then only one board of each class of suit permutations needs to be enumerated.
+    if (remainingCards >= 3) {
+        std::array<uint8_t,SUIT_COUNT> perms[SUIT_PERMUTATION_COUNT];
+        uint64_t holeCards = 0;
+        for (unsigned i = 0; i < tPlayers; ++i)
+            holeCards |= (1ull << playerHands[i].cards[0]) | (1ull << playerHands[i].cards[1]);
+        unsigned permCount = getSuitSymmetries(playerHands, tPlayers, usedCardsMask & ~holeCards, perms);
+        if (permCount > 1) {
+            enumerateCanonicalBoards<tPlayers>(hands, stats, board, deck, ndeck, suitCounts, remainingCards, 0,
+                                               weight, perms, permCount);
+            return;
+        }
+    }
+
+    enumerateBoardRec<tPlayers>(hands, stats, board, deck, ndeck, suitCounts, remainingCards, 0, weight);
+}
+
+// Enumerates the boards that are canonical under a group of suit permutations, weighted by the size of their class.
+// The board cards are chosen one rank at a time from the highest rank down. For each rank, only the sets of suits
+// that are the smallest of their class under the current group are used, and the rest of the board is enumerated
+// with the permutations that keep that set of suits unchanged. This is exact because the permutations also map the
+// cards of the higher ranks to themselves, and lower ranks are enumerated in full. Once no permutations are left, or
+// only the turn and river are left, the normal enumeration takes over. Its handling of suits that can't make a flush
+// anymore does better there.
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::enumerateCanonicalBoards(const Hand* playerHands, BatchResults* stats,
+                                                                 const Hand& board, unsigned* deck, unsigned ndeck,
+                                                                 unsigned* suitCounts, unsigned cardsLeft,
+                                                                 unsigned start, unsigned weight,
+                                                                 const std::array<uint8_t,SUIT_COUNT>* perms,
+                                                                 unsigned permCount)
+{
+    if (permCount == 1 || cardsLeft < 3) {
+        enumerateBoardRec<tPlayers>(playerHands, stats, board, deck, ndeck, suitCounts, cardsLeft, start, weight);
+        return;
+    }
+
+    // The canonical sets of suits and the permutations that keep them are the same for every rank, so they're found
+    // first.
+    for (unsigned subset = 1; subset < (1 << SUIT_COUNT); ++subset) {
+        if (bitCount(subset) > cardsLeft)
+            continue;
+        std::array<uint8_t,SUIT_COUNT> stabilizer[SUIT_PERMUTATION_COUNT];
+        unsigned stabilizerCount = 0;
+        bool canonical = true;
+        for (unsigned j = 0; j < permCount && canonical; ++j) {
+            unsigned image = 0;
+            for (unsigned s = 0; s < SUIT_COUNT; ++s)
+                image |= ((subset >> s) & 1) << perms[j][s];
+            canonical = image >= subset;
+            if (image == subset)
+                stabilizer[stabilizerCount++] = perms[j];
+        }
+        if (!canonical)
+            continue;
+        // The size of the class is the number of permutations divided by the number that keep the set.
+        unsigned newWeight = weight * (permCount / stabilizerCount);
+
+        for (unsigned i = start, end; i < ndeck; i = end) {
+            // Cards of the same rank are consecutive in the deck.
+            unsigned rank = deck[i] >> 2, suits = 0;
+            for (end = i; end < ndeck && deck[end] >> 2 == rank; ++end)
+                suits |= 1 << (deck[end] & SUIT_MASK);
+            if (subset & ~suits)
+                continue;
+
+            // Like in enumerateBoardRec(), suits that can't make a flush anymore are not counted.
+            Hand newBoard = board;
+            unsigned counted = 0;
+            for (unsigned s = 0; s < SUIT_COUNT; ++s) {
+                if ((subset >> s) & 1) {
+                    newBoard += 4 * rank + s;
+                    if (suitCounts[s] + cardsLeft >= 5)
+                        counted |= 1 << s;
+                }
+            }
+            for (unsigned s = 0; s < SUIT_COUNT; ++s)
+                suitCounts[s] += (counted >> s) & 1;
+            if (bitCount(subset) == cardsLeft)
+                evaluateHands<tPlayers>(playerHands, newBoard, stats, newWeight);
+            else
+                enumerateCanonicalBoards<tPlayers>(playerHands, stats, newBoard, deck, ndeck, suitCounts,
+                                                   cardsLeft - bitCount(subset), end, newWeight, stabilizer,
+                                                   stabilizerCount);
+            for (unsigned s = 0; s < SUIT_COUNT; ++s)
+                suitCounts[s] -= (counted >> s) & 1;
+        }
+    }
+}
+
+// Finds the suit permutations that map the hole cards of every player and the fixed cards to themselves, so that
+// they don't change the result of any board. Returns their number (at least 1, the identity).
+template<class TEvaluator>
+unsigned BasicEquityCalculator<TEvaluator>::getSuitSymmetries(const HandWithPlayerIdx* playerHands,
+                                                              unsigned nplayers, uint64_t fixedCards,
+                                                              std::array<uint8_t,SUIT_COUNT>* perms)
+{
+    unsigned count = 0;
+    std::array<uint8_t,SUIT_COUNT> perm = {{0, 1, 2, 3}};
+    do {
+        bool ok = permuteSuits(fixedCards, perm) == fixedCards;
+        for (unsigned i = 0; i < nplayers && ok; ++i) {
+            uint64_t hand = (1ull << playerHands[i].cards[0]) | (1ull << playerHands[i].cards[1]);
+            ok = permuteSuits(hand, perm) == hand;
+        }
+        if (ok)
+            perms[count++] = perm;
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    return count;
+}
+
+// Maps every card of suit s to suit perm[s].
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::permuteSuits(uint64_t cards, const std::array<uint8_t,SUIT_COUNT>& perm)
+{
+    static const uint64_t SUIT_0 = 0x1111111111111ull;
+    uint64_t result = 0;
+    for (unsigned s = 0; s < SUIT_COUNT; ++s) {
+        uint64_t suitCards = cards & (SUIT_0 << s);
+        result |= perm[s] >= s ? suitCards << (perm[s] - s) : suitCards >> (s - perm[s]);
+    }
+    return result;
+}
+
+// Finds the combos of the first combined range that are canonical under the suit permutations that don't change the
+// board, the dead cards or the range of any player, and the number of combos that each of them stands for. The
+// canonical combo of a class is the one whose hands, in player order, are the smallest. Any preflop that starts with
+// another combo of the class is mapped by a permutation to a preflop that starts with the canonical one and has the
+// same results, so only those need to be enumerated.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::findCanonicalCombos()
+{
+    std::vector<std::vector<uint64_t>> rangeMasks(mHandRanges.size());
+    for (unsigned i = 0; i < mHandRanges.size(); ++i) {
+        for (auto& combo : mHandRanges[i])
+            rangeMasks[i].push_back((1ull << combo[0]) | (1ull << combo[1]));
+        std::sort(rangeMasks[i].begin(), rangeMasks[i].end());
+    }
+
+    std::array<uint8_t,SUIT_COUNT> perms[SUIT_PERMUTATION_COUNT];
+    unsigned permCount = 0;
+    std::array<uint8_t,SUIT_COUNT> perm = {{0, 1, 2, 3}};
+    do {
+        bool ok = permuteSuits(mBoardCards, perm) == mBoardCards && permuteSuits(mDeadCards, perm) == mDeadCards;
+        for (unsigned i = 0; i < rangeMasks.size() && ok; ++i) {
+            for (size_t j = 0; j < rangeMasks[i].size() && ok; ++j) {
+                uint64_t image = permuteSuits(rangeMasks[i][j], perm);
+                ok = std::binary_search(rangeMasks[i].begin(), rangeMasks[i].end(), image);
+            }
+        }
+        if (ok)
+            perms[permCount++] = perm;
+    } while (std::next_permutation(perm.begin(), perm.end()));
+
+    const CombinedRange& range = mCombinedRanges[0];
+    mCanonicalCombos.clear();
+    for (size_t i = 0; i < range.combos().size(); ++i) {
+        const CombinedRange::Combo& combo = range.combos()[i];
+        unsigned stabilizerCount = 0;
+        bool canonical = true;
+        for (unsigned j = 0; j < permCount && canonical; ++j) {
+            int cmp = 0;
+            for (unsigned k = 0; k < range.playerCount() && cmp == 0; ++k) {
+                uint64_t hand = (1ull << combo.holeCards[k][0]) | (1ull << combo.holeCards[k][1]);
+                uint64_t image = permuteSuits(hand, perms[j]);
+                cmp = image < hand ? -1 : image > hand;
+            }
+            canonical = cmp >= 0;
+            stabilizerCount += cmp == 0;
+        }
+        if (canonical)
+            mCanonicalCombos.push_back({(uint32_t)i, permCount / stabilizerCount});
+    }
+}
+
+// Finds the prefixes of the preflops that don't share cards, so that enumeration indexes map to those preflops only.
+// Nothing is found if there's only one combined range (its combos never share cards) or too many prefixes.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::findPreflopPrefixes()
+{
+    mPreflopPrefixes.clear();
+    if (mCombinedRangeCount < 2)
+        return;
+
+    auto& lastCombos = mCombinedRanges[mCombinedRangeCount - 1].combos();
+    mLastRangeWords = (lastCombos.size() + 63) / 64;
+    mLastRangeCardCombos.assign(CARD_COUNT * mLastRangeWords, 0);
+    for (size_t i = 0; i < lastCombos.size(); ++i) {
+        for (uint64_t mask = lastCombos[i].cardMask; mask; mask &= mask - 1)
+            mLastRangeCardCombos[countTrailingZeros(mask) * mLastRangeWords + i / 64] |= 1ull << (i % 64);
+    }
+
+    PreflopPrefix prefix = {};
+    uint64_t count = 0;
+    std::vector<uint64_t> live(mLastRangeWords);
+    if (!findPreflopPrefixesRec(0, 0, prefix, count, live.data())) {
+        mPreflopPrefixes.clear();
+        return;
+    }
+    prefix.firstIndex = count;
+    mPreflopPrefixes.push_back(prefix);
+}
+
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::findPreflopPrefixesRec(unsigned rangeIdx, uint64_t usedCards,
+                                                               PreflopPrefix& prefix, uint64_t& count, uint64_t* live)
+{
+    if (rangeIdx + 1 == mCombinedRangeCount) {
+        if (mPreflopPrefixes.size() >= MAX_PREFLOP_PREFIXES)
+            return false;
+        uint64_t liveCount = getLiveCombos(usedCards, live);
+        if (liveCount > 0) {
+            prefix.firstIndex = count;
+            mPreflopPrefixes.push_back(prefix);
+            count += liveCount;
+        }
+        return true;
+    }
+
+    const CombinedRange& range = mCombinedRanges[rangeIdx];
+    size_t size = rangeIdx == 0 ? mCanonicalCombos.size() : range.combos().size();
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t mask = range.combos()[rangeIdx == 0 ? mCanonicalCombos[i].comboIdx : i].cardMask;
+        if (usedCards & mask)
+            continue;
+        prefix.comboIdxs[rangeIdx] = (uint32_t)i;
+        if (!findPreflopPrefixesRec(rangeIdx + 1, usedCards | mask, prefix, count, live))
+            return false;
+    }
+    return true;
+}
+
+// Sets the bitset of the combos of the last combined range that don't share cards with usedCards and returns their
+// number.
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::getLiveCombos(uint64_t usedCards, uint64_t* live) const
+{
+    std::fill(live, live + mLastRangeWords, 0);
+    for (uint64_t mask = usedCards; mask; mask &= mask - 1) {
+        const uint64_t* cardCombos = &mLastRangeCardCombos[countTrailingZeros(mask) * mLastRangeWords];
+        for (size_t i = 0; i < mLastRangeWords; ++i)
+            live[i] |= cardCombos[i];
+    }
+    size_t size = mCombinedRanges[mCombinedRangeCount - 1].combos().size();
+    uint64_t count = 0;
+    for (size_t i = 0; i < mLastRangeWords; ++i) {
+        live[i] = ~live[i];
+        if (i == size / 64)
+            live[i] &= (1ull << (size % 64)) - 1;
+        count += bitCount(live[i]);
+    }
+    return count;
+}
+
+// Maps an index of the enumeration of preflops that don't share cards to the hands of the players, adds their cards
+// to usedCards and returns the weight of the preflop. Consecutive indexes usually have the same prefix, so the live
+// combos of the last range are kept in live for the prefix prefixIdx, and only found again when the prefix changes.
+template<class TEvaluator>
+unsigned BasicEquityCalculator<TEvaluator>::unrankPreflop(uint64_t idx, HandWithPlayerIdx* playerHands,
+                                                          uint64_t& usedCards, size_t& prefixIdx,
+                                                          uint64_t* live) const
+{
+    if (prefixIdx >= mPreflopPrefixes.size() - 1 || idx < mPreflopPrefixes[prefixIdx].firstIndex
+            || idx >= mPreflopPrefixes[prefixIdx + 1].firstIndex) {
+        prefixIdx = std::upper_bound(mPreflopPrefixes.begin(), mPreflopPrefixes.end(), idx,
+                                     [](uint64_t i, const PreflopPrefix& p){ return i < p.firstIndex; })
+                    - mPreflopPrefixes.begin() - 1;
+        uint64_t prefixCards = 0;
+        for (unsigned i = 0; i + 1 < mCombinedRangeCount; ++i) {
+            uint32_t comboIdx = mPreflopPrefixes[prefixIdx].comboIdxs[i];
+            if (i == 0)
+                comboIdx = mCanonicalCombos[comboIdx].comboIdx;
+            prefixCards |= mCombinedRanges[i].combos()[comboIdx].cardMask;
+        }
+        getLiveCombos(prefixCards, live);
+    }
+
+    // Select the live combo of the last range by its rank among the live combos.
+    uint64_t rank = idx - mPreflopPrefixes[prefixIdx].firstIndex;
+    size_t word = 0;
+    for (; rank >= bitCount(live[word]); ++word)
+        rank -= bitCount(live[word]);
+    uint64_t bits = live[word];
+    for (; rank > 0; --rank)
+        bits &= bits - 1;
+
+    const PreflopPrefix& prefix = mPreflopPrefixes[prefixIdx];
+    for (unsigned i = 0; i < mCombinedRangeCount; ++i) {
+        size_t comboIdx = i + 1 == mCombinedRangeCount ? word * 64 + countTrailingZeros(bits)
+                : i == 0 ? mCanonicalCombos[prefix.comboIdxs[0]].comboIdx : prefix.comboIdxs[i];
+        const CombinedRange::Combo& combo = mCombinedRanges[i].combos()[comboIdx];
+        usedCards |= combo.cardMask;
+        for (unsigned j = 0; j < mCombinedRanges[i].playerCount(); ++j) {
+            unsigned playerIdx = mCombinedRanges[i].players()[j];
+            playerHands[playerIdx].cards = combo.holeCards[j];
+            playerHands[playerIdx].playerIdx = playerIdx;
+        }
+    }
+    return mCanonicalCombos[prefix.comboIdxs[0]].weight;
 }
 
 // Enumerates board cards recursively. Detects some isomorphic subtrees by looking at the number of cards for
 // each suit. Suits that cannot create a flush anymore (called here "irrelevant suits") are handled at the same time,
 // which gives roughly a speedup of 3x.
-void EquityCalculator::enumerateBoardRec(const Hand* playerHands, unsigned nplayers, BatchResults* stats,
-                                const Hand& board, unsigned* deck, unsigned ndeck, unsigned* suitCounts,
-                                unsigned cardsLeft, unsigned start, unsigned weight)
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::enumerateBoardRec(const Hand* playerHands, BatchResults* stats,
+                                                          const Hand& board, unsigned* deck, unsigned ndeck,
+                                                          unsigned* suitCounts, unsigned cardsLeft, unsigned start,
+                                                          unsigned weight)
 {
     // More efficient version for the innermost loop.
     if (cardsLeft == 1)
     {
-        // Even simpler version for non-flush rivers.
+        // Even simpler version for non-flush rivers. Only the river rank matters, so all the showdowns (at most
+        // one per rank) are collected first and then evaluated with a single batch call.
         if (suitCounts[0] < 4 && suitCounts[1] < 4 && suitCounts[2] < 4 && suitCounts[3] < 4) {
+            Hand hands[RANK_COUNT * MAX_PLAYERS];
+            uint16_t ranks[RANK_COUNT * MAX_PLAYERS + SHOWDOWN_PADDING];
+            unsigned multipliers[RANK_COUNT];
+            unsigned nboards = 0;
             for (unsigned i = start; i < ndeck; ) {
                 unsigned multiplier = 1;
 
@@ -441,8 +907,14 @@ void EquityCalculator::enumerateBoardRec(const Hand* playerHands, unsigned nplay
                 for (++i; i < ndeck && deck[i] >> 2 == rank; ++i)
                     ++multiplier;
 
-                evaluateHands<false>(playerHands, nplayers, newBoard, stats, multiplier * weight);
+                for (unsigned j = 0; j < tPlayers; ++j)
+                    hands[nboards * tPlayers + j] = newBoard + playerHands[j];
+                multipliers[nboards++] = multiplier;
             }
+
+            mEval.template evaluateBatch<false>(hands, ranks, nboards * tPlayers);
+            for (unsigned i = 0; i < nboards; ++i)
+                addShowdown<tPlayers>(ranks + i * tPlayers, stats, multipliers[i] * weight);
         } else {
             unsigned lastRank = ~0;
             for (unsigned i = start; i < ndeck; ++i) {
@@ -462,7 +934,7 @@ void EquityCalculator::enumerateBoardRec(const Hand* playerHands, unsigned nplay
                 }
 
                 Hand newBoard = board + deck[i];
-                evaluateHands(playerHands, nplayers, newBoard, stats, multiplier * weight);
+                evaluateHands<tPlayers>(playerHands, newBoard, stats, multiplier * weight);
             }
         }
         return;
@@ -496,120 +968,486 @@ void EquityCalculator::enumerateBoardRec(const Hand* playerHands, unsigned nplay
                 unsigned newWeight = BINOM_COEFF[irrelevantCount][repeats] * weight;
                 newBoard += deck[i + repeats - 1];
                 if (repeats == cardsLeft)
-                    evaluateHands(playerHands, nplayers, newBoard, stats, newWeight);
+                    evaluateHands<tPlayers>(playerHands, newBoard, stats, newWeight);
                 else
-                    enumerateBoardRec(playerHands, nplayers, stats, newBoard, deck, ndeck, suitCounts,
-                                  cardsLeft - repeats, i + irrelevantCount, newWeight);
+                    enumerateBoardRec<tPlayers>(playerHands, stats, newBoard, deck, ndeck, suitCounts,
+                                                cardsLeft - repeats, i + irrelevantCount, newWeight);
             }
 
             i += irrelevantCount - 1;
         } else {
             newBoard += deck[i];
             ++suitCounts[suit];
-            enumerateBoardRec(playerHands, nplayers, stats, newBoard, deck, ndeck, suitCounts,
-                              cardsLeft - 1, i + 1, weight);
+            enumerateBoardRec<tPlayers>(playerHands, stats, newBoard, deck, ndeck, suitCounts,
+                                        cardsLeft - 1, i + 1, weight);
             --suitCounts[suit];
         }
     }
 }
 
-// Lookup cached results for particular preflop.
-bool EquityCalculator::lookupResults(uint64_t preflopId, BatchResults& results)
+// Exact enumeration that loops over the boards instead of the preflop combinations. Each live combo of each range is
+// ranked once per board and all the preflop combinations of the board are then tallied from those ranks, so the
+// number of evaluations is boards * (sum of range sizes) instead of preflops * boards * players. The boards are
+// dealt from all the cards that aren't dead or on the board, and combos that conflict with the board are skipped.
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::enumerateBoardMajor(unsigned threadIdx)
 {
-    if (!mDeadCards && !mBoardCards && lookupPrecalculatedResults(preflopId, results))
-        return true;
+    BatchResults stats(tPlayers);
+    BoardMajorRange ranges[tPlayers];
+    unsigned totalCombos = 0;
+    for (unsigned i = 0; i < tPlayers; ++i) {
+        for (auto& combo : mHandRanges[i]) {
+            ranges[i].holeCards.push_back(Hand(combo));
+            ranges[i].cardMasks.push_back((1ull << combo[0]) | (1ull << combo[1]));
+        }
+        totalCombos += (unsigned)mHandRanges[i].size();
+    }
+    if (tPlayers == 2) {
+        for (unsigned i = 0; i < 2; ++i) {
+            std::vector<uint64_t> opponentMasks = ranges[1 - i].cardMasks;
+            std::sort(opponentMasks.begin(), opponentMasks.end());
+            for (uint64_t mask : ranges[i].cardMasks)
+                ranges[i].inOtherRange.push_back(std::binary_search(opponentMasks.begin(), opponentMasks.end(), mask));
+        }
+    }
+
+    unsigned deck[CARD_COUNT];
+    unsigned ndeck = 0;
+    for (unsigned c = 0; c < CARD_COUNT; ++c) {
+        if (!((mBoardCards | mDeadCards) & (1ull << c)))
+            deck[ndeck++] = c;
+    }
+    unsigned remainingCards = BOARD_CARDS - bitCount(mBoardCards);
+    Hand fixedBoard = getBoardFromBitmask(mBoardCards);
+
+    std::vector<Hand> hands(totalCombos);
+    std::vector<uint16_t> ranks(totalCombos + SHOWDOWN_PADDING);
+    std::vector<uint32_t> sortBuffer(2 * totalCombos);
+    uint64_t batchSize = std::max<uint64_t>(100000 / totalCombos, 1);
+    uint64_t pendingHands = 0, rankedHands = 0;
+    unsigned positions[BOARD_CARDS];
+
+    for (uint64_t boardIdx = 0, boardEnd = 0;; ++boardIdx) {
+        if (boardIdx >= boardEnd) {
+            std::tie(boardIdx, boardEnd) = reserveBatch(threadIdx, batchSize);
+            if (boardIdx >= boardEnd)
+                break;
+            // Boards are numbered in colexicographic order of their deck positions. Find the positions of the first
+            // board of the batch, the following ones are found by incrementing.
+            uint64_t idx = boardIdx;
+            for (unsigned k = remainingCards, c = ndeck; k > 0; --k) {
+                do {
+                    --c;
+                } while (binomial(c, k) > idx);
+                positions[k - 1] = c;
+                idx -= binomial(c, k);
+            }
+        } else {
+            unsigned k = 0;
+            while (k + 1 < remainingCards && positions[k] + 1 == positions[k + 1])
+                ++k;
+            ++positions[k];
+            for (unsigned j = 0; j < k; ++j)
+                positions[j] = j;
+        }
+
+        Hand board = fixedBoard;
+        uint64_t boardMask = mBoardCards;
+        for (unsigned k = 0; k < remainingCards; ++k) {
+            board += deck[positions[k]];
+            boardMask |= 1ull << deck[positions[k]];
+        }
+
+        // Rank the live combos of all players with a single batch call.
+        unsigned count = 0;
+        for (unsigned i = 0; i < tPlayers; ++i) {
+            BoardMajorRange& range = ranges[i];
+            range.live.clear();
+            range.firstRank = count;
+            for (unsigned j = 0; j < range.cardMasks.size(); ++j) {
+                if (!(range.cardMasks[j] & boardMask)) {
+                    range.live.push_back(j);
+                    hands[count++] = board + range.holeCards[j];
+                }
+            }
+        }
+        bool flushPossible = false;
+        for (unsigned suit = 0; suit < SUIT_COUNT; ++suit)
+            flushPossible |= board.suitCount(suit) >= 3;
+        if (flushPossible)
+            mEval.template evaluateBatch<true>(hands.data(), ranks.data(), count);
+        else
+            mEval.template evaluateBatch<false>(hands.data(), ranks.data(), count);
+        // Evaluations are counted as showdowns like in preflop-major enumeration, i.e. tPlayers ranked combos each.
+        rankedHands += count;
+        stats.evalCount += rankedHands / tPlayers;
+        rankedHands %= tPlayers;
+
+        // Upper bounds for the number of preflops formed by the players from each index onwards. Saturated at 2^32,
+        // which is already too much for the counters of one batch.
+        uint64_t bounds[tPlayers + 1];
+        bounds[tPlayers] = 1;
+        for (unsigned i = tPlayers; i-- > 0;)
+            bounds[i] = std::min<uint64_t>(bounds[i + 1] * ranges[i].live.size(), 1ull << 32);
+
+        if (tPlayers == 2) {
+            if (pendingHands + bounds[0] > UINT32_MAX) {
+                updateResults(stats, threadIdx, false);
+                stats = BatchResults(tPlayers);
+                pendingHands = 0;
+            }
+            pendingHands += bounds[0];
+            tallyHeadsUp(ranges, ranks.data(), sortBuffer.data(), &stats);
+        } else {
+            uint16_t showdownRanks[MAX_PLAYERS + SHOWDOWN_PADDING] = {};
+            tallyBoardRec<tPlayers>(ranges, ranks.data(), bounds, 0, boardMask, showdownRanks, pendingHands, &stats,
+                                    threadIdx);
+        }
+
+        if (stats.evalCount * tPlayers >= 10000) {
+            updateResults(stats, threadIdx, false);
+            stats = BatchResults(tPlayers);
+            pendingHands = 0;
+            if (mStopped)
+                break;
+        }
+    }
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    auto it = mLookup.find(preflopId);
-    if (it != mLookup.end())
-        results = it->second;
-    return it != mLookup.end();
+    updateResults(stats, threadIdx, true);
 }
 
-// Lookup precalculated results.
-bool EquityCalculator::lookupPrecalculatedResults(uint64_t preflopId, BatchResults& results) const
+// Tallies all heads-up preflops of a board from the ranks of the live combos. The combos of the first player are
+// swept in rank order while counting the opponent's combos that rank below and at most as high as the current one,
+// both in total and by card. Combos that share a card with the current one are then removed from the counts by
+// inclusion-exclusion. Only the same combo can share both cards, and it always has the same rank.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::tallyHeadsUp(const BoardMajorRange* ranges, const uint16_t* ranks,
+                                                     uint32_t* sortBuffer, BatchResults* stats) const
 {
-    struct Cmp
-    {
-        // Need two overloads because of the asymmetry.
-        bool operator()(uint32_t preflopId, uint64_t a) { return preflopId < (a & 0x3fffff); }
-        bool operator()(uint64_t a, uint32_t preflopId) { return (a & 0x1fffff) < preflopId; }
-    };
+    const BoardMajorRange& a = ranges[0];
+    const BoardMajorRange& b = ranges[1];
+    unsigned na = (unsigned)a.live.size(), nb = (unsigned)b.live.size();
+    uint32_t* keysA = sortBuffer;
+    uint32_t* keysB = sortBuffer + na;
+    unsigned cardsA[CARD_COUNT] = {}, cardsB[CARD_COUNT] = {};
+    for (unsigned i = 0; i < na; ++i) {
+        keysA[i] = (uint32_t)ranks[a.firstRank + i] << 16 | i;
+        const std::array<uint8_t,2>& cards = mHandRanges[0][a.live[i]];
+        ++cardsA[cards[0]];
+        ++cardsA[cards[1]];
+    }
+    for (unsigned i = 0; i < nb; ++i) {
+        keysB[i] = (uint32_t)ranks[b.firstRank + i] << 16 | i;
+        const std::array<uint8_t,2>& cards = mHandRanges[1][b.live[i]];
+        ++cardsB[cards[0]];
+        ++cardsB[cards[1]];
+    }
+    // The sort buffer has room for the scratch space after the keys of both players.
+    uint32_t* scratch = sortBuffer + na + nb;
+    sortByRank(keysA, scratch, na);
+    sortByRank(keysB, scratch, nb);
+
+    uint64_t wins = 0, ties = 0, losses = 0;
+    unsigned below = 0, belowOrEqual = 0;
+    unsigned cardsBelow[CARD_COUNT] = {}, cardsBelowOrEqual[CARD_COUNT] = {};
+    for (unsigned i = 0, j = 0, k = 0; i < na; ++i) {
+        unsigned rank = keysA[i] >> 16;
+        for (; j < nb && keysB[j] >> 16 < rank; ++j, ++below) {
+            const std::array<uint8_t,2>& cards = mHandRanges[1][b.live[keysB[j] & 0xffff]];
+            ++cardsBelow[cards[0]];
+            ++cardsBelow[cards[1]];
+        }
+        for (; k < nb && keysB[k] >> 16 <= rank; ++k, ++belowOrEqual) {
+            const std::array<uint8_t,2>& cards = mHandRanges[1][b.live[keysB[k] & 0xffff]];
+            ++cardsBelowOrEqual[cards[0]];
+            ++cardsBelowOrEqual[cards[1]];
+        }
 
-    // Binary search.
-    auto it = std::lower_bound(PRECALCULATED_2PLAYER_RESULTS.begin(), PRECALCULATED_2PLAYER_RESULTS.end(),
-                               (uint32_t)preflopId, Cmp());
-    if (it == PRECALCULATED_2PLAYER_RESULTS.end() || (*it & 0x3fffff) != preflopId)
-        return false;
+        unsigned combo = a.live[keysA[i] & 0xffff];
+        const std::array<uint8_t,2>& cards = mHandRanges[0][combo];
+        unsigned same = a.inOtherRange[combo];
+        unsigned opponents = nb - cardsB[cards[0]] - cardsB[cards[1]] + same;
+        unsigned comboWins = below - cardsBelow[cards[0]] - cardsBelow[cards[1]];
+        unsigned comboTies = belowOrEqual - cardsBelowOrEqual[cards[0]] - cardsBelowOrEqual[cards[1]] + same
+                - comboWins;
+        wins += comboWins;
+        ties += comboTies;
+        losses += opponents - comboWins - comboTies;
+        stats->handCategories[0][rank >> HAND_CATEGORY_SHIFT] += opponents;
+    }
 
-    // Unpack results.
-    results.winsByPlayerMask[1] = (*it >> 22) & 0x1fffff;
-    results.winsByPlayerMask[3] = (*it >> 43) & 0x1fffff;
-    results.winsByPlayerMask[2] = 1712304 - results.winsByPlayerMask[1] - results.winsByPlayerMask[3];
+    for (unsigned i = 0; i < nb; ++i) {
+        unsigned combo = b.live[i];
+        const std::array<uint8_t,2>& cards = mHandRanges[1][combo];
+        unsigned opponents = na - cardsA[cards[0]] - cardsA[cards[1]] + b.inOtherRange[combo];
+        stats->handCategories[1][ranks[b.firstRank + i] >> HAND_CATEGORY_SHIFT] += opponents;
+    }
 
-    return true;
+    stats->winsByPlayerMask[1] += (unsigned)wins;
+    stats->winsByPlayerMask[2] += (unsigned)losses;
+    stats->winsByPlayerMask[3] += (unsigned)ties;
 }
 
-// Store results for one preflop in the lookup table.
-void EquityCalculator::storeResults(uint64_t preflopId, const BatchResults& results)
+// Tallies the preflops of a board with 1 or 3+ players by going through all combinations of live combos that don't
+// share cards. bounds[i] is an upper bound for the number of preflops formed by players i and up.
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::tallyBoardRec(const BoardMajorRange* ranges, const uint16_t* ranks,
+                                                      const uint64_t* bounds, unsigned player,
+                                                      uint64_t usedCardsMask, uint16_t* showdownRanks,
+                                                      uint64_t& pendingHands, BatchResults* stats,
+                                                      unsigned threadIdx)
 {
-    std::lock_guard<std::mutex> lock(mMutex); //TODO read-write lock
-    mLookup.emplace(preflopId, results);
-    // Make sure the hash map doesn't eat all memory. Not a great way of doing it but the lookup
-    // table is quite useless with that many preflop combos anyway.
-    if (mLookup.size() >= MAX_LOOKUP_SIZE)
-        mLookup.clear();
+    // Flush the results before the counters can overflow. The check is done on the highest level where the number
+    // of preflops below fits in the counters.
+    if (bounds[player] <= UINT32_MAX && (player == 0 || bounds[player - 1] > UINT32_MAX)) {
+        if (pendingHands + bounds[player] > UINT32_MAX) {
+            updateResults(*stats, threadIdx, false);
+            *stats = BatchResults(tPlayers);
+            pendingHands = 0;
+        }
+        pendingHands += bounds[player];
+    }
+
+    const BoardMajorRange& range = ranges[player];
+    for (unsigned i = 0; i < range.live.size(); ++i) {
+        uint64_t mask = range.cardMasks[range.live[i]];
+        if (mask & usedCardsMask)
+            continue;
+        showdownRanks[player] = ranks[range.firstRank + i];
+        if (player + 1 == tPlayers) {
+            ++stats->winsByPlayerMask[getWinners<tPlayers>(showdownRanks)];
+            for (unsigned j = 0; j < tPlayers; ++j)
+                ++stats->handCategories[j][showdownRanks[j] >> HAND_CATEGORY_SHIFT];
+        } else {
+            tallyBoardRec<tPlayers>(ranges, ranks, bounds, player + 1, usedCardsMask | mask, showdownRanks,
+                                    pendingHands, stats, threadIdx);
+        }
+    }
+}
+
+// Sorts keys by their upper 16 bits with a two pass radix sort. The buffer must have room for count keys.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::sortByRank(uint32_t* keys, uint32_t* buffer, unsigned count)
+{
+    uint32_t* src = keys;
+    uint32_t* dst = buffer;
+    for (unsigned shift = 16; shift < 32; shift += 8) {
+        unsigned offsets[257] = {};
+        for (unsigned i = 0; i < count; ++i)
+            ++offsets[((src[i] >> shift) & 0xff) + 1];
+        for (unsigned i = 1; i < 257; ++i)
+            offsets[i] += offsets[i - 1];
+        for (unsigned i = 0; i < count; ++i)
+            dst[offsets[(src[i] >> shift) & 0xff]++] = src[i];
+        std::swap(src, dst);
+    }
 }
 
-// Transforms suits in such way that suit isomorphism can be easily detected. Goes through all the holecards, board
-// cards and dead cards. First encountered suit is mapped to "virtual" suit 0, second suit maps to 1 and so on.
-unsigned EquityCalculator::transformSuits(HandWithPlayerIdx* playerHands, unsigned nplayers,
-                                          uint64_t* boardCards, uint64_t* deadCards)
+// Adds the results of a single preflop, where the players have been sorted for the lookup, to results that are in
+// the original player order. The weight is the number of preflops that the preflop stands for.
+template<class TEvaluator>
+template<unsigned tPlayers>
+void BasicEquityCalculator<TEvaluator>::addPreflopResults(const BatchResults& preflopStats, BatchResults* stats,
+                                                          unsigned weight)
 {
-    unsigned transform[SUIT_COUNT] = {~0u, ~0u, ~0u, ~0u};
-    unsigned suitCount = 0;
+    for (unsigned i = 1; i < (1u << tPlayers); ++i) {
+        unsigned actualPlayerMask = 0;
+        for (unsigned j = 0; j < tPlayers; ++j) {
+            if (i & (1 << j))
+                actualPlayerMask |= 1 << preflopStats.playerIds[j];
+        }
+        stats->winsByPlayerMask[actualPlayerMask] += weight * preflopStats.winsByPlayerMask[i];
+    }
+    for (unsigned i = 0; i < tPlayers; ++i) {
+        for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+            stats->handCategories[preflopStats.playerIds[i]][j] += weight * preflopStats.handCategories[i][j];
+    }
+    stats->evalCount += preflopStats.evalCount;
+    stats->uniquePreflopCombos += preflopStats.uniquePreflopCombos;
+}
 
-    //TODO transform fixed cards before main enumeration loop.
+// Lookup cached results for particular preflop. Doesn't take any locks. Only the counters are set, so results must
+// not contain anything else.
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::lookupResults(const PreflopCache::Key& key, BatchResults& results)
+{
+    if (!mDeadCards && !mBoardCards && lookupPrecalculatedResults(key.preflop, results))
+        return true;
 
-    uint64_t newBoardCards = 0;
-    for (unsigned i = 0; i < CARD_COUNT; ++i) {
-        if ((*boardCards >> i) & 1) {
-            unsigned suit = i & SUIT_MASK;
-            if (transform[suit] == ~0u)
-                transform[suit] = suitCount++;
-            unsigned newCard = (i & RANK_MASK) | transform[suit];
-            newBoardCards |= 1ull << newCard;
+    uint32_t values[(1 << MAX_PLAYERS) - 1 + MAX_PLAYERS * HAND_CATEGORY_COUNT];
+    if (!mLookup.lookup(key, values))
+        return false;
+    unsigned nplayers = (unsigned)mHandRanges.size();
+    const uint32_t* v = values;
+    for (unsigned i = 1; i < (1u << nplayers); ++i)
+        results.winsByPlayerMask[i] = *v++;
+    for (unsigned i = 0; i < nplayers; ++i) {
+        for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+            results.handCategories[i][j] = *v++;
+    }
+    return true;
+}
+
+// Lookup precalculated results: the built-in table for heads-up and the database for other player counts.
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::lookupPrecalculatedResults(uint64_t preflopId, BatchResults& results) const
+{
+    static const uint64_t ID_MASK = (1ull << PRECALCULATED_ID_BITS) - 1;
+    static const uint64_t COUNT_MASK = (1ull << PRECALCULATED_COUNT_BITS) - 1;
+    unsigned nplayers = (unsigned)mHandRanges.size();
+    if (nplayers != 2) {
+        uint32_t values[(1 << MAX_PLAYERS) - 1 + MAX_PLAYERS * (HAND_CATEGORY_COUNT - 1)];
+        if (mDatabase.players() != nplayers || !mDatabase.lookup(preflopId, values))
+            return false;
+        const uint32_t* v = values;
+        for (unsigned i = 1; i < (1u << nplayers); ++i)
+            results.winsByPlayerMask[i] = *v++;
+        for (unsigned i = 0; i < nplayers; ++i) {
+            results.handCategories[i][0] = 0;
+            for (unsigned j = 1; j < HAND_CATEGORY_COUNT; ++j)
+                results.handCategories[i][j] = *v++;
         }
+        return true;
     }
-    *boardCards = newBoardCards;
 
-    uint64_t newDeadCards = 0;
-    for (unsigned i = 0; i < CARD_COUNT; ++i) {
-        if ((*deadCards >> i) & 1) {
-            unsigned suit = i & SUIT_MASK;
-            if (transform[suit] == ~0u)
-                transform[suit] = suitCount++;
-            unsigned newCard = (i & RANK_MASK) | transform[suit];
-            newDeadCards |= 1ull << newCard;
+    // Binary search.
+    const uint64_t* end = PRECALCULATED_2PLAYER_RESULTS + PRECALCULATED_2PLAYER_COUNT;
+    const uint64_t* it = std::lower_bound(PRECALCULATED_2PLAYER_RESULTS, end, preflopId,
+                                          [](uint64_t a, uint64_t id){ return (a & ID_MASK) < id; });
+    if (it == end || (*it & ID_MASK) != preflopId)
+        return false;
+
+    // Unpack results. Every board is counted once, so the losses of player 1 are the rest of the boards.
+    results.winsByPlayerMask[1] = (*it >> PRECALCULATED_ID_BITS) & COUNT_MASK;
+    results.winsByPlayerMask[3] = (*it >> (PRECALCULATED_ID_BITS + PRECALCULATED_COUNT_BITS)) & COUNT_MASK;
+    results.winsByPlayerMask[2] = (unsigned)binomial(CARD_COUNT - 4, BOARD_CARDS) - results.winsByPlayerMask[1]
+            - results.winsByPlayerMask[3];
+    const uint32_t* categories = PRECALCULATED_2PLAYER_CATEGORIES
+            + (it - PRECALCULATED_2PLAYER_RESULTS) * PRECALCULATED_CATEGORIES;
+    for (unsigned i = 0; i < 2; ++i) {
+        results.handCategories[i][0] = 0;
+        for (unsigned j = 1; j < HAND_CATEGORY_COUNT; ++j)
+            results.handCategories[i][j] = *categories++;
+    }
+
+    return true;
+}
+
+// Store results for one preflop in the lookup table. Only the counters for the current player count are stored.
+// Returns true if another preflop was evicted.
+template<class TEvaluator>
+bool BasicEquityCalculator<TEvaluator>::storeResults(const PreflopCache::Key& key, const BatchResults& results)
+{
+    uint32_t values[(1 << MAX_PLAYERS) - 1 + MAX_PLAYERS * HAND_CATEGORY_COUNT];
+    unsigned nplayers = (unsigned)mHandRanges.size();
+    uint32_t* v = values;
+    for (unsigned i = 1; i < (1u << nplayers); ++i)
+        *v++ = results.winsByPlayerMask[i];
+    for (unsigned i = 0; i < nplayers; ++i) {
+        for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+            *v++ = results.handCategories[i][j];
+    }
+    return mLookup.store(key, values);
+}
+
+// Number of counters in a cache entry: wins for each nonempty combination of winners and the hand categories of
+// each player.
+template<class TEvaluator>
+unsigned BasicEquityCalculator<TEvaluator>::getCacheValueSize() const
+{
+    unsigned nplayers = (unsigned)mHandRanges.size();
+    return (1 << nplayers) - 1 + nplayers * HAND_CATEGORY_COUNT;
+}
+
+// Transforms suits in such way that suit isomorphism can be easily detected. Goes through the board cards and then
+// the dead cards. First encountered suit is mapped to "virtual" suit 0, second suit maps to 1 and so on. These are
+// fixed for the whole calculation, so this is done once in start().
+template<class TEvaluator>
+typename BasicEquityCalculator<TEvaluator>::SuitTransform
+BasicEquityCalculator<TEvaluator>::transformFixedCards(uint64_t* boardCards, uint64_t* deadCards)
+{
+    SuitTransform transform = {{UNMAPPED_SUIT, UNMAPPED_SUIT, UNMAPPED_SUIT, UNMAPPED_SUIT}, 0};
+    for (uint64_t* cards : {boardCards, deadCards}) {
+        uint64_t newCards = 0;
+        for (uint64_t mask = *cards; mask; mask &= mask - 1) {
+            unsigned card = countTrailingZeros(mask);
+            unsigned suit = card & SUIT_MASK;
+            if (transform.suits[suit] == UNMAPPED_SUIT)
+                transform.suits[suit] = (uint8_t)transform.count++;
+            newCards |= 1ull << ((card & RANK_MASK) | transform.suits[suit]);
         }
+        *cards = newCards;
     }
-    *deadCards = newDeadCards;
+    return transform;
+}
 
-    // Holecards need to be handled after any fixed cards, because the lookup is only based on them.
+// Continues the suit transformation of the fixed cards with the hole cards. Holecards need to be handled after any
+// fixed cards, because the lookup is only based on them.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::transformSuits(HandWithPlayerIdx* playerHands, unsigned nplayers,
+                                                       SuitTransform transform)
+{
     for (unsigned i = 0; i < nplayers; ++i) {
         for (uint8_t& c : playerHands[i].cards) {
             unsigned suit = c & SUIT_MASK;
-            if (transform[suit] == ~0u)
-                transform[suit] = suitCount++;
-            c = (c & RANK_MASK) | transform[suit];
+            if (transform.suits[suit] == UNMAPPED_SUIT)
+                transform.suits[suit] = (uint8_t)transform.count++;
+            c = (c & RANK_MASK) | transform.suits[suit];
         }
     }
+}
 
-    return suitCount;
+// Sorts players by the ranks and then the suits of their hole cards, so that player isomorphism can be detected.
+// The order is packed into an integer key together with the position of the hand, so that the keys can be sorted
+// with a sorting network of branchless min/max operations. Two hands never have the same cards, so the keys are
+// unique.
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::sortPlayerHands(HandWithPlayerIdx* playerHands, unsigned nplayers)
+{
+    omp_assert(nplayers <= MAX_PLAYERS);
+    uint32_t keys[MAX_PLAYERS];
+    for (unsigned i = 0; i < nplayers; ++i) {
+        const std::array<uint8_t,2>& c = playerHands[i].cards;
+        keys[i] = (c[0] >> 2) << 13 | (c[1] >> 2) << 9 | (c[0] & 3) << 5 | (c[1] & 3) << 3 | i;
+    }
+    for (unsigned i = 0; i < SORTING_NETWORK_SIZES[nplayers]; ++i) {
+        uint32_t& a = keys[SORTING_NETWORKS[nplayers][i][0]];
+        uint32_t& b = keys[SORTING_NETWORKS[nplayers][i][1]];
+        uint32_t lower = std::min(a, b);
+        b = std::max(a, b);
+        a = lower;
+    }
+    HandWithPlayerIdx sorted[MAX_PLAYERS];
+    for (unsigned i = 0; i < nplayers; ++i)
+        sorted[i] = playerHands[keys[i] & 7];
+    std::copy(sorted, sorted + nplayers, playerHands);
+}
+
+// Same transformation that enumeration does before cache lookups when there are no board or dead cards.
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::canonicalizePreflop(std::array<uint8_t,2>* hands, unsigned nplayers)
+{
+    if (nplayers > MAX_PLAYERS)
+        return 0;
+    HandWithPlayerIdx playerHands[MAX_PLAYERS];
+    for (unsigned i = 0; i < nplayers; ++i) {
+        playerHands[i].cards = hands[i];
+        playerHands[i].playerIdx = i;
+    }
+    sortPlayerHands(playerHands, nplayers);
+    uint64_t boardCards = 0, deadCards = 0;
+    transformSuits(playerHands, nplayers, transformFixedCards(&boardCards, &deadCards));
+    for (unsigned i = 0; i < nplayers; ++i)
+        hands[i] = playerHands[i].cards;
+    return calculateUniquePreflopId(playerHands, nplayers);
 }
 
 // Calculates a unique 64-bit id for each combination of starting hands.
-uint64_t EquityCalculator::calculateUniquePreflopId(const HandWithPlayerIdx* playerHands, unsigned nplayers)
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::calculateUniquePreflopId(const HandWithPlayerIdx* playerHands,
+                                                                     unsigned nplayers)
 {
     uint64_t preflopId = 0;
     // Basically we just map the preflop to a number in base 1327, where each digit represents a hand.
@@ -623,7 +1461,8 @@ uint64_t EquityCalculator::calculateUniquePreflopId(const HandWithPlayerIdx* pla
     return preflopId;
 }
 
-Hand EquityCalculator::getBoardFromBitmask(uint64_t cards)
+template<class TEvaluator>
+Hand BasicEquityCalculator<TEvaluator>::getBoardFromBitmask(uint64_t cards)
 {
     Hand board = Hand::empty();
     for (unsigned c = 0; c < CARD_COUNT; ++c) {
@@ -634,7 +1473,8 @@ Hand EquityCalculator::getBoardFromBitmask(uint64_t cards)
 }
 
 // Removes combos that conflict with board and dead cards.
-std::vector<std::vector<std::array<uint8_t,2>>> EquityCalculator::removeInvalidCombos(
+template<class TEvaluator>
+std::vector<std::vector<std::array<uint8_t,2>>> BasicEquityCalculator<TEvaluator>::removeInvalidCombos(
         const std::vector<CardRange>& handRanges, uint64_t reservedCards)
 {
     std::vector<std::vector<std::array<uint8_t,2>>> result;
@@ -649,31 +1489,23 @@ std::vector<std::vector<std::array<uint8_t,2>>> EquityCalculator::removeInvalidC
     return result;
 }
 
-// Work allocation for enumeration threads.
-std::pair<uint64_t,uint64_t> EquityCalculator::reserveBatch(uint64_t batchCount)
-{
-    std::lock_guard<std::mutex> lock(mMutex);
-
-    uint64_t totalBatchCount = getPreflopCombinationCount();
-    uint64_t start = mEnumPosition;
-    uint64_t end = std::min<uint64_t>(totalBatchCount, mEnumPosition + batchCount);
-    mEnumPosition = end;
-
-    return {start, end};
-}
-
-// Number of different preflops with given hand ranges, assuming no conflicts between players' hands.
-uint64_t EquityCalculator::getPreflopCombinationCount()
+// Number of different preflops with given hand ranges, assuming no conflicts between players' hands. In preflop-major
+// enumeration only the canonical combos of the first range are counted.
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::getPreflopCombinationCount()
 {
+    if (!mPreflopPrefixes.empty())
+        return mPreflopPrefixes.back().firstIndex;
     uint64_t combos = 1;
     for (unsigned i = 0; i < mCombinedRangeCount; ++i)
-        combos *= mCombinedRanges[i].combos().size();
+        combos *= i == 0 && !mCanonicalCombos.empty() ? mCanonicalCombos.size() : mCombinedRanges[i].combos().size();
     return combos;
 }
 
 // Calculates size of the postflop tree, i.e. n choose k, where n is remaining deck size and k is number
 // of undealt board cards.
-uint64_t EquityCalculator::getPostflopCombinationCount()
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::getPostflopCombinationCount()
 {
     omp_assert(bitCount(mBoardCards) <= BOARD_CARDS);
     unsigned cardsInDeck = CARD_COUNT;
@@ -688,124 +1520,61 @@ uint64_t EquityCalculator::getPostflopCombinationCount()
     return postflopCombos;
 }
 
-// Results aggregation for both enumeration and monte carlo.
-void EquityCalculator::updateResults(const BatchResults& stats, bool threadFinished)
+// Number of boards in board-major enumeration, i.e. n choose k, where n is the number of cards that aren't dead or
+// on the board. The hole cards aren't removed from the deck, because they are different for each preflop.
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::getBoardCombinationCount()
 {
-    auto t = std::chrono::high_resolution_clock::now();
-
-    std::lock_guard<std::mutex> lock(mMutex);
-
-    double batchEquity = combineResults(stats);
-
-    // Store values for stdev calculation
-    if (!threadFinished) {
-        mBatchSum += batchEquity;
-        mBatchSumSqr += batchEquity * batchEquity;
-        mBatchCount += 1;
-    }
-
-    mResults.finished = threadFinished && --mUnfinishedThreads == 0;
-
-    double dt = 1e-9 * std::chrono::duration_cast<std::chrono::nanoseconds>(t - mLastUpdate).count();
-    //std::cout << mResults.hands << " " << mHandLimit << std::endl;
-    if (mResults.time + dt >= mTimeLimit || mResults.hands + mResults.intervalHands >= mHandLimit)
-        mStopped = true;
-
-    // Periodic update through callback.
-    if (dt >= mUpdateInterval || mResults.finished) {
-        mResults.intervalTime = dt;
-        mResults.time += mResults.intervalTime;
-        mResults.hands += mResults.intervalHands;
-        mResults.intervalSpeed = mResults.intervalHands / (mResults.intervalTime + 1e-9);
-        mResults.speed = mResults.hands / (mResults.time + 1e-9);
-        mResults.intervalHands = 0;
-        mResults.stdev = std::sqrt(1e-9 + mBatchSumSqr - mBatchSum * mBatchSum / mBatchCount) / mBatchCount;
-        mResults.stdevPerHand = mResults.stdev * std::sqrt(mResults.hands);
-        if (mResults.enumerateAll) {
-            mResults.progress = (double)mEnumPosition / getPreflopCombinationCount();
-        } else {
-            double estimatedHands = std::pow(mResults.stdev / mStdevTarget, 2) * mResults.hands;
-            mResults.progress = mResults.hands / estimatedHands;
-        }
-        mResults.preflopCombos = getPreflopCombinationCount();
-
-        if (!mResults.enumerateAll && mResults.stdev < mStdevTarget) //TODO use max stdev of any player
-            mStopped = true;
-
-        for (unsigned i = 0; i < mResults.players; ++i)
-            mResults.equity[i] = (mResults.wins[i] + mResults.ties[i]) / (mResults.hands + 1e-9);
-
-        mUpdateResults = mResults;
-
-        if (mCallback)
-            mCallback(mResults);
-
-        mLastUpdate = t;
-    }
-
-    //if (finished)
-    //    outputLookupTable();
+    return binomial(CARD_COUNT - bitCount(mDeadCards | mBoardCards), BOARD_CARDS - bitCount(mBoardCards));
 }
 
-// Sum batch results in the main results structure.
-double EquityCalculator::combineResults(const BatchResults& batch)
+template<class TEvaluator>
+uint64_t BasicEquityCalculator<TEvaluator>::binomial(unsigned n, unsigned k)
 {
-    uint64_t batchHands = 0;
-    double batchEquity = 0;
-
-    for (unsigned i = 0; i < (1u << mResults.players); ++i) {
-        mResults.intervalHands += batch.winsByPlayerMask[i];
-        batchHands += batch.winsByPlayerMask[i];
-        unsigned winnerCount = bitCount(i);
-        unsigned actualPlayerMask = 0;
-        for (unsigned j = 0; j < mResults.players; ++j) {
-            if (i & (1 << j)) {
-                if (winnerCount == 1) {
-                    mResults.wins[batch.playerIds[j]] += batch.winsByPlayerMask[i];
-                    if (batch.playerIds[j] == 0)
-                        batchEquity += batch.winsByPlayerMask[i];
-                } else {
-                    mResults.ties[batch.playerIds[j]] += batch.winsByPlayerMask[i] / (double)winnerCount;
-                    if (batch.playerIds[j] == 0)
-                        batchEquity += batch.winsByPlayerMask[i] / (double)winnerCount;
-                }
-                actualPlayerMask |= 1 << batch.playerIds[j];
-            }
-        }
-        mResults.winsByPlayerMask[actualPlayerMask] += batch.winsByPlayerMask[i];
-    }
-
-    mResults.evaluations += batch.evalCount;
-    mResults.skippedPreflopCombos += batch.skippedPreflopCombos;
-    mResults.evaluatedPreflopCombos += batch.uniquePreflopCombos;
-
-    return batchEquity / (batchHands + 1e-9);
+    if (k > n)
+        return 0;
+    uint64_t result = 1;
+    for (unsigned i = 0; i < k; ++i)
+        result = result * (n - i) / (i + 1);
+    return result;
 }
 
-// Helper function for printing out precalculated lookup tables.
-void EquityCalculator::outputLookupTable() const
+template<class TEvaluator>
+void BasicEquityCalculator<TEvaluator>::outputPrecalculatedResults(std::ostream& out) const
 {
-    std::vector<std::array<unsigned,3>> a;
-    for (auto& e: mLookup) {
-        a.push_back({(unsigned)e.first, (unsigned)e.second.winsByPlayerMask[1],
-                     (unsigned)e.second.winsByPlayerMask[3]});
-    }
-    std::sort(a.begin(), a.end(), [](const std::array<unsigned,3>& lhs, const std::array<unsigned,3>& rhs){
-        return lhs[0] < rhs[0];
+    std::vector<std::pair<uint64_t,std::array<uint32_t,3 + 2 * HAND_CATEGORY_COUNT>>> entries;
+    mLookup.forEach([&](const PreflopCache::Key& key, const uint32_t* values){
+        entries.emplace_back();
+        entries.back().first = key.preflop;
+        std::copy(values, values + entries.back().second.size(), entries.back().second.begin());
     });
-
-    std::cout << std::hex;
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (i % 6 == 0)
-            std::cout << std::endl;
-        std::cout << " 0x" << ((uint64_t)a[i][0] | (uint64_t)a[i][1] << 22 | (uint64_t)a[i][2] << 43) << ",";
+    std::sort(entries.begin(), entries.end());
+
+    out << "// Results of all heads-up preflops without board and dead cards. Generated by genpreflop." << std::endl;
+    out << "namespace omp {" << std::endl << std::endl;
+    out << "static const size_t PRECALCULATED_2PLAYER_COUNT = " << entries.size() << ";" << std::endl << std::endl;
+    out << "static const uint64_t PRECALCULATED_2PLAYER_RESULTS[] = {" << std::hex;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const uint32_t* v = entries[i].second.data();
+        out << (i % 6 ? " " : "\n    ") << "0x" << (entries[i].first | (uint64_t)v[0] << PRECALCULATED_ID_BITS
+                | (uint64_t)v[2] << (PRECALCULATED_ID_BITS + PRECALCULATED_COUNT_BITS)) << ",";
+    }
+    out << std::dec << "\n};" << std::endl << std::endl;
+    out << "static const uint32_t PRECALCULATED_2PLAYER_CATEGORIES[] = {";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        // Wins are followed by the categories of both players, and category 0 is never used.
+        const uint32_t* v = entries[i].second.data() + 3;
+        out << "\n   ";
+        for (unsigned j = 0; j < 2 * HAND_CATEGORY_COUNT; ++j) {
+            if (j % HAND_CATEGORY_COUNT)
+                out << " " << v[j] << ",";
+        }
     }
-    std::cout << std::endl;
-    std::cout.flush();
+    out << "\n};" << std::endl << std::endl << "}" << std::endl;
 }
 
-//Not used atm.
-const std::vector<uint64_t> EquityCalculator::PRECALCULATED_2PLAYER_RESULTS {
-};
+template class BasicEquityCalculator<HandEvaluator>;
+template class BasicEquityCalculator<ShortDeckHandEvaluator>;
+template class BasicEquityCalculator<CompactHandEvaluator>;
 
 }
@@ -1,67 +1,44 @@
 #ifndef OMP_EQUITYCALCULATOR_H
 #define OMP_EQUITYCALCULATOR_H
 
+#include "EquityCalculatorBase.h"
 #include "CombinedRange.h"
+#include "PreflopCache.h"
+#include "PreflopDatabase.h"
 #include "Random.h"
 #include "CardRange.h"
 #include "HandEvaluator.h"
+#include "CompactHandEvaluator.h"
 #include "Constants.h"
 #include "Util.h"
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <atomic>
-#include <unordered_map>
 #include <functional>
+#include <iosfwd>
+#include <memory>
 #include <array>
 #include <cstdint>
 
 namespace omp {
 
 // Calculates all-in equities in Texas Holdem for given player hand ranges, board cards and dead cards. Supports both
-// exact enumeration and monte carlo simulation.
-class EquityCalculator
+// exact enumeration and monte carlo simulation. TEvaluator is the hand evaluator: HandEvaluator for hold'em, or
+// ShortDeckHandEvaluator for short deck equities, where the cards that are not in its deck are treated as dead cards.
+// CompactHandEvaluator gives the same hold'em results as HandEvaluator with a smaller cache footprint.
+// Threads, results and random numbers are handled by EquityCalculatorBase.
+template<class TEvaluator = HandEvaluator>
+class BasicEquityCalculator : public EquityCalculatorBase
 {
 public:
 
-    struct Results
-    {
-        // Number of players.
-        unsigned players = 0;
-        // Equity by player (between 0 and 1).
-        double equity[MAX_PLAYERS] = {};
-        // Wins by player.
-        uint64_t wins[MAX_PLAYERS] = {};
-        // Ties by player, adjusted for equity: 2-way splits = 1/2, 3-way = 1/3 etc..
-        double ties[MAX_PLAYERS] = {};
-        // Wins for each combination of winning players. Index ranges from 0 to 2^(n-1), where
-        // bit 0 is player 1, bit 1 player 2 etc).
-        uint64_t winsByPlayerMask[1 << MAX_PLAYERS] = {};
-        // Total hand count / hand count for last update period.
-        uint64_t hands = 0, intervalHands = 0;
-        // Total speed in hands/s / speed for last update period.
-        double speed = 0, intervalSpeed = 0;
-        // Total duration / duration of the last update period.
-        double time = 0, intervalTime = 0;
-        // Standard deviation for the total equity of first player.
-        double stdev = 0;
-        // Single-hand standard deviation.
-        double stdevPerHand = 0;
-        // Progress from 0 to 1. Based on hand count for enumeration, and stdev target for monte carlo.
-        double progress = 0;
-        // Number of different combinations of starting hands for all players.
-        uint64_t preflopCombos = 0;
-        // Number of preflop combos that were skipped due the having same cards. (Enumeration only.)
-        uint64_t skippedPreflopCombos = 0;
-        // How many of the preflop combos were actually enumerated.
-        uint64_t evaluatedPreflopCombos = 0;
-        // How many showdowns were actually evaluated (instead of using lookups or isomorphism).
-        uint64_t evaluations = 0;
-        // Whether enumeration or monte carlo was used.
-        bool enumerateAll = false;
-        // Is calculation finished. (Includes stopping.)
-        bool finished = false;
-    };
+    // Engine for exact enumeration. PREFLOP_MAJOR goes through the boards separately for each preflop combination
+    // and uses suit isomorphism and a lookup cache. BOARD_MAJOR loops over the boards, ranks each combo of each range
+    // once per board and tallies the preflop combinations from those ranks, which needs far fewer evaluations with
+    // wide ranges. AUTO picks board-major for heads-up calculations with board or dead cards when its estimated cost
+    // is lower.
+    enum Enumeration { ENUMERATION_AUTO, ENUMERATION_PREFLOP_MAJOR, ENUMERATION_BOARD_MAJOR };
 
     // Start a new calculation. Returns false if calculation is impossible for given hand ranges and board/dead cards.
     // After calling start() succesfully, wait() must be called in order wait for threads to finish.
@@ -77,38 +54,40 @@ public:
                std::function<void(const Results&)> callback = nullptr,
                double updateInterval = 0.2, unsigned threadCount = 0);
 
-    // Force current calculation to stop before it's ready. Still must call wait()!
-    void stop()
-    {
-        mStopped = true;
-    }
-
-    // Wait for calculation to finish. Must always be called once for every successful start() call!
-    void wait()
+    // Choose the enumeration engine for following calculations. ENUMERATION_AUTO by default.
+    void setEnumeration(Enumeration enumeration)
     {
-        for (auto& t : mThreads)
-            t.join();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEnumeration = enumeration;
     }
 
-    // Set a time limit for the calculation in seconds. Use 0 to disable. Disabled by default.
-    void setTimeLimit(double seconds)
+    // Set the memory budget of the preflop results cache in bytes. Used by enumeration when the postflop tree is
+    // big enough to make caching worthwhile. 128MB by default.
+    void setCacheSize(size_t bytes)
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mTimeLimit = seconds <= 0 ? INFINITE : seconds;
+        mCacheSize = bytes;
     }
 
-    // Set a hand limit for the calculation or 0 to disable. Disabled by default.
-    void setHandLimit(uint64_t handLimit)
+    // Keep the preflop results cache in files in a directory (one for each player count and deck), so that results are
+    // shared with other processes and later runs. New files are created with the size set by setCacheSize(). An
+    // empty string (the default) uses memory only, and so does any calculation whose cache file can't be used.
+    void setCacheDirectory(const std::string& directory)
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mHandLimit = handLimit == 0 ? INFINITE : handLimit;
+        mCacheDirectory = directory;
     }
 
-    // Get results from previous update.
-    Results getResults()
+    // Use a database of precalculated preflop results (see genpreflopdb) for calculations with the same number of
+    // players and no board or dead cards. An empty path closes the database. Returns false if it can't be opened.
+    bool setPreflopDatabase(const std::string& path)
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        return mUpdateResults;
+        if (path.empty()) {
+            mDatabase.close();
+            return true;
+        }
+        return mDatabase.open(path);
     }
 
     // Hand ranges used in current calculation.
@@ -117,28 +96,21 @@ public:
         return mOriginalHandRanges;
     }
 
-private:
-    typedef XoroShiro128Plus Rng;
+    // Prints the cached results of heads-up preflops as the C++ source of the precalculated results table. Used by
+    // genpreflop after enumerating random vs random, so the cache must hold every preflop of that calculation.
+    void outputPrecalculatedResults(std::ostream& out) const;
 
-    static const size_t MAX_LOOKUP_SIZE = 1000000;
-    static const size_t MAX_COMBINED_RANGE_SIZE = 10000;
-    static const uint64_t INFINITE = ~0ull;
+    // Transforms the hole cards of a preflop without board and dead cards to the canonical form that is used for the
+    // precalculated results (players sorted by hand and suits renamed in order of appearance) and returns its id.
+    // Returns 0, which is never a valid id, for more than MAX_PLAYERS players.
+    static uint64_t canonicalizePreflop(std::array<uint8_t,2>* hands, unsigned nplayers);
 
-    // Temporary storage for results.
-    struct BatchResults
-    {
-        BatchResults(unsigned nplayers)
-        {
-            for (unsigned i = 0; i < nplayers; ++i)
-                playerIds[i] = i;
-        }
-
-        uint64_t skippedPreflopCombos = 0;
-        uint64_t uniquePreflopCombos = 0;
-        uint64_t evalCount = 0;
-        uint8_t playerIds[MAX_PLAYERS];
-        unsigned winsByPlayerMask[1 << MAX_PLAYERS] = {};
-    };
+private:
+    static const size_t MAX_COMBINED_RANGE_SIZE = 10000;
+    // Larger enumerations go through all combinations of the combined ranges and skip the ones that share cards.
+    static const size_t MAX_PREFLOP_PREFIXES = 1 << 20;
+    static const unsigned SUIT_PERMUTATION_COUNT = 24;
+    static const uint8_t UNMAPPED_SUIT = 0xff;
 
     // Ad-hoc struct used when sorting hands.
     struct HandWithPlayerIdx
@@ -147,65 +119,167 @@ private:
         unsigned playerIdx;
     };
 
-    void simulateRegularMonteCarlo();
-    void simulateRandomWalkMonteCarlo();
+    // Mapping from the actual suits to the suits of the canonical form.
+    struct SuitTransform
+    {
+        uint8_t suits[SUIT_COUNT]; // UNMAPPED_SUIT for suits that haven't been seen yet.
+        unsigned count; // Number of mapped suits.
+    };
+
+    // Combo of the first combined range that stands for a class of combos that give the same results.
+    struct CanonicalCombo
+    {
+        uint32_t comboIdx;
+        uint32_t weight; // Size of the class.
+    };
+
+    // Combination of combos of all combined ranges but the last one that don't share cards. The enumeration indexes
+    // of each prefix are the combos of the last range that don't share cards with it.
+    struct PreflopPrefix
+    {
+        uint64_t firstIndex;
+        uint32_t comboIdxs[MAX_PLAYERS - 1]; // The first one is an index to mCanonicalCombos.
+    };
+
+    // Per-thread data of one player in board-major enumeration.
+    struct BoardMajorRange
+    {
+        std::vector<Hand> holeCards; // Combos after card removal, same order as in mHandRanges.
+        std::vector<uint64_t> cardMasks;
+        std::vector<uint8_t> inOtherRange; // Heads-up only: the same combo is also in the opponent's range.
+        std::vector<unsigned> live; // Indexes of the combos that don't conflict with current board.
+        unsigned firstRank; // Position of the ranks of live combos in the rank array of the board.
+    };
+
+    // Cards that can still be dealt to the board in monte carlo simulation. The first size elements of cards are the
+    // live cards in any order and positions has the index of each live card in it, so that the cards of a combo can
+    // be swapped in constant time.
+    struct LiveDeck
+    {
+        void reset(uint64_t usedCards)
+        {
+            size = 0;
+            for (uint64_t mask = ~usedCards & ((1ull << CARD_COUNT) - 1); mask; mask &= mask - 1) {
+                unsigned card = countTrailingZeros(mask);
+                positions[card] = size;
+                cards[size++] = card;
+            }
+        }
+
+        // Makes the used cards oldCards live and the live cards newCards used. Both must have the same number of
+        // cards, so the new cards are just overwritten in place.
+        void replace(uint64_t oldCards, uint64_t newCards)
+        {
+            omp_assert(bitCount(oldCards) == bitCount(newCards));
+            for (; newCards; newCards &= newCards - 1, oldCards &= oldCards - 1) {
+                unsigned pos = positions[countTrailingZeros(newCards)];
+                unsigned card = countTrailingZeros(oldCards);
+                cards[pos] = card;
+                positions[card] = pos;
+            }
+        }
+
+        uint8_t cards[CARD_COUNT];
+        uint8_t positions[CARD_COUNT];
+        unsigned size = 0;
+        // Unused random bits of dealBoard().
+        uint64_t randomBits = 0;
+        unsigned randomBitsLeft = 0;
+    };
+
+    typedef void (BasicEquityCalculator::*ThreadFunction)(unsigned threadIdx);
+
+    template<unsigned tPlayers>
+    void simulateRegularMonteCarlo(unsigned threadIdx);
+    template<unsigned tPlayers>
+    void simulateRandomWalkMonteCarlo(unsigned threadIdx);
     bool randomizeHoleCards(uint64_t &usedCardsMask, unsigned* comboIndexes, Hand* playerHands,
                             Rng& rng, FastUniformIntDistribution<unsigned,21>*comboDists);
     OMP_FORCE_INLINE void randomizeBoard(Hand& board, unsigned remainingCards, uint64_t usedCardsMask,
                         Rng& rng, FastUniformIntDistribution<unsigned,16>& cardDist);
-    template<bool tFlushPossible = true>
-    OMP_FORCE_INLINE void evaluateHands(const Hand* playerHands, unsigned nplayers, const Hand& board,
-            BatchResults* stats, unsigned weight);
-    void enumerate();
-    void enumerateBoard(const HandWithPlayerIdx* playerHands, unsigned nplayers,
-                   const Hand& board, uint64_t usedCardsMask, BatchResults* stats);
-    void enumerateBoardRec(const Hand* playerHands, unsigned nplayers, BatchResults* stats,
-                           const Hand& board, unsigned* deck, unsigned ndeck,  unsigned* suitCounts,
-                           unsigned k, unsigned start, unsigned weight);
-    bool lookupResults(uint64_t hash, BatchResults& results);
+    OMP_FORCE_INLINE static void dealBoard(Hand& board, unsigned remainingCards, LiveDeck& deck, Rng& rng);
+    template<unsigned tPlayers, bool tFlushPossible = true>
+    OMP_FORCE_INLINE void evaluateHands(const Hand* playerHands, const Hand& board, BatchResults* stats,
+                                        unsigned weight);
+    template<unsigned tPlayers>
+    void enumerate(unsigned threadIdx);
+    template<unsigned tPlayers>
+    void enumerateBoard(const HandWithPlayerIdx* playerHands, const Hand& board, uint64_t usedCardsMask,
+                        BatchResults* stats, unsigned weight);
+    template<unsigned tPlayers>
+    void enumerateBoardRec(const Hand* playerHands, BatchResults* stats, const Hand& board, unsigned* deck,
+                           unsigned ndeck,  unsigned* suitCounts, unsigned k, unsigned start, unsigned weight);
+    template<unsigned tPlayers>
+    void enumerateCanonicalBoards(const Hand* playerHands, BatchResults* stats, const Hand& board, unsigned* deck,
+                                  unsigned ndeck, unsigned* suitCounts, unsigned cardsLeft, unsigned start,
+                                  unsigned weight, const std::array<uint8_t,SUIT_COUNT>* perms, unsigned permCount);
+    static unsigned getSuitSymmetries(const HandWithPlayerIdx* playerHands, unsigned nplayers, uint64_t fixedCards,
+                                      std::array<uint8_t,SUIT_COUNT>* perms);
+    static uint64_t permuteSuits(uint64_t cards, const std::array<uint8_t,SUIT_COUNT>& perm);
+    bool isBoardMajorFaster();
+    void findCanonicalCombos();
+    void findPreflopPrefixes();
+    bool findPreflopPrefixesRec(unsigned rangeIdx, uint64_t usedCards, PreflopPrefix& prefix, uint64_t& count,
+                                uint64_t* live);
+    uint64_t getLiveCombos(uint64_t usedCards, uint64_t* live) const;
+    unsigned unrankPreflop(uint64_t idx, HandWithPlayerIdx* playerHands, uint64_t& usedCards, size_t& prefixIdx,
+                           uint64_t* live) const;
+    template<unsigned tPlayers>
+    void enumerateBoardMajor(unsigned threadIdx);
+    void tallyHeadsUp(const BoardMajorRange* ranges, const uint16_t* ranks, uint32_t* sortBuffer,
+                      BatchResults* stats) const;
+    template<unsigned tPlayers>
+    void tallyBoardRec(const BoardMajorRange* ranges, const uint16_t* ranks, const uint64_t* bounds, unsigned player,
+                       uint64_t usedCardsMask, uint16_t* showdownRanks, uint64_t& pendingHands, BatchResults* stats,
+                       unsigned threadIdx);
+    static void sortByRank(uint32_t* keys, uint32_t* buffer, unsigned count);
+    template<unsigned tPlayers>
+    static void addPreflopResults(const BatchResults& preflopStats, BatchResults* stats, unsigned weight);
+    bool lookupResults(const PreflopCache::Key& key, BatchResults& results);
     bool lookupPrecalculatedResults(uint64_t hash, BatchResults& results) const;
-    void storeResults(uint64_t hash, const BatchResults& results);
-    static unsigned transformSuits(HandWithPlayerIdx* playerHands, unsigned nplayers,
-                                   uint64_t* boardCards, uint64_t* usedCards);
+    bool storeResults(const PreflopCache::Key& key, const BatchResults& results);
+    unsigned getCacheValueSize() const;
+    static SuitTransform transformFixedCards(uint64_t* boardCards, uint64_t* deadCards);
+    static void transformSuits(HandWithPlayerIdx* playerHands, unsigned nplayers, SuitTransform transform);
     static uint64_t calculateUniquePreflopId(const HandWithPlayerIdx* playerHands, unsigned nplayers);
+    static void sortPlayerHands(HandWithPlayerIdx* playerHands, unsigned nplayers);
     static Hand getBoardFromBitmask(uint64_t board);
     static std::vector<std::vector<std::array<uint8_t,2>>> removeInvalidCombos(const std::vector<CardRange>& handRanges,
                                                                uint64_t reservedCards);
-    std::pair<uint64_t,uint64_t> reserveBatch(uint64_t batchCount);
     uint64_t getPreflopCombinationCount();
     uint64_t getPostflopCombinationCount();
+    uint64_t getBoardCombinationCount();
+    static uint64_t binomial(unsigned n, unsigned k);
 
-    void updateResults(const BatchResults& stats, bool finished);
-    double combineResults(const BatchResults& batch);
-    void outputLookupTable() const;
-
-    std::vector<std::thread> mThreads;
-
-    // Shared between threads, protected by mMutex.
-    std::mutex mMutex;
-    std::atomic<bool> mStopped;
-    unsigned mUnfinishedThreads;
-    std::chrono::high_resolution_clock::time_point mLastUpdate;
-    Results mResults, mUpdateResults;
-    double mBatchSum, mBatchSumSqr, mBatchCount;
-    uint64_t mEnumPosition;
-    std::unordered_map<uint64_t, BatchResults> mLookup;
+    PreflopCache mLookup;
+    PreflopDatabase mDatabase;
 
     // Constant shared data
     std::vector<CardRange> mOriginalHandRanges; // Original ranges without before card removal.
     std::vector<std::vector<std::array<uint8_t,2>>> mHandRanges; // Ranges after card removal.
     CombinedRange mCombinedRanges[MAX_PLAYERS];
     unsigned mCombinedRangeCount;
+    std::vector<CanonicalCombo> mCanonicalCombos; // Preflop-major enumeration only.
+    // Preflop-major enumeration with at least two combined ranges only. Ends with a sentinel whose first index is
+    // the number of preflops.
+    std::vector<PreflopPrefix> mPreflopPrefixes;
+    // Bitsets of the combos of the last combined range that contain each card, mLastRangeWords words per card.
+    std::vector<uint64_t> mLastRangeCardCombos;
+    size_t mLastRangeWords = 0;
     uint64_t mDeadCards, mBoardCards;
-    HandEvaluator mEval;
-    double mStdevTarget = 5e-5, mTimeLimit = (double)INFINITE, mUpdateInterval = 0.1;
-    uint64_t mHandLimit = INFINITE;
-    std::function<void(const Results& results)> mCallback;
-
-    // Precalculated results for 2 player preflop situations. Uses a sorted array for lowest memory use.
-    static const std::vector<uint64_t> PRECALCULATED_2PLAYER_RESULTS;
+    // Board and dead cards after the suit transformation of the preflop cache keys, and the transformation itself.
+    uint64_t mTransformedBoardCards, mTransformedDeadCards;
+    SuitTransform mFixedSuitTransform;
+    TEvaluator mEval;
+    Enumeration mEnumeration = ENUMERATION_AUTO;
+    size_t mCacheSize = (size_t)128 << 20;
+    std::string mCacheDirectory;
 };
 
+typedef BasicEquityCalculator<HandEvaluator> EquityCalculator;
+typedef BasicEquityCalculator<ShortDeckHandEvaluator> ShortDeckEquityCalculator;
+typedef BasicEquityCalculator<CompactHandEvaluator> CompactEquityCalculator;
+
 }
 
 #endif // OMP_EQUITYCALCULATOR_H
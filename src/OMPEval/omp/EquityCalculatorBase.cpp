@@ -0,0 +1,282 @@
+#include "EquityCalculatorBase.h"
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+namespace omp {
+
+// Seeds the generator of a new calculation.
+void EquityCalculatorBase::seedRng(bool enumerateAll)
+{
+    std::random_device rd;
+    mRng = Rng(mSeed ? mSeed : (uint64_t)rd() << 32 | rd());
+    mReproducible = mSeed && !enumerateAll;
+}
+
+// Resets the shared state of a new calculation and spawns the threads.
+void EquityCalculatorBase::startThreads(unsigned players, bool enumerateAll, uint64_t enumSize, uint64_t preflopCombos,
+                                        double stdevTarget, std::function<void(const Results&)> callback,
+                                        double updateInterval, unsigned threadCount,
+                                        std::function<void(unsigned)> threadFunction)
+{
+    mEnumPosition = 0;
+    mEnumSize = enumSize;
+    mPreflopCombos = preflopCombos;
+    mResults = Results();
+    mResults.players = players;
+    mResults.enumerateAll = enumerateAll;
+    mUpdateResults = mResults;
+    mStdevTarget = stdevTarget;
+    mCallback = callback;
+    mUpdateInterval = updateInterval;
+    mStopped = false;
+    mHandCount = 0;
+    mNextUpdateTime = updateInterval;
+    mStartTime = std::chrono::high_resolution_clock::now();
+    mUnfinishedThreads = threadCount;
+    mThreadResults.reset(new ThreadResults[std::max(threadCount, 1u)]);
+    mThreadCount = threadCount;
+    for (unsigned i = 0; i < threadCount; ++i)
+        mThreadResults[i].results.players = players;
+
+    // Each enumeration thread starts with an equal share of the indexes.
+    mWorkQueues.reset(new WorkQueue[std::max(threadCount, 1u)]);
+    mWorkQueueCount = threadCount;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        mWorkQueues[i].begin = mEnumSize / threadCount * i + std::min<uint64_t>(i, mEnumSize % threadCount);
+        mWorkQueues[i].end = mEnumSize / threadCount * (i + 1) + std::min<uint64_t>(i + 1, mEnumSize % threadCount);
+    }
+
+    mThreads.clear();
+    for (unsigned i = 0; i < threadCount; ++i)
+        mThreads.emplace_back([threadFunction,i]{ threadFunction(i); });
+}
+
+// Takes the next batch of enumeration indexes from the queue of a thread, stealing work from other threads when the
+// queue is empty. The first batch has the given size, and later ones are sized by the measured time per index of
+// the previous batches of the thread, because the cost of a preflop varies from a cache hit to a full enumeration.
+// Returns an empty range when all the work has been handed out.
+std::pair<uint64_t,uint64_t> EquityCalculatorBase::reserveBatch(unsigned queueIdx, uint64_t firstBatchSize)
+{
+    WorkQueue& queue = mWorkQueues[queueIdx];
+    auto now = std::chrono::high_resolution_clock::now();
+    uint64_t batchSize = firstBatchSize;
+    if (queue.lastBatchSize > 0) {
+        double cost = std::chrono::duration<double>(now - queue.lastBatchTime).count() / queue.lastBatchSize;
+        queue.costPerIndex = queue.costPerIndex > 0 ? 0.5 * (queue.costPerIndex + cost) : cost;
+        batchSize = (uint64_t)std::max(1.0, std::min(BATCH_DURATION / (queue.costPerIndex + 1e-12), 1e9));
+    }
+
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.begin < queue.end) {
+                uint64_t start = queue.begin;
+                queue.begin += std::min(batchSize, queue.end - start);
+                queue.lastBatchSize = queue.begin - start;
+                queue.lastBatchTime = now;
+                mEnumPosition += queue.lastBatchSize;
+                return {start, queue.begin};
+            }
+        }
+        if (!stealWork(queueIdx))
+            return {0, 0};
+    }
+}
+
+// Moves the back half of the remaining indexes of another thread to the empty queue of a thread. Only the owner adds
+// work to a queue, so no other lock is held while the victim is locked. Returns false if all queues are empty.
+bool EquityCalculatorBase::stealWork(unsigned queueIdx)
+{
+    for (unsigned i = 1; i < mWorkQueueCount; ++i) {
+        WorkQueue& victim = mWorkQueues[(queueIdx + i) % mWorkQueueCount];
+        uint64_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin == victim.end)
+                continue;
+            begin = victim.begin + (victim.end - victim.begin) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+        std::lock_guard<std::mutex> lock(mWorkQueues[queueIdx].mutex);
+        mWorkQueues[queueIdx].begin = begin;
+        mWorkQueues[queueIdx].end = end;
+        return true;
+    }
+    return false;
+}
+
+// Gives each thread its own stream of random numbers by jumping ahead 2^64 steps for each thread index.
+EquityCalculatorBase::Rng EquityCalculatorBase::getThreadRng(unsigned threadIdx) const
+{
+    Rng rng = mRng;
+    for (unsigned i = 0; i <= threadIdx; ++i)
+        rng.jump();
+    return rng;
+}
+
+// Results aggregation for both enumeration and monte carlo. Each thread sums its batches into its own results, and
+// the thread that sees the update interval pass first merges the results of all threads. Returns true if the thread
+// should stop.
+bool EquityCalculatorBase::updateResults(const BatchResults& stats, unsigned threadIdx, bool threadFinished)
+{
+    auto t = std::chrono::high_resolution_clock::now();
+    double time = 1e-9 * std::chrono::duration_cast<std::chrono::nanoseconds>(t - mStartTime).count();
+
+    ThreadResults& threadResults = mThreadResults[threadIdx];
+    uint64_t batchHands;
+    bool threadStopped = false;
+    {
+        std::lock_guard<std::mutex> lock(threadResults.mutex);
+        batchHands = threadResults.results.hands;
+        double batchEquity = combineResults(stats, threadResults.results);
+        batchHands = threadResults.results.hands - batchHands;
+
+        // Store values for stdev calculation
+        if (!threadFinished) {
+            threadResults.batchSum += batchEquity;
+            threadResults.batchSumSqr += batchEquity * batchEquity;
+            threadResults.batchCount += 1;
+        }
+
+        // In reproducible simulations each thread stops on its own share of the limits, so that the results of
+        // a thread only depend on its random numbers. The stdev of the total is about the stdev of one thread
+        // divided by the square root of the thread count. It's only estimated after enough batches.
+        if (mReproducible) {
+            double stdev = std::sqrt(1e-9 + threadResults.batchSumSqr - threadResults.batchSum
+                                     * threadResults.batchSum / threadResults.batchCount) / threadResults.batchCount;
+            threadStopped = threadResults.results.hands >= (mHandLimit - 1) / mThreadCount + 1
+                    || (threadResults.batchCount >= MIN_STDEV_BATCHES
+                        && stdev < mStdevTarget * std::sqrt(mThreadCount));
+        }
+    }
+
+    if (time >= mTimeLimit || (!mReproducible && (mHandCount += batchHands) >= mHandLimit))
+        mStopped = true;
+
+    // The last thread to finish makes the final update. Finished threads don't do periodic updates, so that they
+    // can't overwrite the final results.
+    if (threadFinished) {
+        if (--mUnfinishedThreads == 0) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            publishResults(time, true);
+        }
+    } else if (time >= mNextUpdateTime) {
+        std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+        if (lock.owns_lock() && time >= mNextUpdateTime)
+            publishResults(time, false);
+    }
+    return mStopped || threadStopped;
+}
+
+// Merges the results of all threads for the periodic update through callback. Called with mMutex locked.
+void EquityCalculatorBase::publishResults(double time, bool finished)
+{
+    Results results;
+    results.players = mResults.players;
+    results.enumerateAll = mResults.enumerateAll;
+    results.finished = finished;
+    double batchSum = 0, batchSumSqr = 0, batchCount = 0;
+    for (unsigned i = 0; i < mThreadCount; ++i) {
+        ThreadResults& threadResults = mThreadResults[i];
+        std::lock_guard<std::mutex> lock(threadResults.mutex);
+        mergeResults(threadResults.results, results);
+        batchSum += threadResults.batchSum;
+        batchSumSqr += threadResults.batchSumSqr;
+        batchCount += threadResults.batchCount;
+    }
+
+    results.time = time;
+    results.intervalTime = time - mResults.time;
+    results.intervalHands = results.hands - mResults.hands;
+    results.intervalSpeed = results.intervalHands / (results.intervalTime + 1e-9);
+    results.speed = results.hands / (results.time + 1e-9);
+    results.stdev = std::sqrt(1e-9 + batchSumSqr - batchSum * batchSum / batchCount) / batchCount;
+    results.stdevPerHand = results.stdev * std::sqrt(results.hands);
+    if (results.enumerateAll) {
+        results.progress = (double)mEnumPosition / mEnumSize;
+    } else {
+        double estimatedHands = std::pow(results.stdev / mStdevTarget, 2) * results.hands;
+        results.progress = results.hands / estimatedHands;
+    }
+    results.preflopCombos = mPreflopCombos;
+
+    if (!results.enumerateAll && !mReproducible && results.stdev < mStdevTarget) //TODO use max stdev of any player
+        mStopped = true;
+
+    for (unsigned i = 0; i < results.players; ++i)
+        results.equity[i] = (results.wins[i] + results.ties[i]) / (results.hands + 1e-9);
+
+    mResults = results;
+    mUpdateResults = results;
+    mNextUpdateTime = time + mUpdateInterval;
+
+    if (mCallback)
+        mCallback(results);
+}
+
+// Sum batch results in a results structure. Returns the equity of the first player in the batch.
+double EquityCalculatorBase::combineResults(const BatchResults& batch, Results& results)
+{
+    uint64_t batchHands = 0;
+    double batchEquity = 0;
+
+    for (unsigned i = 0; i < (1u << results.players); ++i) {
+        batchHands += batch.winsByPlayerMask[i];
+        unsigned winnerCount = bitCount(i);
+        unsigned actualPlayerMask = 0;
+        for (unsigned j = 0; j < results.players; ++j) {
+            if (i & (1 << j)) {
+                if (winnerCount == 1) {
+                    results.wins[batch.playerIds[j]] += batch.winsByPlayerMask[i];
+                    if (batch.playerIds[j] == 0)
+                        batchEquity += batch.winsByPlayerMask[i];
+                } else {
+                    results.ties[batch.playerIds[j]] += batch.winsByPlayerMask[i] / (double)winnerCount;
+                    if (batch.playerIds[j] == 0)
+                        batchEquity += batch.winsByPlayerMask[i] / (double)winnerCount;
+                }
+                actualPlayerMask |= 1 << batch.playerIds[j];
+            }
+        }
+        results.winsByPlayerMask[actualPlayerMask] += batch.winsByPlayerMask[i];
+    }
+
+    for (unsigned i = 0; i < results.players; ++i) {
+        for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+            results.handCategories[batch.playerIds[i]][j] += batch.handCategories[i][j];
+    }
+
+    results.hands += batchHands;
+    results.evaluations += batch.evalCount;
+    results.cacheHits += batch.cacheHits;
+    results.cacheMisses += batch.cacheMisses;
+    results.cacheEvictions += batch.cacheEvictions;
+    results.skippedPreflopCombos += batch.skippedPreflopCombos;
+    results.evaluatedPreflopCombos += batch.uniquePreflopCombos;
+
+    return batchEquity / (batchHands + 1e-9);
+}
+
+// Adds the counters of the results of one thread to the merged results.
+void EquityCalculatorBase::mergeResults(const Results& threadResults, Results& results)
+{
+    for (unsigned i = 0; i < results.players; ++i) {
+        results.wins[i] += threadResults.wins[i];
+        results.ties[i] += threadResults.ties[i];
+        for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+            results.handCategories[i][j] += threadResults.handCategories[i][j];
+    }
+    for (unsigned i = 0; i < (1u << results.players); ++i)
+        results.winsByPlayerMask[i] += threadResults.winsByPlayerMask[i];
+    results.hands += threadResults.hands;
+    results.evaluations += threadResults.evaluations;
+    results.cacheHits += threadResults.cacheHits;
+    results.cacheMisses += threadResults.cacheMisses;
+    results.cacheEvictions += threadResults.cacheEvictions;
+    results.skippedPreflopCombos += threadResults.skippedPreflopCombos;
+    results.evaluatedPreflopCombos += threadResults.evaluatedPreflopCombos;
+}
+
+}
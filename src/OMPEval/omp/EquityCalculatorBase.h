@@ -0,0 +1,274 @@
+#ifndef OMP_EQUITY_CALCULATOR_BASE_H
+#define OMP_EQUITY_CALCULATOR_BASE_H
+
+#include "Random.h"
+#include "Constants.h"
+#include "Util.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#if OMP_SSE2
+    #include <emmintrin.h> // SSE2
+#endif
+
+namespace omp {
+
+// Calculation driver that is shared by the equity calculators of different games: starts the threads, hands out the
+// enumeration indexes, gives each thread its own random number stream, tallies the showdowns and merges the results
+// of the threads for the periodic updates. The calculators implement start() and the thread functions.
+class EquityCalculatorBase
+{
+public:
+    struct Results
+    {
+        // Number of players.
+        unsigned players = 0;
+        // Equity by player (between 0 and 1).
+        double equity[MAX_PLAYERS] = {};
+        // Wins by player.
+        uint64_t wins[MAX_PLAYERS] = {};
+        // Ties by player, adjusted for equity: 2-way splits = 1/2, 3-way = 1/3 etc..
+        double ties[MAX_PLAYERS] = {};
+        // Wins for each combination of winning players. Index ranges from 0 to 2^(n-1), where
+        // bit 0 is player 1, bit 1 player 2 etc).
+        uint64_t winsByPlayerMask[1 << MAX_PLAYERS] = {};
+        // Showdowns by player and hand category (rank / 4096, 1=highcard, 2=pair etc.). Counted with the same
+        // weights as the wins, so in the final results each row sums up to the hand count.
+        uint64_t handCategories[MAX_PLAYERS][HAND_CATEGORY_COUNT] = {};
+        // Total hand count / hand count for last update period.
+        uint64_t hands = 0, intervalHands = 0;
+        // Total speed in hands/s / speed for last update period.
+        double speed = 0, intervalSpeed = 0;
+        // Total duration / duration of the last update period.
+        double time = 0, intervalTime = 0;
+        // Standard deviation for the total equity of first player.
+        double stdev = 0;
+        // Single-hand standard deviation.
+        double stdevPerHand = 0;
+        // Progress from 0 to 1. Based on hand count for enumeration, and stdev target for monte carlo.
+        double progress = 0;
+        // Number of different combinations of starting hands for all players.
+        uint64_t preflopCombos = 0;
+        // Number of preflop combos that were skipped due the having same cards. (Enumeration only.)
+        uint64_t skippedPreflopCombos = 0;
+        // How many of the preflop combos were actually enumerated.
+        uint64_t evaluatedPreflopCombos = 0;
+        // Preflop results cache statistics: lookups that found a result, lookups that didn't and entries that were
+        // replaced by new ones. (Preflop-major enumeration only.)
+        uint64_t cacheHits = 0, cacheMisses = 0, cacheEvictions = 0;
+        // How many showdowns were actually evaluated (instead of using lookups or isomorphism). Board-major
+        // enumeration ranks combos instead, and counts one showdown for as many ranked combos as there are players.
+        uint64_t evaluations = 0;
+        // Whether enumeration or monte carlo was used.
+        bool enumerateAll = false;
+        // Is calculation finished. (Includes stopping.)
+        bool finished = false;
+    };
+
+    // Force current calculation to stop before it's ready. Still must call wait()!
+    void stop()
+    {
+        mStopped = true;
+    }
+
+    // Wait for calculation to finish. Must always be called once for every successful start() call!
+    void wait()
+    {
+        for (auto& t : mThreads)
+            t.join();
+    }
+
+    // Set a time limit for the calculation in seconds. Use 0 to disable. Disabled by default.
+    void setTimeLimit(double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTimeLimit = seconds <= 0 ? INFINITE : seconds;
+    }
+
+    // Set a hand limit for the calculation or 0 to disable. Disabled by default.
+    void setHandLimit(uint64_t handLimit)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHandLimit = handLimit == 0 ? INFINITE : handLimit;
+    }
+
+    // Seed the random numbers of monte carlo simulation, or use 0 for a random seed. 0 by default. Each thread gets
+    // its own stream of the generator, and stops on its own share of the hand limit and of the stdev target, so
+    // the same seed and thread count always give the same results (unless stopped by the time limit or stop()).
+    void setSeed(uint64_t seed)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSeed = seed;
+    }
+
+    // Get results from previous update.
+    Results getResults()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mUpdateResults;
+    }
+
+protected:
+    typedef XoroShiro128Plus Rng;
+
+    static const uint64_t INFINITE = ~0ull;
+    // The data of different threads is kept on separate cache lines to avoid false sharing.
+    static const unsigned CACHE_LINE_SIZE = 64;
+    // Batches that a thread of a seeded simulation needs before its stdev is compared to the target.
+    static const unsigned MIN_STDEV_BATCHES = 32;
+    // Enumeration batches are sized to take about this many seconds.
+    static constexpr double BATCH_DURATION = 0.005;
+    // addShowdown() reads the ranks of all players with one 8-lane load, so rank arrays need this many extra elements
+    // after the last player.
+    static const unsigned SHOWDOWN_PADDING = 8 - MAX_PLAYERS;
+    static_assert(MAX_PLAYERS <= 8, "Showdown ranks must fit in one SSE register.");
+
+    // Temporary storage for results.
+    struct BatchResults
+    {
+        BatchResults(unsigned nplayers)
+        {
+            for (unsigned i = 0; i < nplayers; ++i)
+                playerIds[i] = i;
+        }
+
+        uint64_t skippedPreflopCombos = 0;
+        uint64_t uniquePreflopCombos = 0;
+        uint64_t evalCount = 0;
+        uint64_t cacheHits = 0, cacheMisses = 0, cacheEvictions = 0;
+        uint8_t playerIds[MAX_PLAYERS];
+        unsigned winsByPlayerMask[1 << MAX_PLAYERS] = {};
+        unsigned handCategories[MAX_PLAYERS][HAND_CATEGORY_COUNT] = {};
+    };
+
+    // Enumeration indexes of one thread. The owner takes batches from the front and threads that run out of work
+    // steal the back half. Each queue starts on a cache line of its own, and new[] needs to be told about it.
+    struct alignas(CACHE_LINE_SIZE) WorkQueue
+    {
+        static void* operator new[](size_t size) { return alignedNew(size, CACHE_LINE_SIZE); }
+        static void operator delete[](void* p) { alignedDelete(p); }
+
+        std::mutex mutex;
+        uint64_t begin = 0, end = 0;
+        // Only used by the owner.
+        std::chrono::high_resolution_clock::time_point lastBatchTime;
+        uint64_t lastBatchSize = 0;
+        double costPerIndex = 0;
+    };
+
+    // Results that one thread has flushed so far, so that threads only share a lock with the periodic update. Cache
+    // line aligned like WorkQueue.
+    struct alignas(CACHE_LINE_SIZE) ThreadResults
+    {
+        static void* operator new[](size_t size) { return alignedNew(size, CACHE_LINE_SIZE); }
+        static void operator delete[](void* p) { alignedDelete(p); }
+
+        std::mutex mutex;
+        Results results;
+        double batchSum = 0, batchSumSqr = 0, batchCount = 0; // Equities of the batches for stdev calculation.
+    };
+
+    // Seeds the generator of a new calculation with the seed, or randomly if there's none. Called first in start(),
+    // so that the ranges can be shuffled with it.
+    void seedRng(bool enumerateAll);
+
+    // Resets the results and the shared state of a new calculation and spawns threadCount threads that run
+    // threadFunction(threadIdx). The enumSize enumeration indexes are split evenly between the work queues of the
+    // threads. preflopCombos is reported in the results.
+    void startThreads(unsigned players, bool enumerateAll, uint64_t enumSize, uint64_t preflopCombos,
+                      double stdevTarget, std::function<void(const Results&)> callback, double updateInterval,
+                      unsigned threadCount, std::function<void(unsigned)> threadFunction);
+
+    // Determines the winners of a single showdown from the hand ranks of each player and stores the result.
+    template<unsigned tPlayers>
+    OMP_FORCE_INLINE static void addShowdown(const uint16_t* ranks, BatchResults* stats, unsigned weight)
+    {
+        ++stats->evalCount;
+        stats->winsByPlayerMask[getWinners<tPlayers>(ranks)] += weight;
+        for (unsigned i = 0; i < tPlayers; ++i)
+            stats->handCategories[i][ranks[i] >> HAND_CATEGORY_SHIFT] += weight;
+    }
+
+    // Returns the bitmask of players that have the best rank. The rank array must have SHOWDOWN_PADDING readable
+    // elements after the last player.
+    template<unsigned tPlayers>
+    OMP_FORCE_INLINE static unsigned getWinners(const uint16_t* ranks)
+    {
+        #if OMP_SSE2
+        // Compare all players at once: take the horizontal maximum of the ranks and build the winner mask from the
+        // lanes that are equal to it. SSE2 only has a signed 16-bit max, so the ranks are biased by 0x8000. The lanes
+        // of missing players are cleared before that, which makes them smaller than any real rank.
+        const __m128i lanes = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+        __m128i players = _mm_cmpgt_epi16(_mm_set1_epi16((short)tPlayers), lanes);
+        __m128i r = _mm_and_si128(_mm_loadu_si128((const __m128i*)ranks), players);
+        r = _mm_xor_si128(r, _mm_set1_epi16(-0x8000));
+        __m128i best = _mm_max_epi16(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(1, 0, 3, 2)));
+        best = _mm_max_epi16(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+        best = _mm_max_epi16(best, _mm_shufflehi_epi16(_mm_shufflelo_epi16(best, _MM_SHUFFLE(2, 3, 0, 1)),
+                                                       _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128i winners = _mm_cmpeq_epi16(r, best);
+        unsigned winnersMask = _mm_movemask_epi8(_mm_packs_epi16(winners, _mm_setzero_si128()));
+        #else
+        unsigned bestRank = 0;
+        unsigned winnersMask = 0;
+        for (unsigned i = 0, m = 1; i < tPlayers; ++i, m <<= 1) {
+            unsigned rank = ranks[i];
+            if (rank > bestRank) {
+                bestRank = rank;
+                winnersMask = m;
+            } else if (rank == bestRank) {
+                winnersMask |= m;
+            }
+        }
+        #endif
+        return winnersMask;
+    }
+
+    std::pair<uint64_t,uint64_t> reserveBatch(unsigned queueIdx, uint64_t firstBatchSize);
+    bool stealWork(unsigned queueIdx);
+    Rng getThreadRng(unsigned threadIdx) const;
+    bool updateResults(const BatchResults& stats, unsigned threadIdx, bool threadFinished);
+    void publishResults(double time, bool finished);
+    static double combineResults(const BatchResults& batch, Results& results);
+    static void mergeResults(const Results& threadResults, Results& results);
+
+    std::vector<std::thread> mThreads;
+
+    // Shared between threads, protected by mMutex.
+    std::mutex mMutex;
+    Results mResults, mUpdateResults;
+
+    // Shared between threads without locking.
+    std::atomic<bool> mStopped;
+    std::atomic<unsigned> mUnfinishedThreads;
+    std::atomic<uint64_t> mHandCount;
+    std::atomic<double> mNextUpdateTime; // Seconds from mStartTime.
+    std::chrono::high_resolution_clock::time_point mStartTime;
+    Rng mRng{0}; // Seeded in start(), the threads use jumped copies.
+    bool mReproducible = false; // Seeded monte carlo, where the threads stop independently.
+    uint64_t mEnumSize = 0, mPreflopCombos = 0;
+
+    // Results of each thread, merged by the periodic update.
+    std::unique_ptr<ThreadResults[]> mThreadResults;
+    unsigned mThreadCount = 0;
+
+    // Work of the enumeration threads. mEnumPosition is the number of indexes handed out so far.
+    std::unique_ptr<WorkQueue[]> mWorkQueues;
+    unsigned mWorkQueueCount = 0;
+    std::atomic<uint64_t> mEnumPosition;
+
+    // Settings of the calculation.
+    double mStdevTarget = 5e-5, mTimeLimit = (double)INFINITE, mUpdateInterval = 0.1;
+    uint64_t mHandLimit = INFINITE;
+    uint64_t mSeed = 0;
+    std::function<void(const Results& results)> mCallback;
+};
+
+}
+
+#endif // OMP_EQUITY_CALCULATOR_BASE_H
@@ -239,7 +239,10 @@ private:
     uint64_t mMask;
     #endif
 
-    friend class HandEvaluator;
+    friend class HandEvaluatorBase;
+    template<class> friend class BasicHandEvaluator;
+    template<class> friend struct BatchKernels;
+    friend class CompactHandEvaluator;
 };
 
 }
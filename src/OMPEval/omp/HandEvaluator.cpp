@@ -1,40 +1,41 @@
 #include "HandEvaluator.h"
 
 #include "OffsetTable.hxx"
+#include "LookupTables.hxx"
 #include "Util.h"
-#include <vector>
-#include <iostream>
 #include <algorithm>
-#include <utility>
 #include <cstring>
+#include <cstdlib>
+
+// Batch kernels for instruction sets above the compile time baseline are built with target attributes and chosen
+// at runtime, so that one binary runs on any x86 CPU. MSVC allows all intrinsics without special flags.
+#if OMP_SSE2 && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+    #define OMP_DISPATCH 1
+    #include <immintrin.h>
+    #if _MSC_VER
+        #define OMP_TARGET(x)
+    #else
+        #define OMP_TARGET(x) __attribute__((target(x)))
+    #endif
+#endif
 
 namespace omp {
 
-// Rank multipliers that guarantee a unique key for every rank combination in a 0-7 card hand.
-const unsigned HandEvaluator::RANKS[]{0x2000, 0x8001, 0x11000, 0x3a000, 0x91000, 0x176005, 0x366000,
-        0x41a013, 0x47802e, 0x479068, 0x48c0e4, 0x48f211, 0x494493};
-
-// Rank multipliers for flush hands where only 1 of each rank is allowed. We could choose smaller numbers here but
-// we want to get the key from a bitmask, so powers of 2 are used.
-const unsigned HandEvaluator::FLUSH_RANKS[]{1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
-
+constexpr unsigned HandEvaluatorBase::RANKS[];
+constexpr unsigned HandEvaluatorBase::FLUSH_RANKS[];
 Hand Hand::CARDS[]{};
 const Hand Hand::EMPTY(0x3333ull << SUITS_SHIFT, 0);
-uint16_t HandEvaluator::LOOKUP[]{};
-uint16_t* HandEvaluator::ORIG_LOOKUP = nullptr;
-uint16_t HandEvaluator::FLUSH_LOOKUP[]{};
-const unsigned HandEvaluator::MAX_KEY = 4 * RANKS[12] + 3 * RANKS[11];
-bool HandEvaluator::cardInit = (initCardConstants(), true);
+bool HandEvaluatorBase::cardInit = (initCardConstants(), true);
+HandEvaluatorBase::Kernel HandEvaluatorBase::activeKernel = HandEvaluatorBase::KERNEL_SCALAR;
 
-// Does a thread-safe (guaranteed by C++11) one time initialization of static data.
-HandEvaluator::HandEvaluator()
+HandEvaluatorBase::HandEvaluatorBase()
 {
-    static bool initVar = (staticInit(), true);
+    static bool initVar = (selectKernel(), true);
     (void)initVar;
 }
 
 // Initialize card constants.
-void HandEvaluator::initCardConstants()
+void HandEvaluatorBase::initCardConstants()
 {
     for (unsigned c = 0; c < CARD_COUNT; ++c) {
         unsigned rank = c / 4, suit = c % 4;
@@ -43,228 +44,274 @@ void HandEvaluator::initCardConstants()
     }
 }
 
-// Initialize static class data.
-void HandEvaluator::staticInit()
+// Batch evaluation kernels. All of them give the same results as BasicHandEvaluator<TDeck>::evaluate(). The hands are
+// read as raw 16-byte blocks (32-bit rank key, 32-bit counters, 64-bit card mask), which is the layout of Hand
+// regardless of build options.
+template<class TDeck>
+struct BatchKernels
 {
-    // Temporary table for hash recalculation.
-    if (RECALCULATE_PERF_HASH_OFFSETS)
-        ORIG_LOOKUP = new uint16_t[MAX_KEY + 1];
-
-    static const unsigned RC = RANK_COUNT;
-
-    // 1. High card
-    unsigned handValue = HIGH_CARD;
-    handValue = populateLookup(0, 0, handValue, RC, 0, 0, 0);
-
-    // 2. Pair
-    handValue = PAIR;
-    for (unsigned r = 0; r < RC; ++r)
-        handValue = populateLookup(2ull << 4 * r, 2, handValue, RC, 0, 0, 0);
-
-    // 3. Two pairs
-    handValue = TWO_PAIR;
-    for (unsigned r1 = 0; r1 < RC; ++r1)
-        for (unsigned r2 = 0; r2 < r1; ++r2)
-            handValue = populateLookup((2ull << 4 * r1) + (2ull << 4 * r2), 4, handValue, RC, r2, 0, 0);
-
-    // 4. Three of a kind
-    handValue = THREE_OF_A_KIND;
-    for (unsigned r = 0; r < RC; ++r)
-        handValue = populateLookup(3ull << 4 * r, 3, handValue, RC, 0, r, 0);
-
-    // 4. Straight
-    handValue = STRAIGHT;
-    handValue = populateLookup(0x1000000001111ull, 5, handValue, RC, RC, RC, 3); // wheel
-    for (unsigned r = 4; r < RC; ++r)
-        handValue = populateLookup(0x11111ull << 4 * (r - 4), 5, handValue, RC, RC, RC, r);
-
-    // 6. FLUSH
-    handValue = FLUSH;
-    handValue = populateLookup(0, 0, handValue, RC, 0, 0, 0, true);
-
-    // 7. Full house
-    handValue = FULL_HOUSE;
-    for (unsigned r1 = 0; r1 < RC; ++r1)
-        for (unsigned r2 = 0; r2 < RC; ++r2)
-            if (r2 != r1)
-                handValue = populateLookup((3ull << 4 * r1) + (2ull << 4 * r2), 5, handValue, RC, r2, r1, RC);
-
-    // 8. Quads
-    handValue = FOUR_OF_A_KIND;
-    for (unsigned r = 0; r < RC; ++r)
-        handValue = populateLookup(4ull << 4 * r, 4, handValue, RC, RC, RC, RC);
+    typedef BasicHandEvaluator<TDeck> HE;
+
+    template<bool tFlushPossible>
+    static void scalar(const Hand* hands, uint16_t* ranks, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (!tFlushPossible || !hands[i].hasFlush())
+                ranks[i] = HE::LOOKUP[HE::perfHash(hands[i].rankKey())];
+            else
+                ranks[i] = HE::FLUSH_LOOKUP[hands[i].flushKey() >> TDeck::LOWEST_RANK];
+        }
+    }
 
-    // 9. Straight flush
-    handValue = STRAIGHT_FLUSH;
-    handValue = populateLookup(0x1000000001111ull, 5, handValue, RC, 0, 0, 3, true); // low straight flush
-    for (unsigned r = 4; r < RC; ++r)
-        handValue = populateLookup(0x11111ull << 4 * (r - 4), 5, handValue, RC, 0, 0, r, true);
+    static void activate(typename HE::Kernel kernel)
+    {
+        HE::batchFunctions[0] = function(kernel, false);
+        HE::batchFunctions[1] = function(kernel, true);
+    }
 
-    if (RECALCULATE_PERF_HASH_OFFSETS) {
-        calculatePerfectHashOffsets();
-        delete[] ORIG_LOOKUP;
+    static typename HE::BatchFunction function(typename HE::Kernel kernel, bool flushPossible)
+    {
+        switch (kernel) {
+        #if OMP_DISPATCH
+        case HE::KERNEL_SSE4:
+            return flushPossible ? sse4<true> : sse4<false>;
+        case HE::KERNEL_AVX2:
+            return flushPossible ? avx2<true> : avx2<false>;
+        case HE::KERNEL_AVX512:
+            return flushPossible ? avx512<true> : avx512<false>;
+        #endif
+        default:
+            return nullptr;
+        }
     }
-}
 
-// Iterates recursively over the the remaining cards ranks in a hand and writes the hand values for each combination
-// to lookup table. Parameters maxPair, maxTrips, maxStraight are used for checking that the hand
-// doesn't improve (except kickers).
-unsigned HandEvaluator::populateLookup(uint64_t ranks, unsigned ncards, unsigned handValue, unsigned endRank,
-                                            unsigned maxPair, unsigned maxTrips, unsigned maxStraight, bool flush)
-{
-    // Only increment hand value counter for every valid 5 card combination. (Or smaller hands if enabled.)
-    if (ncards <= 5 && ncards >= (MIN_CARDS < 5 ? MIN_CARDS : 5))
-        ++handValue;
+    #if OMP_DISPATCH
+    // Scalar lookups, but the key extraction and flush check are done with single SSE4 instructions.
+    template<bool tFlushPossible>
+    OMP_TARGET("sse4.1") static void sse4(const Hand* hands, uint16_t* ranks, size_t count)
+    {
+        const __m128i flushCheckMask = _mm_set_epi32(0, 0, Hand::FLUSH_CHECK_MASK32, 0);
+        for (size_t i = 0; i < count; ++i) {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hands + i));
+            if (!tFlushPossible || _mm_testz_si128(h, flushCheckMask))
+                ranks[i] = HE::LOOKUP[HE::perfHash(_mm_cvtsi128_si32(h))];
+            else
+                ranks[i] = HE::FLUSH_LOOKUP[hands[i].flushKey() >> TDeck::LOWEST_RANK];
+        }
+    }
 
-    // Write hand value to lookup when we have required number of cards.
-    if (ncards >= MIN_CARDS || (flush && ncards >= 5)) {
-        unsigned key = getKey(ranks, flush);
+    // Evaluates 8 hands at a time. The hands are read with regular (or masked) loads and only the two table lookups
+    // use gathers.
+    template<bool tFlushPossible>
+    OMP_TARGET("avx2") static void avx2(const Hand* hands, uint16_t* ranks, size_t count)
+    {
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        for (size_t i = 0; i < count; i += 8) {
+            unsigned n = count - i < 8 ? (unsigned)(count - i) : 8;
+
+            // Each 256-bit load contains two hands. First combine the low 64 bits (key & counters) of all hands,
+            // then separate keys and counters. The shuffles work within 128-bit lanes, so the order needs fixing.
+            const __m256i* p = reinterpret_cast<const __m256i*>(hands + i);
+            __m256i h01, h23, h45, h67;
+            if (n == 8) {
+                h01 = _mm256_loadu_si256(p);
+                h23 = _mm256_loadu_si256(p + 1);
+                h45 = _mm256_loadu_si256(p + 2);
+                h67 = _mm256_loadu_si256(p + 3);
+            } else {
+                // Only the key qwords of the existing hands are loaded, so nothing is read past the end of the input.
+                const long long* q = reinterpret_cast<const long long*>(hands + i);
+                __m256i qwordIdx = _mm256_setr_epi64x(0, 1, 2, 3);
+                const __m256i keyQwords = _mm256_setr_epi64x(-1, 0, -1, 0);
+                const __m256i step = _mm256_set1_epi64x(4);
+                const __m256i limit = _mm256_set1_epi64x(2 * n);
+                h01 = _mm256_maskload_epi64(q, _mm256_and_si256(keyQwords, _mm256_cmpgt_epi64(limit, qwordIdx)));
+                qwordIdx = _mm256_add_epi64(qwordIdx, step);
+                h23 = _mm256_maskload_epi64(q + 4, _mm256_and_si256(keyQwords, _mm256_cmpgt_epi64(limit, qwordIdx)));
+                qwordIdx = _mm256_add_epi64(qwordIdx, step);
+                h45 = _mm256_maskload_epi64(q + 8, _mm256_and_si256(keyQwords, _mm256_cmpgt_epi64(limit, qwordIdx)));
+                qwordIdx = _mm256_add_epi64(qwordIdx, step);
+                h67 = _mm256_maskload_epi64(q + 12, _mm256_and_si256(keyQwords, _mm256_cmpgt_epi64(limit, qwordIdx)));
+            }
+            __m256 lo0123 = _mm256_castsi256_ps(_mm256_unpacklo_epi64(h01, h23));
+            __m256 lo4567 = _mm256_castsi256_ps(_mm256_unpacklo_epi64(h45, h67));
+            __m256i keys = _mm256_permutevar8x32_epi32(_mm256_castps_si256(
+                    _mm256_shuffle_ps(lo0123, lo4567, _MM_SHUFFLE(2, 0, 2, 0))), order);
+
+            // Perfect hash: key + PERF_HASH_ROW_OFFSETS[key >> PERF_HASH_ROW_SHIFT]. The 16-bit table entries are
+            // gathered as 32-bit words (LOOKUP is padded for that) and the upper half is masked away.
+            __m256i rows = _mm256_srli_epi32(keys, HE::PERF_HASH_ROW_SHIFT);
+            __m256i offsets = _mm256_i32gather_epi32(reinterpret_cast<const int*>(HE::PERF_HASH_ROW_OFFSETS), rows, 4);
+            __m256i idx = _mm256_add_epi32(keys, offsets);
+            __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int*>(HE::LOOKUP), idx, 2);
+            values = _mm256_and_si256(values, _mm256_set1_epi32(0xffff));
+
+            // Pack to 16 bits. Again packus works within 128-bit lanes, so the 64-bit quarters need to be reordered.
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+            if (n == 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(ranks + i), _mm256_castsi256_si128(packed));
+            } else {
+                alignas(16) uint16_t tmp[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(tmp), _mm256_castsi256_si128(packed));
+                std::memcpy(ranks + i, tmp, n * sizeof(uint16_t));
+            }
 
-        // Write flush and non-flush hands in different tables
-        if (flush) {
-            FLUSH_LOOKUP[key] = handValue;
-        } else if (RECALCULATE_PERF_HASH_OFFSETS) {
-            ORIG_LOOKUP[key] = handValue;
-        } else {
-            omp_assert(LOOKUP[perfHash(key)] == 0 || LOOKUP[perfHash(key)] == handValue);
-            LOOKUP[perfHash(key)] = handValue;
+            if (tFlushPossible) {
+                __m256i counters = _mm256_permutevar8x32_epi32(_mm256_castps_si256(
+                        _mm256_shuffle_ps(lo0123, lo4567, _MM_SHUFFLE(3, 1, 3, 1))), order);
+                __m256i flushBits = _mm256_and_si256(counters, _mm256_set1_epi32(Hand::FLUSH_CHECK_MASK32));
+                __m256i noFlush = _mm256_cmpeq_epi32(flushBits, _mm256_setzero_si256());
+                unsigned flushes = ~_mm256_movemask_ps(_mm256_castsi256_ps(noFlush)) & ((1u << n) - 1);
+                while (flushes) {
+                    unsigned j = i + countTrailingZeros(flushes);
+                    ranks[j] = HE::FLUSH_LOOKUP[hands[j].flushKey() >> TDeck::LOWEST_RANK];
+                    flushes &= flushes - 1;
+                }
+            }
         }
+    }
 
-        if (ncards == 7)
-            return handValue;
+    // GCC 12 warns about the _mm512_undefined_epi32() used inside the AVX-512 intrinsics.
+    #if __GNUC__ && !__clang__
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    #endif
+
+    // Same as the AVX2 kernel but 16 hands at a time. Partial batches use masked loads and stores.
+    template<bool tFlushPossible>
+    OMP_TARGET("avx512f,avx512bw,avx512vl") static void avx512(const Hand* hands, uint16_t* ranks, size_t count)
+    {
+        // Picks the keys (low 8 dwords) and counters (high 8 dwords) of the 8 hands in two registers.
+        const __m512i split = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+        for (size_t i = 0; i < count; i += 16) {
+            unsigned n = count - i < 16 ? (unsigned)(count - i) : 16;
+
+            // Each 512-bit load contains four hands.
+            const int* p = reinterpret_cast<const int*>(hands + i);
+            __m512i h[4];
+            for (unsigned j = 0; j < 4; ++j) {
+                if (n == 16) {
+                    h[j] = _mm512_loadu_si512(p + 16 * j);
+                } else {
+                    unsigned handsLeft = n > 4 * j ? std::min(n - 4 * j, 4u) : 0;
+                    h[j] = _mm512_maskz_loadu_epi32((__mmask16)((1u << (4 * handsLeft)) - 1), p + 16 * j);
+                }
+            }
+            __m512i lo = _mm512_permutex2var_epi32(h[0], split, h[1]);
+            __m512i hi = _mm512_permutex2var_epi32(h[2], split, h[3]);
+            __m512i keys = _mm512_shuffle_i64x2(lo, hi, _MM_SHUFFLE(1, 0, 1, 0));
+
+            // Missing hands have key 0, which is a valid index, so the gathers don't need masking. The conversion to
+            // 16 bits truncates away the neighbouring table entry.
+            __m512i rows = _mm512_srli_epi32(keys, HE::PERF_HASH_ROW_SHIFT);
+            __m512i offsets = _mm512_i32gather_epi32(rows, HE::PERF_HASH_ROW_OFFSETS, 4);
+            __m512i values = _mm512_i32gather_epi32(_mm512_add_epi32(keys, offsets), HE::LOOKUP, 2);
+            __mmask16 valid = (__mmask16)((1u << n) - 1);
+            _mm256_mask_storeu_epi16(ranks + i, valid, _mm512_cvtepi32_epi16(values));
+
+            if (tFlushPossible) {
+                __m512i counters = _mm512_shuffle_i64x2(lo, hi, _MM_SHUFFLE(3, 2, 3, 2));
+                unsigned flushes = _mm512_mask_test_epi32_mask(valid, counters,
+                                                               _mm512_set1_epi32(Hand::FLUSH_CHECK_MASK32));
+                while (flushes) {
+                    unsigned j = i + countTrailingZeros(flushes);
+                    ranks[j] = HE::FLUSH_LOOKUP[hands[j].flushKey() >> TDeck::LOWEST_RANK];
+                    flushes &= flushes - 1;
+                }
+            }
+        }
     }
 
-    // Iterate next card rank.
-    for (unsigned r = 0; r < endRank; ++r) {
-        uint64_t newRanks = ranks + (1ull << (4 * r));
+    #if __GNUC__ && !__clang__
+    #pragma GCC diagnostic pop
+    #endif
+    #endif
+};
 
-        // Check that hand doesn't improve.
-        unsigned rankCount = ((newRanks >> (r * 4)) & 0xf);
-        if (rankCount == 2 && r >= maxPair)
-            continue;
-        if (rankCount == 3 && r >= maxTrips)
-            continue;
-        if (rankCount >= 4) // Don't allow new quads or more than 4 of same rank.
-            continue;
-        if (getBiggestStraight(newRanks) > maxStraight)
-            continue;
+// Kernel names used in the OMP_EVAL_KERNEL environment variable.
+static const char* const KERNEL_IDS[HandEvaluatorBase::KERNEL_COUNT]{"scalar", "sse4", "avx2", "avx512"};
 
-        handValue = populateLookup(newRanks, ncards + 1, handValue, r + 1, maxPair, maxTrips, maxStraight, flush);
+// Checks whether the CPU (and OS) supports the instructions used by a kernel.
+bool HandEvaluatorBase::isKernelSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case KERNEL_SCALAR:
+        return true;
+    #if OMP_DISPATCH && _MSC_VER
+    case KERNEL_SSE4:
+    case KERNEL_AVX2:
+    case KERNEL_AVX512:
+    {
+        int info[4];
+        __cpuidex(info, 1, 0);
+        bool sse4 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (kernel == KERNEL_SSE4 || !osxsave)
+            return sse4 && kernel == KERNEL_SSE4;
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        if (kernel == KERNEL_AVX2)
+            return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5));
+        // AVX-512 F, BW and VL, and the OS saving the opmask and upper zmm registers.
+        return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) && (info[1] & (1 << 30)) && (info[1] & (1u << 31));
+    }
+    #elif OMP_DISPATCH
+    case KERNEL_SSE4:
+        return __builtin_cpu_supports("sse4.1");
+    case KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case KERNEL_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+                && __builtin_cpu_supports("avx512vl");
+    #endif
+    default:
+        return false;
     }
-
-    return handValue;
 }
 
-// Calculate lookup table key from rank counts.
-unsigned HandEvaluator::getKey(uint64_t ranks, bool flush)
+bool HandEvaluatorBase::setKernel(Kernel kernel)
 {
-    unsigned key = 0;
-    for (unsigned r = 0; r < RANK_COUNT; ++r)
-        key += ((ranks >> r * 4) & 0xf) * (flush ? FLUSH_RANKS[r] : RANKS[r]);
-    return key;
+    if (kernel >= KERNEL_COUNT || !isKernelSupported(kernel))
+        return false;
+    HandEvaluatorBase eval; // Make sure that static init (which selects the default kernel) has already run.
+    (void)eval;
+    activateKernel(kernel);
+    return true;
 }
 
-// Returns index of the highest straight card or 0 when no straight.
-unsigned HandEvaluator::getBiggestStraight(uint64_t ranks)
+const char* HandEvaluatorBase::kernelName(Kernel kernel)
 {
-    uint64_t rankMask = (0x1111111111111 & ranks) | (0x2222222222222 & ranks) >> 1 | (0x4444444444444 & ranks) >> 2;
-    for (unsigned i = 9; i-- > 0; )
-        if (((rankMask >> 4 * i) & 0x11111ull) == 0x11111ull)
-            return i + 4;
-    if ((rankMask & 0x1000000001111) == 0x1000000001111)
-        return 3;
-    return 0;
+    static const char* const NAMES[KERNEL_COUNT]{"scalar", "SSE4", "AVX2", "AVX-512"};
+    return kernel < KERNEL_COUNT ? NAMES[kernel] : "unknown";
 }
 
-// Perfect hashing based on the algorithm described in
-// http://www.drdobbs.com/architecture-and-design/generating-perfect-hash-functions/184404506
-void HandEvaluator::calculatePerfectHashOffsets()
+// Selects the kernel for evaluateBatch(): the highest instruction set that the CPU supports, so the choice only
+// depends on the CPU and costs nothing at startup. The OMP_EVAL_KERNEL environment variable can be used to force a
+// specific kernel, e.g. on CPUs where gathers are slower than scalar lookups.
+void HandEvaluatorBase::selectKernel()
 {
-    // Store locations of all non-zero elements in original lookup table, divided into rows.
-    std::vector<std::pair<size_t,std::vector<size_t>>> rows;
-    for (size_t i = 0; i < MAX_KEY + 1; ++i) {
-        if (ORIG_LOOKUP[i]) {
-            size_t rowIdx = i >> PERF_HASH_ROW_SHIFT;
-            if (rowIdx >= rows.size())
-                rows.resize(rowIdx + 1);
-            rows[rowIdx].second.push_back(i);
-        }
-    }
-
-    // Need to store the original row indexes because we need them after sorting.
-    for (size_t i = 0; i < rows.size(); ++i)
-        rows[i].first = i;
-
-    // Try to fit the densest rows first. Results in slightly smaller table.
-    std::sort(rows.begin(), rows.end(), [](const std::pair<size_t,std::vector<size_t>>& lhs,
-              const std::pair<size_t,std::vector<size_t>> & rhs){
-        return lhs.second.size() > rhs.second.size();
-    });
-
-    // Goes through every row and for each of them try to find the first offset that doesn't cause any collisions with
-    // previous rows. Does a very naive brute force search.
-    size_t maxIdx = 0;
-    for (size_t i = 0; i < rows.size(); ++i) {
-        size_t offset = 0; //-(rows[i].second[0] & PERF_HASH_COLUMN_MASK); makes no difference so let's avoid negative
-        for (;;++offset) {
-            bool ok = true;
-            for (auto x : rows[i].second) {
-                unsigned val = LOOKUP[(x & PERF_HASH_COLUMN_MASK) + offset];
-                if (val && val != ORIG_LOOKUP[x]) { // Allow collisions if value is the same
-                    ok = false;
-                    break;
-                }
+    const char* forced = std::getenv("OMP_EVAL_KERNEL");
+    if (forced) {
+        for (unsigned k = 0; k < KERNEL_COUNT; ++k) {
+            if (std::strcmp(forced, KERNEL_IDS[k]) == 0 && isKernelSupported((Kernel)k)) {
+                activateKernel((Kernel)k);
+                return;
             }
-            if (ok)
-                break;
-        }
-        //std::cout << "row=" << i << " size=" << rows[i].second.size() << " offset=" << offset << std::endl;
-        PERF_HASH_ROW_OFFSETS[rows[i].first] = (uint32_t)(offset - (rows[i].first << PERF_HASH_ROW_SHIFT));
-        for (size_t key : rows[i].second) {
-            size_t newIdx = (key & PERF_HASH_COLUMN_MASK) + offset;
-            maxIdx = std::max<size_t>(maxIdx, newIdx);
-            LOOKUP[newIdx] = ORIG_LOOKUP[key];
         }
     }
 
-    // Output offset array.
-    std::cout << "offsets: " << std::endl;
-    for (size_t i = 0; i < rows.size(); ++i) {
-        if (i % 8 == 0)
-            std::cout << std::endl;
-        std::cout << std::hex << "0x" << PERF_HASH_ROW_OFFSETS[i] << std::dec << ", ";
-    }
-
-    // Output stats.
-    std::cout << std::endl;
-    outputTableStats("FLUSH_LOOKUP", FLUSH_LOOKUP, 2, FLUSH_LOOKUP_SIZE);
-    outputTableStats("ORIG_LOOKUP", ORIG_LOOKUP, 2, MAX_KEY + 1);
-    outputTableStats("LOOKUP", LOOKUP, 2, maxIdx + 1);
-    outputTableStats("OFFSETS", PERF_HASH_ROW_OFFSETS, 4, rows.size());
-    std::cout << "lookup table size: " << maxIdx + 1 << std::endl;
-    std::cout << "offset table size: " << rows.size() << std::endl;
+    unsigned k = KERNEL_COUNT - 1;
+    while (!isKernelSupported((Kernel)k))
+        --k;
+    activateKernel((Kernel)k);
 }
 
-// Output stats about memory usage of a lookup table.
-void HandEvaluator::outputTableStats(const char* name, const void* p, size_t elementSize, size_t count)
+// Switches the batch functions of all decks to a kernel.
+void HandEvaluatorBase::activateKernel(Kernel kernel)
 {
-    char dummy[64]{};
-    size_t totalCacheLines = 0, usedCacheLines = 0, usedElements = 0;
-    for (size_t i = 0; i < elementSize * count; i += 64) {
-        ++totalCacheLines;
-        bool used = false;
-        for (size_t j = 0; j < 64 && i + j < elementSize * count; j += elementSize) {
-            if (std::memcmp((const char*)p + i + j, dummy, elementSize)) {
-                ++usedElements;
-                used = true;
-            }
-        }
-        usedCacheLines += used;
-    }
-    std::cout << name << ": cachelines: " << usedCacheLines << "/" << totalCacheLines
-         << "  kbytes: " << usedCacheLines / 16  << "/" << totalCacheLines / 16
-         << "  elements: " << usedElements << "/" << count
-         << std::endl;
+    activeKernel = kernel;
+    BatchKernels<StandardDeck>::activate(kernel);
+    BatchKernels<ShortDeck>::activate(kernel);
 }
 
 }
@@ -9,29 +9,118 @@
 
 namespace omp {
 
-// Evaluates hands with any number of cards up to 7.
-class HandEvaluator
+// Parts of the evaluator that are shared by all decks: the card constants and the selection of the batch kernel.
+class HandEvaluatorBase
 {
 public:
-    HandEvaluator();
+    // Instruction set levels of the batch evaluation kernels. The highest one supported by the CPU is chosen at
+    // startup.
+    enum Kernel { KERNEL_SCALAR, KERNEL_SSE4, KERNEL_AVX2, KERNEL_AVX512, KERNEL_COUNT };
+
+    // Returns the kernel currently used by evaluateBatch().
+    static Kernel kernel()
+    {
+        return activeKernel;
+    }
+
+    // Returns true if the kernel is compiled in and supported by the CPU.
+    static bool isKernelSupported(Kernel kernel);
+
+    // Forces evaluateBatch() of all decks to use a specific kernel. Returns false if the kernel isn't supported. Must
+    // not be called while other threads are evaluating hands.
+    static bool setKernel(Kernel kernel);
+
+    // Returns the name of a kernel, e.g. "AVX2".
+    static const char* kernelName(Kernel kernel);
+
+protected:
+    typedef void (*BatchFunction)(const Hand* hands, uint16_t* ranks, size_t count);
+
+    // Does a thread-safe (guaranteed by C++11) one time selection of the batch kernel. The lookup tables are
+    // compiled in.
+    HandEvaluatorBase();
+
+    // Rank multipliers for non-flush and flush hands. The non-flush ones guarantee a unique key for every rank
+    // combination in a 0-7 card hand. The flush ones are powers of 2 so that the key can be taken from a bitmask.
+    static constexpr unsigned RANKS[RANK_COUNT]{0x2000, 0x8001, 0x11000, 0x3a000, 0x91000, 0x176005, 0x366000,
+            0x41a013, 0x47802e, 0x479068, 0x48c0e4, 0x48f211, 0x494493};
+    static constexpr unsigned FLUSH_RANKS[RANK_COUNT]{1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+    static constexpr unsigned MAX_KEY = 4 * RANKS[12] + 3 * RANKS[11];
+
+    // Smallest batch that is handed to the batch kernel.
+    static const size_t MIN_KERNEL_BATCH = 4;
+
+private:
+    static bool cardInit;
+    static void initCardConstants();
+    static void selectKernel();
+    static void activateKernel(Kernel kernel);
+
+    static Kernel activeKernel;
+};
+
+// Evaluates hands with any number of cards up to 7. TDeck selects the rules (StandardDeck or ShortDeck). Each deck
+// has its own lookup tables, so the different hand ordering costs nothing at evaluation time.
+template<class TDeck>
+class BasicHandEvaluator : public HandEvaluatorBase
+{
+public:
+    typedef TDeck Deck;
 
     // Returns the rank of a hand as a 16-bit integer. Higher value is better. Can also rank hands with less than 5
     // cards. A missing card is considered the worst kicker, e.g. K < KQJT8 < A < AK < KKAQJ < AA < AA2 < AA4 < AA432.
-    // Hand category can be extracted by dividing the value by 4096. 1=highcard, 2=pair, etc.
+    // Hand category can be extracted by dividing the value by 4096. 1=highcard, 2=pair, etc. (see TDeck::FLUSH and
+    // TDeck::FULL_HOUSE for the decks where their order differs). The hand must not contain cards that are not in
+    // the deck.
     template<bool tFlushPossible = true>
     OMP_FORCE_INLINE uint16_t evaluate(const Hand& hand) const
     {
         omp_assert(hand.count() <= 7 && hand.count() == bitCount(hand.mask()));
+        omp_assert(!(hand.mask() & TDeck::UNUSED_CARDS));
         if (!tFlushPossible || !hand.hasFlush()) {
             uint32_t key = hand.rankKey();
             return LOOKUP[perfHash(key)];
         } else {
-            uint16_t flushKey = hand.flushKey();
+            unsigned flushKey = hand.flushKey() >> TDeck::LOWEST_RANK;
             omp_assert(flushKey < FLUSH_LOOKUP_SIZE);
             return FLUSH_LOOKUP[flushKey];
         }
     }
 
+    // Returns only the hand category: 1=highcard, 2=pair, ..., 9=straight flush. Same as evaluate() / 4096, but uses
+    // tables of 4-bit categories that are a quarter of the size of the rank tables, so they stay in cache better
+    // when the exact rank isn't needed.
+    template<bool tFlushPossible = true>
+    OMP_FORCE_INLINE unsigned evaluateCategory(const Hand& hand) const
+    {
+        omp_assert(hand.count() <= 7 && hand.count() == bitCount(hand.mask()));
+        if (!tFlushPossible || !hand.hasFlush()) {
+            unsigned idx = perfHash(hand.rankKey());
+            return (CATEGORY_LOOKUP[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
+        } else {
+            unsigned flushKey = hand.flushKey() >> TDeck::LOWEST_RANK;
+            omp_assert(flushKey < FLUSH_LOOKUP_SIZE);
+            bool straightFlush = (STRAIGHT_FLUSH_KEYS[flushKey >> 6] >> (flushKey & 63)) & 1;
+            return (straightFlush ? STRAIGHT_FLUSH : TDeck::FLUSH) >> HAND_CATEGORY_SHIFT;
+        }
+    }
+
+    // Evaluates multiple hands at once and writes their ranks to the output array. Gives the same results as calling
+    // evaluate() for each hand separately. Batches of MIN_KERNEL_BATCH or more hands are handed to the kernel
+    // selected at startup; the AVX2/AVX-512 kernels do the non-flush lookups 8/16 hands at a time using gather
+    // instructions and fix the ranks of flush hands with scalar lookups. Smaller batches are evaluated one by one,
+    // because the call and gather latency isn't worth it for just a couple of hands.
+    template<bool tFlushPossible = true>
+    OMP_FORCE_INLINE void evaluateBatch(const Hand* hands, uint16_t* ranks, size_t count) const
+    {
+        if (count >= MIN_KERNEL_BATCH && batchFunctions[tFlushPossible]) {
+            batchFunctions[tFlushPossible](hands, ranks, count);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i)
+            ranks[i] = evaluate<tFlushPossible>(hands[i]);
+    }
+
 private:
     static unsigned perfHash(unsigned key)
     {
@@ -39,41 +128,50 @@ private:
         return key + PERF_HASH_ROW_OFFSETS[key >> PERF_HASH_ROW_SHIFT];
     }
 
-    static bool cardInit;
-    static void initCardConstants();
-    static void staticInit();
-    static void calculatePerfectHashOffsets();
-    static unsigned populateLookup(uint64_t rankCounts, unsigned ncards, unsigned handValue, unsigned endRank,
-                                   unsigned maxPair, unsigned maxTrips, unsigned maxStraight, bool flush = false);
-    static unsigned getKey(uint64_t rankCounts, bool flush);
-    static unsigned getBiggestStraight(uint64_t rankCounts);
-    static void outputTableStats(const char* name, const void* p, size_t elementSize, size_t count);
+    // Batch kernels compiled for different instruction sets (defined in HandEvaluator.cpp).
+    template<class> friend struct BatchKernels;
+    // Build time generator of the lookup tables (gentables.cpp).
+    template<class> friend class TableGenerator;
+
+    // Determines in how many rows the original lookup table is divided (2^shift). More rows means slightly smaller
+    // lookup table but much bigger offset table. The short deck has so few keys that its rows can be wider.
+    static const unsigned PERF_HASH_ROW_SHIFT = TDeck::LOWEST_RANK ? 14 : 12;
 
-    // Rank multipliers for non-flush and flush hands.
-    static const unsigned RANKS[RANK_COUNT];
-    static const unsigned FLUSH_RANKS[RANK_COUNT];
+    // Batch functions of the active kernel for flush/no flush. Null functions mean inline scalar code.
+    static BatchFunction batchFunctions[2];
 
-    // Turn on to recalculate and output the offset array.
-    static const bool RECALCULATE_PERF_HASH_OFFSETS = false;
+    // Lookup tables, generated at build time by gentables (LookupTables.hxx, OffsetTable.hxx). They are constant so
+    // they end up in read-only data that is shared between processes. LOOKUP has one element of padding so that
+    // the last entry can be read with a 32-bit gather. Flush keys skip the ranks below TDeck::LOWEST_RANK.
+    static const size_t FLUSH_LOOKUP_SIZE = 1 << (RANK_COUNT - TDeck::LOWEST_RANK);
+    static const uint16_t LOOKUP[];
+    static const uint16_t FLUSH_LOOKUP[];
+    static const uint32_t PERF_HASH_ROW_OFFSETS[];
 
-    // Determines in how many rows the original lookup table is divided (2^shift). More rows means slightly smaller
-    // lookup table but much bigger offset table.
-    static const unsigned PERF_HASH_ROW_SHIFT = 12;
-    static const unsigned PERF_HASH_COLUMN_MASK = (1 << PERF_HASH_ROW_SHIFT) - 1;
-
-    // Minimum number of cards required for evaluating a hand. Can be set to higher value to decrease lookup
-    // table size (requires hash recalculation).
-    static const unsigned MIN_CARDS = 0;
-
-    // Lookup tables
-    static const unsigned MAX_KEY;
-    static const size_t FLUSH_LOOKUP_SIZE = 8192;
-    static uint16_t* ORIG_LOOKUP;
-    static uint16_t LOOKUP[86547 + RECALCULATE_PERF_HASH_OFFSETS * 100000000];
-    static uint16_t FLUSH_LOOKUP[FLUSH_LOOKUP_SIZE];
-    static uint32_t PERF_HASH_ROW_OFFSETS[8191 + RECALCULATE_PERF_HASH_OFFSETS * 100000];
+    // Hand categories for evaluateCategory(): LOOKUP packed to 4 bits per entry and a bitmask of the flush keys that
+    // are straight flushes.
+    static const uint8_t CATEGORY_LOOKUP[];
+    static const uint64_t STRAIGHT_FLUSH_KEYS[];
 };
 
+template<class TDeck>
+HandEvaluatorBase::BatchFunction BasicHandEvaluator<TDeck>::batchFunctions[2]{};
+
+typedef BasicHandEvaluator<StandardDeck> HandEvaluator;
+typedef BasicHandEvaluator<ShortDeck> ShortDeckHandEvaluator;
+
+// The tables of each deck are explicit specializations (LookupTables.hxx, OffsetTable.hxx).
+template<> const uint16_t HandEvaluator::LOOKUP[];
+template<> const uint16_t HandEvaluator::FLUSH_LOOKUP[];
+template<> const uint32_t HandEvaluator::PERF_HASH_ROW_OFFSETS[];
+template<> const uint8_t HandEvaluator::CATEGORY_LOOKUP[];
+template<> const uint64_t HandEvaluator::STRAIGHT_FLUSH_KEYS[];
+template<> const uint16_t ShortDeckHandEvaluator::LOOKUP[];
+template<> const uint16_t ShortDeckHandEvaluator::FLUSH_LOOKUP[];
+template<> const uint32_t ShortDeckHandEvaluator::PERF_HASH_ROW_OFFSETS[];
+template<> const uint8_t ShortDeckHandEvaluator::CATEGORY_LOOKUP[];
+template<> const uint64_t ShortDeckHandEvaluator::STRAIGHT_FLUSH_KEYS[];
+
 }
 
 #endif // OMP_HAND_EVALUATOR_H
@@ -1,9 +1,9 @@
 
 #include "HandEvaluator.h"
 
-// Offset table for the perfect hashing algorithm used in the evaluator. Generated by
-// HandEvaluator::calculatePerfectHash().
-uint32_t omp::HandEvaluator::PERF_HASH_ROW_OFFSETS[] {
+// Offset tables for the perfect hashing algorithm used in the evaluators. Generated by
+// gentables --offsets.
+template<> alignas(64) const uint32_t omp::HandEvaluator::PERF_HASH_ROW_OFFSETS[] {
     0x1fb5, 0xfffff000, 0xfffffc09, 0xffffd000, 0xffffd94b, 0xffffb000, 0xffffb919, 0xffff9000,
     0xffffd508, 0xffff7000, 0xffff7835, 0xffff5000, 0xffff5436, 0xffff3000, 0xffff338c, 0xffff1000,
     0xffff5547, 0xffff023c, 0xfffef1e3, 0xfffee12c, 0xfffecfc6, 0xfffebf08, 0xfffea193, 0xfffe9ca1,
@@ -1029,3 +1029,262 @@ uint32_t omp::HandEvaluator::PERF_HASH_ROW_OFFSETS[] {
     0xfe01014c, 0xfe0100ae, 0xfe00e000, 0xfe00d23b, 0xfe00c000, 0xfe00b131, 0xfe00a10e, 0xfe009000,
     0xfe00809d, 0xfe007cff, 0xfe006000, 0xfe005947, 0xfe004000, 0xfe003000, 0xfe00281a,
 };
+
+template<> alignas(64) const uint32_t omp::ShortDeckHandEvaluator::PERF_HASH_ROW_OFFSETS[] {
+    0x0, 0xffffc000, 0xffff8000, 0xffff4000, 0xffff0000, 0xfffec000, 0xfffe8000, 0xfffe4000,
+    0xfffe0000, 0xfffdc000, 0xfffd8000, 0xfffd4000, 0xfffd0000, 0xfffcc000, 0xfffc8000, 0xfffc4000,
+    0xfffc0000, 0xfffbc000, 0xfffb8000, 0xfffb4000, 0xfffb0000, 0xfffac000, 0xfffa8000, 0xfffa4000,
+    0xfffa0000, 0xfff9c000, 0xfff98000, 0xfff94000, 0xfff90000, 0xfff8c000, 0xfff88000, 0xfff84000,
+    0xfff80000, 0xfff7c000, 0xfff78000, 0xfff74000, 0xfff70001, 0xfff6c000, 0xfff68000, 0xfff64000,
+    0xfff60000, 0xfff5c000, 0xfff58000, 0xfff54000, 0xfff50000, 0xfff4c000, 0xfff48000, 0xfff44000,
+    0xfff40000, 0xfff3c000, 0xfff38000, 0xfff34000, 0xfff30000, 0xfff2c000, 0xfff28000, 0xfff24000,
+    0xfff20000, 0xfff1c000, 0xfff18000, 0xfff14000, 0xfff10000, 0xfff0c000, 0xfff08000, 0xfff04000,
+    0xfff00000, 0xffefc000, 0xffef8000, 0xffef4000, 0xffef0000, 0xffeec000, 0xffee8000, 0xffee4000,
+    0xffee0001, 0xffedc000, 0xffed8000, 0xffed4000, 0xffed0000, 0xffecc000, 0xffec8000, 0xffec4000,
+    0xffec0000, 0xffebc000, 0xffeb8000, 0xffeb4000, 0xffeb0000, 0xffeac000, 0xffea8000, 0xffea4000,
+    0xffea0000, 0xffe9c000, 0xffe98000, 0xffe94000, 0xffe90000, 0xffe8c002, 0xffe88000, 0xffe84000,
+    0xffe80000, 0xffe7c000, 0xffe78000, 0xffe74000, 0xffe70000, 0xffe6c000, 0xffe68000, 0xffe64000,
+    0xffe60000, 0xffe5c000, 0xffe58000, 0xffe54000, 0xffe50001, 0xffe4c000, 0xffe48000, 0xffe44000,
+    0xffe40000, 0xffe3c000, 0xffe38000, 0xffe34000, 0xffe30000, 0xffe2c000, 0xffe28000, 0xffe24000,
+    0xffe20000, 0xffe1c000, 0xffe18000, 0xffe14000, 0xffe10000, 0xffe0c000, 0xffe08000, 0xffe04000,
+    0xffe00000, 0xffdfc002, 0xffdf8000, 0xffdf4000, 0xffdf0000, 0xffdec000, 0xffde8000, 0xffde4000,
+    0xffde0000, 0xffddc000, 0xffdd8000, 0xffdd4000, 0xffdd0000, 0xffdcc000, 0xffdc8000, 0xffdc4000,
+    0xffdc0000, 0xffdbc003, 0xffdb8000, 0xffdb4000, 0xffdb0000, 0xffdac000, 0xffda8000, 0xffda4000,
+    0xffda0000, 0xffd9c000, 0xffd98000, 0xffd94000, 0xffd90000, 0xffd8c000, 0xffd88000, 0xffd84000,
+    0xffd80000, 0xffd7c000, 0xffd78000, 0xffd74000, 0xffd70000, 0xffd6c000, 0xffd68002, 0xffd64000,
+    0xffd60000, 0xffd5c000, 0xffd58000, 0xffd54000, 0xffd50000, 0xffd4c000, 0xffd48000, 0xffd44000,
+    0xffd40000, 0xffd3c000, 0xffd38000, 0xffd34000, 0xffd30000, 0xffd2c000, 0xffd28000, 0xffd24000,
+    0xffd20000, 0xffd1c000, 0xffd18000, 0xffd14000, 0xffd10000, 0xffd0c000, 0xffd08000, 0xffd04000,
+    0xffd00000, 0xffcfc000, 0xffcf8000, 0xffcf4000, 0xffcf0000, 0xffcec000, 0xffce8000, 0xffce4000,
+    0xffce0000, 0xffcdc000, 0xffcd8000, 0xffcd4000, 0xffcd0000, 0xffccc000, 0xffcc8000, 0xffcc4000,
+    0xffcc0000, 0xffcbc000, 0xffcb8000, 0xffcb4000, 0xffcb0000, 0xffcac000, 0xffca8000, 0xffca4000,
+    0xffca0000, 0xffc9c002, 0xffc98000, 0xffc94000, 0xffc90000, 0xffc8c000, 0xffc88000, 0xffc84002,
+    0xffc80000, 0xffc7c000, 0xffc78000, 0xffc74000, 0xffc70000, 0xffc6c000, 0xffc68000, 0xffc64000,
+    0xffc60000, 0xffc5c000, 0xffc58000, 0xffc54000, 0xffc50000, 0xffc4c000, 0xffc48003, 0xffc44000,
+    0xffc40000, 0xffc3c000, 0xffc38000, 0xffc34000, 0xffc30000, 0xffc2c000, 0xffc28000, 0xffc24000,
+    0xffc20000, 0xffc1c000, 0xffc18000, 0xffc14000, 0xffc10000, 0xffc0c002, 0xffc08000, 0xffc04000,
+    0xffc00000, 0xffbfc000, 0xffbf8000, 0xffbf4004, 0xffbf0000, 0xffbec000, 0xffbe8009, 0xffbe4000,
+    0xffbe0000, 0xffbdc000, 0xffbd8000, 0xffbd4000, 0xffbd0000, 0xffbcc000, 0xffbc8000, 0xffbc4000,
+    0xffbc0000, 0xffbbc000, 0xffbb8000, 0xffbb4000, 0xffbb0000, 0xffbac000, 0xffba8000, 0xffba4000,
+    0xffba0012, 0xffb9c000, 0xffb98000, 0xffb94000, 0xffb90000, 0xffb8c000, 0xffb88015, 0xffb84000,
+    0xffb80000, 0xffb7c000, 0xffb78002, 0xffb74278, 0xffb70000, 0xffb6c002, 0xffb68000, 0xffb64001,
+    0xffb60000, 0xffb5c000, 0xffb58007, 0xffb54000, 0xffb50000, 0xffb4c000, 0xffb48000, 0xffb44000,
+    0xffb40000, 0xffb3c000, 0xffb38000, 0xffb34000, 0xffb30000, 0xffb2c000, 0xffb28000, 0xffb24000,
+    0xffb20000, 0xffb1c000, 0xffb18000, 0xffb14000, 0xffb10000, 0xffb0c000, 0xffb08000, 0xffb04000,
+    0xffb00000, 0xffafc000, 0xffaf8026, 0xffaf4000, 0xffaf0000, 0xffaec000, 0xffae8000, 0xffae4008,
+    0xffae0001, 0xffadc027, 0xffad8000, 0xffad4000, 0xffad0002, 0xffacc000, 0xffac8000, 0xffac4004,
+    0xffac0000, 0xffabc000, 0xffab8000, 0xffab4000, 0xffab0000, 0xffaac000, 0xffaa8000, 0xffaa4000,
+    0xffaa0000, 0xffa9c000, 0xffa98000, 0xffa94001, 0xffa90000, 0xffa8c000, 0xffa88000, 0xffa84000,
+    0xffa80000, 0xffa7c001, 0xffa78000, 0xffa74000, 0xffa70001, 0xffa6c000, 0xffa68011, 0xffa64000,
+    0xffa60000, 0xffa5c000, 0xffa58003, 0xffa54038, 0xffa5001d, 0xffa4c020, 0xffa48000, 0xffa44000,
+    0xffa40000, 0xffa3c000, 0xffa38000, 0xffa34000, 0xffa30000, 0xffa2c000, 0xffa28002, 0xffa24000,
+    0xffa20000, 0xffa1c000, 0xffa18000, 0xffa14006, 0xffa10000, 0xffa0c000, 0xffa08000, 0xffa04001,
+    0xffa0001e, 0xff9fc002, 0xff9f8026, 0xff9f4000, 0xff9f0000, 0xff9ec001, 0xff9e8000, 0xff9e4000,
+    0xff9e0000, 0xff9dc000, 0xff9d8009, 0xff9d401d, 0xff9d0000, 0xff9cc000, 0xff9c8000, 0xff9c400b,
+    0xff9c0006, 0xff9bc002, 0xff9b8000, 0xff9b4000, 0xff9b0002, 0xff9ac000, 0xff9a8000, 0xff9a4003,
+    0xff9a0000, 0xff99c000, 0xff998000, 0xff994000, 0xff990000, 0xff98c000, 0xff988000, 0xff984000,
+    0xff980009, 0xff97c000, 0xff978000, 0xff974001, 0xff970003, 0xff96c000, 0xff968000, 0xff964000,
+    0xff960000, 0xff95c006, 0xff958000, 0xff954000, 0xff950000, 0xff94c000, 0xff948000, 0xff944012,
+    0xff940000, 0xff93c000, 0xff938000, 0xff934004, 0xff9300b3, 0xff92c000, 0xff928004, 0xff924000,
+    0xff920002, 0xff91c000, 0xff918000, 0xff914000, 0xff910000, 0xff90c000, 0xff908005, 0xff904000,
+    0xff900000, 0xff8fc002, 0xff8f8000, 0xff8f4000, 0xff8f0027, 0xff8ec000, 0xff8e8000, 0xff8e4000,
+    0xff8e0001, 0xff8dc2e4, 0xff8d8000, 0xff8d4031, 0xff8d0000, 0xff8cc000, 0xff8c8000, 0xff8c4000,
+    0xff8c0004, 0xff8bc000, 0xff8b8000, 0xff8b4000, 0xff8b0000, 0xff8ac000, 0xff8a8000, 0xff8a4003,
+    0xff8a0000, 0xff89c019, 0xff898000, 0xff894000, 0xff890000, 0xff88c003, 0xff8882d5, 0xff884000,
+    0xff88001b, 0xff87c000, 0xff878007, 0xff874000, 0xff870000, 0xff86c000, 0xff868000, 0xff864000,
+    0xff860024, 0xff85c000, 0xff858000, 0xff854000, 0xff850000, 0xff84c000, 0xff848012, 0xff844000,
+    0xff840000, 0xff83c000, 0xff838000, 0xff834000, 0xff830000, 0xff82c000, 0xff828000, 0xff824031,
+    0xff820000, 0xff81c000, 0xff818000, 0xff814000, 0xff810001, 0xff80c121, 0xff808014, 0xff804000,
+    0xff800000, 0xff7fc000, 0xff7f8002, 0xff7f4002, 0xff7f000b, 0xff7ec000, 0xff7e8000, 0xff7e4000,
+    0xff7e0000, 0xff7dc000, 0xff7d8003, 0xff7d4000, 0xff7d0018, 0xff7cc001, 0xff7c8000, 0xff7c4000,
+    0xff7c0000, 0xff7bc004, 0xff7b8001, 0xff7b4006, 0xff7b0000, 0xff7ac000, 0xff7a8000, 0xff7a4000,
+    0xff7a0000, 0xff79c000, 0xff798000, 0xff794002, 0xff79000d, 0xff78c000, 0xff788000, 0xff784000,
+    0xff780005, 0xff77c008, 0xff778001, 0xff774000, 0xff77001c, 0xff76c001, 0xff768017, 0xff764006,
+    0xff760000, 0xff75c00c, 0xff758001, 0xff75400b, 0xff750000, 0xff74c000, 0xff748000, 0xff744000,
+    0xff740000, 0xff73c002, 0xff738000, 0xff734000, 0xff730000, 0xff72c000, 0xff72801b, 0xff724000,
+    0xff720000, 0xff71c000, 0xff718000, 0xff714008, 0xff710075, 0xff70c008, 0xff708000, 0xff704000,
+    0xff70001f, 0xff6fc0c3, 0xff6f8001, 0xff6f401d, 0xff6f0001, 0xff6ec056, 0xff6e80c3, 0xff6e401e,
+    0xff6e0199, 0xff6dc004, 0xff6d800b, 0xff6d400c, 0xff6d0001, 0xff6cc005, 0xff6c8002, 0xff6c4000,
+    0xff6c0000, 0xff6bc000, 0xff6b8001, 0xff6b4000, 0xff6b0000, 0xff6ac000, 0xff6a8000, 0xff6a4000,
+    0xff6a0000, 0xff69c00c, 0xff698050, 0xff694016, 0xff69003a, 0xff68c000, 0xff688002, 0xff684000,
+    0xff680016, 0xff67c000, 0xff678000, 0xff674000, 0xff670024, 0xff66c086, 0xff668080, 0xff66409a,
+    0xff660000, 0xff65c024, 0xff65885e, 0xff654007, 0xff65000c, 0xff64c1a1, 0xff648013, 0xff6440a9,
+    0xff640000, 0xff63c008, 0xff6380c2, 0xff63400c, 0xff630024, 0xff62c000, 0xff628000, 0xff624000,
+    0xff620000, 0xff61c00f, 0xff618000, 0xff614000, 0xff610001, 0xff60c008, 0xff608021, 0xff604029,
+    0xff60002c, 0xff5fc000, 0xff5f8002, 0xff5f4000, 0xff5f07b7, 0xff5ec009, 0xff5e8006, 0xff5e423f,
+    0xff5e0002, 0xff5dc4c1, 0xff5d80c8, 0xff5d4151, 0xff5d000d, 0xff5cc009, 0xff5c8011, 0xff5c4101,
+    0xff5c019b, 0xff5bc012, 0xff5b8001, 0xff5b4000, 0xff5b002b, 0xff5ac000, 0xff5a8009, 0xff5a4022,
+    0xff5a0035, 0xff59c008, 0xff598003, 0xff5940a1, 0xff590000, 0xff58c078, 0xff588002, 0xff5840af,
+    0xff5803a3, 0xff57c006, 0xff578035, 0xff57400a, 0xff570118, 0xff56c0b3, 0xff568051, 0xff564002,
+    0xff560008, 0xff55c016, 0xff55800f, 0xff554000, 0xff550015, 0xff54c00d, 0xff548056, 0xff544001,
+    0xff540017, 0xff53c000, 0xff53803d, 0xff53407b, 0xff53001d, 0xff52c00a, 0xff528000, 0xff524035,
+    0xff5201b7, 0xff51c004, 0xff518029, 0xff514014, 0xff51003a, 0xff50c002, 0xff50803a, 0xff504007,
+    0xff500000, 0xff4fc005, 0xff4f8029, 0xff4f41d8, 0xff4f0015, 0xff4ec135, 0xff4e8007, 0xff4e4059,
+    0xff4e00d3, 0xff4dc08f, 0xff4d8013, 0xff4d4002, 0xff4d0000, 0xff4cc046, 0xff4c8002, 0xff4c407f,
+    0xff4c0041, 0xff4bc00b, 0xff4b822e, 0xff4b4004, 0xff4b033d, 0xff4ac008, 0xff4a802a, 0xff4a4058,
+    0xff4a0065, 0xff49c0dc, 0xff498003, 0xff49401c, 0xff490021, 0xff48c006, 0xff488000, 0xff484062,
+    0xff480000, 0xff47c01f, 0xff478007, 0xff47401e, 0xff47004f, 0xff46c014, 0xff46800d, 0xff4640b0,
+    0xff46001c, 0xff45c293, 0xff458009, 0xff4540ae, 0xff45001d, 0xff44c202, 0xff44800f, 0xff444001,
+    0xff440012, 0xff43c000, 0xff438000, 0xff434003, 0xff430002, 0xff42c000, 0xff428000, 0xff424012,
+    0xff420000, 0xff41c004, 0xff418009, 0xff414007, 0xff410346, 0xff40c011, 0xff40802a, 0xff404000,
+    0xff400300, 0xff3fc21e, 0xff3f8009, 0xff3f469e, 0xff3f0007, 0xff3ec00e, 0xff3e8003, 0xff3e4001,
+    0xff3e0000, 0xff3dc00b, 0xff3d800b, 0xff3d4087, 0xff3d01a8, 0xff3cc09b, 0xff3c8003, 0xff3c4000,
+    0xff3c0024, 0xff3bc01a, 0xff3b8000, 0xff3b403d, 0xff3b0010, 0xff3ac038, 0xff3a8003, 0xff3a404b,
+    0xff3a009b, 0xff39c072, 0xff39836c, 0xff394575, 0xff390124, 0xff38c003, 0xff3880d8, 0xff384058,
+    0xff3805c1, 0xff37c1a6, 0xff3785f3, 0xff374004, 0xff370016, 0xff36c1c8, 0xff3680f6, 0xff364035,
+    0xff3600bb, 0xff35c001, 0xff358000, 0xff354016, 0xff350000, 0xff34c2ed, 0xff348051, 0xff34477e,
+    0xff3400aa, 0xff33c03c, 0xff33800d, 0xff3340bb, 0xff330044, 0xff32c05f, 0xff328000, 0xff32400b,
+    0xff320003, 0xff31c003, 0xff318013, 0xff314008, 0xff310000, 0xff30c000, 0xff308004, 0xff304651,
+    0xff30000f, 0xff2fc05e, 0xff2f8143, 0xff2f418d, 0xff2f07a1, 0xff2ec44a, 0xff2e83fe, 0xff2e40e7,
+    0xff2e007b, 0xff2dc171, 0xff2d8003, 0xff2d4251, 0xff2d0342, 0xff2cc261, 0xff2c803c, 0xff2c402b,
+    0xff2c000b, 0xff2bc003, 0xff2b8003, 0xff2b4045, 0xff2b003b, 0xff2ac02c, 0xff2a8005, 0xff2a4008,
+    0xff2a004b, 0xff29c0a3, 0xff2987d5, 0xff2943d2, 0xff290005, 0xff28c09d, 0xff288801, 0xff28464f,
+    0xff280684, 0xff27c394, 0xff278031, 0xff274094, 0xff270003, 0xff26c44d, 0xff26836b, 0xff264623,
+    0xff26012d, 0xff25c4da, 0xff258417, 0xff2543a4, 0xff250233, 0xff24c059, 0xff248026, 0xff244046,
+    0xff2401cc, 0xff23c328, 0xff2380bb, 0xff234779, 0xff2300d9, 0xff22c000, 0xff228000, 0xff224008,
+    0xff2207ad, 0xff21c0c8, 0xff2183f6, 0xff214000, 0xff210066, 0xff20c279, 0xff20871d, 0xff2041ff,
+    0xff2003b9, 0xff1fc016, 0xff1f8014, 0xff1f4064, 0xff1f043a, 0xff1ec3e0, 0xff1e8019, 0xff1e408c,
+    0xff1e05dd, 0xff1dc4c5, 0xff1d8301, 0xff1d4261, 0xff1d0026, 0xff1cc01f, 0xff1c8400, 0xff1c4320,
+    0xff1c0345, 0xff1bc0d3, 0xff1b8399, 0xff1b4007, 0xff1b00a0, 0xff1ac109, 0xff1a8168, 0xff1a4766,
+    0xff1a0009, 0xff19c00b, 0xff19800e, 0xff194026, 0xff190055, 0xff18c00c, 0xff1882bf, 0xff18400c,
+    0xff180847, 0xff17c018, 0xff1785f9, 0xff17422f, 0xff170330, 0xff16c408, 0xff168000, 0xff164665,
+    0xff160058, 0xff15c23d, 0xff158743, 0xff1546d2, 0xff150623, 0xff14c58a, 0xff148065, 0xff1443ef,
+    0xff140098, 0xff13c5ff, 0xff138029, 0xff1342ce, 0xff130219, 0xff12c19a, 0xff128257, 0xff1245ae,
+    0xff12009a, 0xff11c065, 0xff11800c, 0xff11400a, 0xff110631, 0xff10c58b, 0xff108337, 0xff10406f,
+    0xff1002a5, 0xff0fc688, 0xff0f8315, 0xff0f433b, 0xff0f0409, 0xff0ec0d9, 0xff0e8063, 0xff0e4766,
+    0xff0e01b5, 0xff0dc113, 0xff0d813f, 0xff0d40d9, 0xff0d0193, 0xff0cc166, 0xff0c8461, 0xff0c4110,
+    0xff0c0374, 0xff0bc547, 0xff0b801f, 0xff0b434e, 0xff0b0169, 0xff0ac3fc, 0xff0a8768, 0xff0a4320,
+    0xff0a032f, 0xff09c1fb, 0xff09802e, 0xff0946a6, 0xff0906f2, 0xff08c3ec, 0xff088179, 0xff08437a,
+    0xff080327, 0xff07c0f4, 0xff0783fe, 0xff074453, 0xff070005, 0xff06c051, 0xff068739, 0xff064011,
+    0xff060399, 0xff05c089, 0xff05810c, 0xff054018, 0xff050037, 0xff04c684, 0xff048360, 0xff044160,
+    0xff04065a, 0xff03c161, 0xff03853e, 0xff03400e, 0xff030537, 0xff02c4ec, 0xff028414, 0xff0242e5,
+    0xff020002, 0xff01c099, 0xff0184e6, 0xff0141f5, 0xff0102c1, 0xff00c012, 0xff008026, 0xff00402d,
+    0xff0000bd, 0xfeffc76e, 0xfeff80df, 0xfeff4000, 0xfeff070c, 0xfefec02f, 0xfefe81b1, 0xfefe43ba,
+    0xfefe0004, 0xfefdc2b9, 0xfefd85e8, 0xfefd4398, 0xfefd017b, 0xfefcc74e, 0xfefc802d, 0xfefc43e4,
+    0xfefc0164, 0xfefbc44a, 0xfefb803e, 0xfefb4043, 0xfefb0391, 0xfefac0ba, 0xfefa8048, 0xfefa400b,
+    0xfefa0238, 0xfef9c7b0, 0xfef98505, 0xfef9418e, 0xfef9036b, 0xfef8c079, 0xfef885a2, 0xfef845c4,
+    0xfef80196, 0xfef7c008, 0xfef787a8, 0xfef743ad, 0xfef70051, 0xfef6c2ca, 0xfef68272, 0xfef640d8,
+    0xfef600a2, 0xfef5c797, 0xfef5814b, 0xfef542d2, 0xfef50007, 0xfef4c04d, 0xfef48159, 0xfef4451c,
+    0xfef40067, 0xfef3c132, 0xfef38044, 0xfef34309, 0xfef30661, 0xfef2c28d, 0xfef2805d, 0xfef2402a,
+    0xfef205c1, 0xfef1c0cc, 0xfef1856c, 0xfef14016, 0xfef1026b, 0xfef0c1c4, 0xfef084cb, 0xfef044d1,
+    0xfef000ee, 0xfeefc0a4, 0xfeef808d, 0xfeef45f4, 0xfeef00e7, 0xfeeec407, 0xfeee8064, 0xfeee4123,
+    0xfeee000d, 0xfeedc379, 0xfeed83bd, 0xfeed4391, 0xfeed011b, 0xfeecc34e, 0xfeec848d, 0xfeec4002,
+    0xfeec0001, 0xfeebc087, 0xfeeb82c0, 0xfeeb4395, 0xfeeb0169, 0xfeeac2f8, 0xfeea825d, 0xfeea4213,
+    0xfeea067d, 0xfee9c779, 0xfee98010, 0xfee94278, 0xfee90037, 0xfee8c270, 0xfee882cd, 0xfee842b8,
+    0xfee80379, 0xfee7c0a4, 0xfee78000, 0xfee7442c, 0xfee7022f, 0xfee6c03f, 0xfee68264, 0xfee64006,
+    0xfee6032f, 0xfee5c01e, 0xfee5807e, 0xfee542f8, 0xfee50008, 0xfee4c3f4, 0xfee481ce, 0xfee44116,
+    0xfee400a4, 0xfee3c024, 0xfee38004, 0xfee34396, 0xfee3012f, 0xfee2c000, 0xfee2810c, 0xfee2465c,
+    0xfee2000f, 0xfee1c29e, 0xfee18312, 0xfee14023, 0xfee1031c, 0xfee0c0cf, 0xfee0801a, 0xfee04044,
+    0xfee0014a, 0xfedfc6df, 0xfedf81e9, 0xfedf4001, 0xfedf0001, 0xfedec01d, 0xfede8023, 0xfede4168,
+    0xfede026f, 0xfeddc003, 0xfedd8001, 0xfedd4009, 0xfedd0242, 0xfedcc01a, 0xfedc80dc, 0xfedc4004,
+    0xfedc0002, 0xfedbc001, 0xfedb8003, 0xfedb40fa, 0xfedb044e, 0xfedac031, 0xfeda8011, 0xfeda4001,
+    0xfeda0229, 0xfed9c04c, 0xfed98038, 0xfed94449, 0xfed90002, 0xfed8c001, 0xfed88120, 0xfed8411e,
+    0xfed806e0, 0xfed7c07a, 0xfed78000, 0xfed74004, 0xfed701b2, 0xfed6c23e, 0xfed68000, 0xfed6401b,
+    0xfed6001d, 0xfed5c011, 0xfed58001, 0xfed54015, 0xfed50340, 0xfed4c001, 0xfed48021, 0xfed4405f,
+    0xfed400b1, 0xfed3c079, 0xfed381b1, 0xfed34044, 0xfed30048, 0xfed2c000, 0xfed28082, 0xfed24003,
+    0xfed204a7, 0xfed1c3b9, 0xfed18298, 0xfed141e2, 0xfed102e6, 0xfed0c43b, 0xfed0808f, 0xfed04430,
+    0xfed004d7, 0xfecfc298, 0xfecf81a2, 0xfecf4052, 0xfecf01ed, 0xfecec27b, 0xfece80b7, 0xfece401f,
+    0xfece00f8, 0xfecdc3ca, 0xfecd80d9, 0xfecd44dd, 0xfecd0003, 0xfeccc01e, 0xfecc802c, 0xfecc4193,
+    0xfecc004e, 0xfecbc0bc, 0xfecb8050, 0xfecb4001, 0xfecb00ec, 0xfecac000, 0xfeca808f, 0xfeca4001,
+    0xfeca0000, 0xfec9c059, 0xfec98001, 0xfec94016, 0xfec90005, 0xfec8c52f, 0xfec8803f, 0xfec84053,
+    0xfec80348, 0xfec7c003, 0xfec78004, 0xfec74019, 0xfec702da, 0xfec6c017, 0xfec6817d, 0xfec64003,
+    0xfec60023, 0xfec5c20e, 0xfec58000, 0xfec540f4, 0xfec5000c, 0xfec4c01e, 0xfec482c2, 0xfec44002,
+    0xfec40002, 0xfec3c1b4, 0xfec381e4, 0xfec34012, 0xfec3000b, 0xfec2c020, 0xfec28005, 0xfec24009,
+    0xfec2005c, 0xfec1c014, 0xfec18005, 0xfec1403c, 0xfec10096, 0xfec0c032, 0xfec0807a, 0xfec04093,
+    0xfec000dd, 0xfebfc081, 0xfebf8059, 0xfebf4008, 0xfebf06cf, 0xfebec007, 0xfebe800c, 0xfebe42f3,
+    0xfebe01a9, 0xfebdc2a9, 0xfebd852a, 0xfebd4027, 0xfebd0014, 0xfebcc015, 0xfebc81bc, 0xfebc4125,
+    0xfebc0131, 0xfebbc016, 0xfebb8001, 0xfebb4028, 0xfebb0230, 0xfebac613, 0xfeba844e, 0xfeba405f,
+    0xfeba012b, 0xfeb9c128, 0xfeb980f5, 0xfeb94011, 0xfeb90697, 0xfeb8c011, 0xfeb8800f, 0xfeb84120,
+    0xfeb80092, 0xfeb7c572, 0xfeb780e9, 0xfeb74129, 0xfeb704f3, 0xfeb6c015, 0xfeb68380, 0xfeb6402c,
+    0xfeb6003b, 0xfeb5c38e, 0xfeb582a5, 0xfeb54502, 0xfeb5005d, 0xfeb4c03d, 0xfeb4813f, 0xfeb440bc,
+    0xfeb40193, 0xfeb3c2e2, 0xfeb3803e, 0xfeb3404f, 0xfeb300cd, 0xfeb2c005, 0xfeb2807a, 0xfeb24127,
+    0xfeb20004, 0xfeb1c673, 0xfeb18035, 0xfeb1470e, 0xfeb106a2, 0xfeb0c105, 0xfeb080b5, 0xfeb04005,
+    0xfeb000dd, 0xfeafc0a7, 0xfeaf8500, 0xfeaf429c, 0xfeaf0000, 0xfeaec003, 0xfeae80a5, 0xfeae4290,
+    0xfeae0413, 0xfeadc396, 0xfead8007, 0xfead4022, 0xfead0003, 0xfeacc059, 0xfeac807a, 0xfeac4318,
+    0xfeac066d, 0xfeabc00c, 0xfeab80e5, 0xfeab4067, 0xfeab0040, 0xfeaac2d0, 0xfeaa81f4, 0xfeaa4016,
+    0xfeaa0019, 0xfea9c528, 0xfea9807f, 0xfea941e6, 0xfea90024, 0xfea8c001, 0xfea88000, 0xfea84038,
+    0xfea80017, 0xfea7c001, 0xfea78008, 0xfea74001, 0xfea70003, 0xfea6c006, 0xfea68006, 0xfea64005,
+    0xfea60002, 0xfea5c008, 0xfea58001, 0xfea54004, 0xfea50000, 0xfea4c2cd, 0xfea480af, 0xfea4408b,
+    0xfea4003a, 0xfea3c059, 0xfea38059, 0xfea343a9, 0xfea303d1, 0xfea2c0f8, 0xfea28003, 0xfea241d2,
+    0xfea20192, 0xfea1c0a6, 0xfea180a4, 0xfea141c7, 0xfea10103, 0xfea0c046, 0xfea08224, 0xfea045d5,
+    0xfea00004, 0xfe9fc001, 0xfe9f8038, 0xfe9f4006, 0xfe9f0006, 0xfe9ec002, 0xfe9e82ec, 0xfe9e4002,
+    0xfe9e0003, 0xfe9dc00d, 0xfe9d8002, 0xfe9d4016, 0xfe9d0012, 0xfe9cc0bd, 0xfe9c8010, 0xfe9c4000,
+    0xfe9c000d, 0xfe9bc002, 0xfe9b8133, 0xfe9b4124, 0xfe9b0016, 0xfe9ac001, 0xfe9a8000, 0xfe9a4003,
+    0xfe9a0006, 0xfe99c033, 0xfe99800c, 0xfe994003, 0xfe990000, 0xfe98c000, 0xfe988050, 0xfe984001,
+    0xfe980001, 0xfe97c002, 0xfe978000, 0xfe974000, 0xfe970002, 0xfe96c002, 0xfe968000, 0xfe964000,
+    0xfe960000, 0xfe95c000, 0xfe958000, 0xfe954002, 0xfe950003, 0xfe94c000, 0xfe948000, 0xfe944000,
+    0xfe940006, 0xfe93c006, 0xfe938001, 0xfe934029, 0xfe930000, 0xfe92c004, 0xfe928001, 0xfe92408d,
+    0xfe92007e, 0xfe91c06f, 0xfe918017, 0xfe914000, 0xfe91003d, 0xfe90c022, 0xfe9084ff, 0xfe90400f,
+    0xfe900000, 0xfe8fc001, 0xfe8f802a, 0xfe8f40ff, 0xfe8f00a6, 0xfe8ec012, 0xfe8e8000, 0xfe8e4000,
+    0xfe8e0000, 0xfe8dc045, 0xfe8d810a, 0xfe8d4000, 0xfe8d0005, 0xfe8cc000, 0xfe8c8000, 0xfe8c4000,
+    0xfe8c0002, 0xfe8bc002, 0xfe8b8000, 0xfe8b4002, 0xfe8b0000, 0xfe8ac00a, 0xfe8a8000, 0xfe8a400a,
+    0xfe8a0001, 0xfe89c002, 0xfe8980b7, 0xfe89400c, 0xfe89001a, 0xfe88c015, 0xfe88806a, 0xfe884037,
+    0xfe880128, 0xfe87c004, 0xfe8785c2, 0xfe87404f, 0xfe870000, 0xfe86c098, 0xfe868000, 0xfe864022,
+    0xfe860000, 0xfe85c000, 0xfe858002, 0xfe854002, 0xfe850003, 0xfe84c003, 0xfe848004, 0xfe844004,
+    0xfe840000, 0xfe83c003, 0xfe838003, 0xfe834000, 0xfe830000, 0xfe82c000, 0xfe828000, 0xfe824154,
+    0xfe820008, 0xfe81c000, 0xfe818000, 0xfe81400a, 0xfe81009b, 0xfe80c028, 0xfe808435, 0xfe804001,
+    0xfe800001, 0xfe7fc00e, 0xfe7f810c, 0xfe7f4066, 0xfe7f0078, 0xfe7ec024, 0xfe7e8004, 0xfe7e4003,
+    0xfe7e0029, 0xfe7dc1ca, 0xfe7d8000, 0xfe7d4001, 0xfe7d0030, 0xfe7cc000, 0xfe7c800c, 0xfe7c4068,
+    0xfe7c000e, 0xfe7bc000, 0xfe7b8000, 0xfe7b4014, 0xfe7b0007, 0xfe7ac029, 0xfe7a803d, 0xfe7a401b,
+    0xfe7a0003, 0xfe79c01d, 0xfe7982ce, 0xfe794434, 0xfe790422, 0xfe78c000, 0xfe78800f, 0xfe784004,
+    0xfe7800df, 0xfe77c0a4, 0xfe778001, 0xfe774020, 0xfe77000d, 0xfe76c0ba, 0xfe768002, 0xfe76400f,
+    0xfe760108, 0xfe75c003, 0xfe758006, 0xfe754000, 0xfe750004, 0xfe74c013, 0xfe748005, 0xfe744122,
+    0xfe740000, 0xfe73c024, 0xfe738032, 0xfe734050, 0xfe73019f, 0xfe72c001, 0xfe728067, 0xfe724058,
+    0xfe72034b, 0xfe71c005, 0xfe7184cc, 0xfe71439c, 0xfe71019e, 0xfe70c1c5, 0xfe70800b, 0xfe704059,
+    0xfe70010a, 0xfe6fc0e1, 0xfe6f8614, 0xfe6f4023, 0xfe6f0006, 0xfe6ec00c, 0xfe6e8048, 0xfe6e42f7,
+    0xfe6e045f, 0xfe6dc267, 0xfe6d8059, 0xfe6d4030, 0xfe6d0004, 0xfe6cc007, 0xfe6c80aa, 0xfe6c403b,
+    0xfe6c0089, 0xfe6bc078, 0xfe6b80c8, 0xfe6b405a, 0xfe6b0053, 0xfe6ac071, 0xfe6a8009, 0xfe6a403a,
+    0xfe6a0014, 0xfe69c1e6, 0xfe6985ad, 0xfe694002, 0xfe690209, 0xfe68c000, 0xfe688044, 0xfe684005,
+    0xfe680003, 0xfe67c184, 0xfe678000, 0xfe674006, 0xfe670000, 0xfe66c003, 0xfe668000, 0xfe664001,
+    0xfe66000d, 0xfe65c002, 0xfe658000, 0xfe654028, 0xfe650007, 0xfe64c035, 0xfe64804e, 0xfe644005,
+    0xfe640005, 0xfe63c00b, 0xfe63801b, 0xfe63459b, 0xfe6305fd, 0xfe62c13e, 0xfe628025, 0xfe624175,
+    0xfe6204cf, 0xfe61c26a, 0xfe618091, 0xfe61401f, 0xfe61000f, 0xfe60c02c, 0xfe608184, 0xfe604052,
+    0xfe600013, 0xfe5fc00e, 0xfe5f8000, 0xfe5f4002, 0xfe5f018c, 0xfe5ec007, 0xfe5e8002, 0xfe5e4001,
+    0xfe5e0004, 0xfe5dc006, 0xfe5d8002, 0xfe5d405f, 0xfe5d0000, 0xfe5cc016, 0xfe5c8006, 0xfe5c401f,
+    0xfe5c0002, 0xfe5bc003, 0xfe5b8031, 0xfe5b400c, 0xfe5b0009, 0xfe5ac0a1, 0xfe5a8006, 0xfe5a401c,
+    0xfe5a0000, 0xfe59c000, 0xfe598000, 0xfe594008, 0xfe590091, 0xfe58c00d, 0xfe588002, 0xfe584000,
+    0xfe580004, 0xfe57c055, 0xfe578001, 0xfe574001, 0xfe570053, 0xfe56c03b, 0xfe56801e, 0xfe564000,
+    0xfe560000, 0xfe55c000, 0xfe558001, 0xfe554042, 0xfe550000, 0xfe54c015, 0xfe548000, 0xfe544000,
+    0xfe540001, 0xfe53c016, 0xfe53801d, 0xfe53400d, 0xfe530000, 0xfe52c002, 0xfe528000, 0xfe524047,
+    0xfe5205a5, 0xfe51c003, 0xfe518000, 0xfe514000, 0xfe510293, 0xfe50c2f0, 0xfe508002, 0xfe504010,
+    0xfe500000, 0xfe4fc000, 0xfe4f8010, 0xfe4f4038, 0xfe4f0147, 0xfe4ec000, 0xfe4e8000, 0xfe4e4000,
+    0xfe4e0001, 0xfe4dc000, 0xfe4d8000, 0xfe4d4000, 0xfe4d0000, 0xfe4cc000, 0xfe4c8000, 0xfe4c4000,
+    0xfe4c0000, 0xfe4bc000, 0xfe4b8000, 0xfe4b4000, 0xfe4b0000, 0xfe4ac000, 0xfe4a8004, 0xfe4a4000,
+    0xfe4a0001, 0xfe49c000, 0xfe498006, 0xfe494008, 0xfe490002, 0xfe48c0e3, 0xfe488000, 0xfe48405b,
+    0xfe480006, 0xfe47c2ae, 0xfe478001, 0xfe474000, 0xfe470003, 0xfe46c004, 0xfe46801c, 0xfe464006,
+    0xfe460000, 0xfe45c001, 0xfe458000, 0xfe454002, 0xfe450002, 0xfe44c000, 0xfe448002, 0xfe444004,
+    0xfe440032, 0xfe43c032, 0xfe438000, 0xfe434000, 0xfe430000, 0xfe42c001, 0xfe428003, 0xfe424005,
+    0xfe4200f5, 0xfe41c001, 0xfe418010, 0xfe414019, 0xfe410042, 0xfe40c04c, 0xfe4083ad, 0xfe40467b,
+    0xfe400134, 0xfe3fc28f, 0xfe3f8049, 0xfe3f4003, 0xfe3f0685, 0xfe3ec566, 0xfe3e82c2, 0xfe3e40d2,
+    0xfe3e0004, 0xfe3dc46e, 0xfe3d819f, 0xfe3d404c, 0xfe3d0170, 0xfe3cc029, 0xfe3c8005, 0xfe3c4044,
+    0xfe3c0053, 0xfe3bc05e, 0xfe3b8002, 0xfe3b4075, 0xfe3b0098, 0xfe3ac004, 0xfe3a8030, 0xfe3a4002,
+    0xfe3a0038, 0xfe39c025, 0xfe39807f, 0xfe39406d, 0xfe390002, 0xfe38c03d, 0xfe388054, 0xfe384006,
+    0xfe3800b1, 0xfe37c294, 0xfe378195, 0xfe374003, 0xfe37005a, 0xfe36c010, 0xfe368044, 0xfe364001,
+    0xfe360005, 0xfe35c011, 0xfe35801a, 0xfe354017, 0xfe350001, 0xfe34c01d, 0xfe34800c, 0xfe344000,
+    0xfe340003, 0xfe33c008, 0xfe33801a, 0xfe33401d, 0xfe33002e, 0xfe32c008, 0xfe3286c9, 0xfe324579,
+    0xfe3204e1, 0xfe31c35f, 0xfe318007, 0xfe314015, 0xfe31054d, 0xfe30c2b1, 0xfe308093, 0xfe304001,
+    0xfe3000a0, 0xfe2fc016, 0xfe2f818b, 0xfe2f407f, 0xfe2f0004, 0xfe2ec014, 0xfe2e8006, 0xfe2e4316,
+    0xfe2e0010, 0xfe2dc052, 0xfe2d8002, 0xfe2d4000, 0xfe2d0022, 0xfe2cc005, 0xfe2c85e4, 0xfe2c4523,
+    0xfe2c02ed, 0xfe2bc005, 0xfe2b8009, 0xfe2b4522, 0xfe2b03ea, 0xfe2ac013, 0xfe2a8101, 0xfe2a400d,
+    0xfe2a04c8, 0xfe29c39c, 0xfe298065, 0xfe29406a, 0xfe290004, 0xfe28c0b7, 0xfe28826f, 0xfe284088,
+    0xfe280067, 0xfe27c006, 0xfe278006, 0xfe274014, 0xfe27008f, 0xfe26c006, 0xfe26805f, 0xfe264000,
+    0xfe260002, 0xfe25c57b, 0xfe2583b4, 0xfe254009, 0xfe250001, 0xfe24c037, 0xfe248005, 0xfe244005,
+    0xfe240005, 0xfe23c006, 0xfe238008, 0xfe234000, 0xfe2301d5, 0xfe22c001, 0xfe228015, 0xfe224016,
+    0xfe220000, 0xfe21c743, 0xfe21801e, 0xfe214201, 0xfe210139, 0xfe20c294, 0xfe2081a6, 0xfe20440b,
+    0xfe2000bc, 0xfe1fc40f, 0xfe1f802a, 0xfe1f419a, 0xfe1f0015, 0xfe1ec4a1, 0xfe1e81a4, 0xfe1e4048,
+    0xfe1e004d, 0xfe1dc028, 0xfe1d800a, 0xfe1d40e4, 0xfe1d0051, 0xfe1cc018, 0xfe1c8007, 0xfe1c4005,
+    0xfe1c0014, 0xfe1bc000, 0xfe1b828f, 0xfe1b4048, 0xfe1b0039, 0xfe1ac4a8, 0xfe1a85a3, 0xfe1a4021,
+    0xfe1a0007, 0xfe19c042, 0xfe198059, 0xfe1940aa, 0xfe190093, 0xfe18c0f5, 0xfe188002, 0xfe184008,
+    0xfe180008, 0xfe17c00b, 0xfe178022, 0xfe174000, 0xfe170000, 0xfe16c002, 0xfe168001, 0xfe164055,
+    0xfe160001, 0xfe15c022, 0xfe158011, 0xfe154021, 0xfe150000, 0xfe14c00d, 0xfe148015, 0xfe144000,
+    0xfe14008a, 0xfe13c002, 0xfe138578, 0xfe13431e, 0xfe130038, 0xfe12c016, 0xfe128003, 0xfe124026,
+    0xfe120010, 0xfe11c071, 0xfe11809e, 0xfe114016, 0xfe110004, 0xfe10c00e, 0xfe108026, 0xfe104022,
+    0xfe100071, 0xfe0fc026, 0xfe0f8017, 0xfe0f4003, 0xfe0f000e, 0xfe0ec537, 0xfe0e80d3, 0xfe0e4046,
+    0xfe0e000e, 0xfe0dc000, 0xfe0d8483, 0xfe0d4154, 0xfe0d0017, 0xfe0cc007, 0xfe0c8000, 0xfe0c4079,
+    0xfe0c0087, 0xfe0bc000, 0xfe0b8003, 0xfe0b4002, 0xfe0b0009, 0xfe0ac014, 0xfe0a800f, 0xfe0a4099,
+    0xfe0a000a, 0xfe09c001, 0xfe098076, 0xfe094002, 0xfe09000f, 0xfe08c026, 0xfe0880e6, 0xfe08401e,
+    0xfe080032, 0xfe07c03d, 0xfe07810e, 0xfe074000, 0xfe07000c, 0xfe06c002, 0xfe068007, 0xfe064008,
+    0xfe060002, 0xfe05c000, 0xfe058000, 0xfe054006, 0xfe050000, 0xfe04c000, 0xfe048016, 0xfe044006,
+    0xfe040000, 0xfe03c006, 0xfe0382ab, 0xfe03401f, 0xfe03005b, 0xfe02c001, 0xfe028330, 0xfe024025,
+    0xfe02011e, 0xfe01c1b3, 0xfe01802d, 0xfe014013, 0xfe010245, 0xfe00c00f, 0xfe008094, 0xfe004001,
+};
@@ -0,0 +1,342 @@
+#include "OmahaEquityCalculator.h"
+#include "CardRange.h"
+#include <algorithm>
+#include <locale>
+#include <cmath>
+
+namespace omp {
+
+// Start new calculation and spawn threads.
+bool OmahaEquityCalculator::start(const std::vector<std::string>& handRanges, unsigned holeCardCount,
+                                  uint64_t boardCards, uint64_t deadCards, bool enumerateAll, double stdevTarget,
+                                  std::function<void(const Results&)> callback, double updateInterval,
+                                  unsigned threadCount)
+{
+    if (handRanges.size() == 0 || handRanges.size() > MAX_PLAYERS)
+        return false;
+    if (holeCardCount < OmahaEvaluator::MIN_HOLE_CARDS || holeCardCount > OmahaEvaluator::MAX_HOLE_CARDS)
+        return false;
+    if (bitCount(boardCards) > BOARD_CARDS || (boardCards & deadCards))
+        return false;
+    if (holeCardCount * handRanges.size() + bitCount(deadCards) + BOARD_CARDS > CARD_COUNT)
+        return false;
+
+    seedRng(enumerateAll);
+
+    // Set up card ranges.
+    mDeadCards = deadCards;
+    mBoardCards = boardCards;
+    mHoleCardCount = holeCardCount;
+    mHandRanges.clear();
+    for (auto& text : handRanges) {
+        mHandRanges.push_back(parseRange(text, holeCardCount, deadCards | boardCards));
+        if (mHandRanges.back().empty())
+            return false;
+        // The random walk steps through the hands in order, so they are shuffled to make consecutive hands
+        // independent.
+        if (!enumerateAll)
+            std::shuffle(mHandRanges.back().begin(), mHandRanges.back().end(), mRng);
+    }
+
+    // Enumeration indexes must fit in 64 bits. Monte carlo only reports the count.
+    uint64_t preflopCombos = getPreflopCombinationCount();
+    if (enumerateAll && preflopCombos == INFINITE)
+        return false;
+
+    // Start threads. The player count is a template parameter of the thread functions like in EquityCalculator.
+    static const ThreadFunction ENUMERATE_FUNCTIONS[MAX_PLAYERS] = {
+            &OmahaEquityCalculator::enumerate<1>, &OmahaEquityCalculator::enumerate<2>,
+            &OmahaEquityCalculator::enumerate<3>, &OmahaEquityCalculator::enumerate<4>,
+            &OmahaEquityCalculator::enumerate<5>, &OmahaEquityCalculator::enumerate<6>};
+    static const ThreadFunction MONTE_CARLO_FUNCTIONS[MAX_PLAYERS] = {
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<1>,
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<2>,
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<3>,
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<4>,
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<5>,
+            &OmahaEquityCalculator::simulateRandomWalkMonteCarlo<6>};
+    static_assert(MAX_PLAYERS == 6, "Thread function tables must have an entry for each player count.");
+    ThreadFunction threadFunction = (enumerateAll ? ENUMERATE_FUNCTIONS : MONTE_CARLO_FUNCTIONS)[handRanges.size() - 1];
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    startThreads((unsigned)handRanges.size(), enumerateAll, preflopCombos, preflopCombos, stdevTarget, callback,
+                 updateInterval, threadCount, [this,threadFunction](unsigned i){ (this->*threadFunction)(i); });
+
+    // Started successfully.
+    return true;
+}
+
+// Parses a comma separated list of hands.
+std::vector<uint64_t> OmahaEquityCalculator::parseRange(const std::string& text, unsigned holeCardCount,
+                                                        uint64_t reservedCards)
+{
+    std::vector<uint64_t> hands;
+    std::locale loc;
+    std::string s;
+    for (char c : text) {
+        if (std::isgraph(c, loc))
+            s.push_back(std::tolower(c, loc));
+    }
+
+    for (size_t pos = 0; pos <= s.size(); ) {
+        size_t end = std::min(s.find(',', pos), s.size());
+        std::string hand = s.substr(pos, end - pos);
+        pos = end + 1;
+        if (hand == "random") {
+            // Go through all card masks with holeCardCount bits in increasing order.
+            for (uint64_t m = (1ull << holeCardCount) - 1; m < 1ull << CARD_COUNT; ) {
+                if (!(m & reservedCards))
+                    hands.push_back(m);
+                uint64_t lowest = m & (0 - m), ripple = m + lowest;
+                m = ripple | (((m ^ ripple) >> 2) / lowest);
+            }
+        } else {
+            uint64_t cards = CardRange::getCardMask(hand);
+            if (hand.size() != 2 * holeCardCount || bitCount(cards) != holeCardCount)
+                return {};
+            if (!(cards & reservedCards))
+                hands.push_back(cards);
+        }
+    }
+
+    std::sort(hands.begin(), hands.end());
+    hands.erase(std::unique(hands.begin(), hands.end()), hands.end());
+    return hands;
+}
+
+// Monte carlo simulation using a random walk. On each iteration a random player is chosen and the next feasible
+// hand is picked for that player. See EquityCalculator::simulateRandomWalkMonteCarlo() for why this gives uniform
+// distribution.
+template<unsigned tPlayers>
+void OmahaEquityCalculator::simulateRandomWalkMonteCarlo(unsigned threadIdx)
+{
+    unsigned remainingCards = BOARD_CARDS - bitCount(mBoardCards);
+    BatchResults stats(tPlayers);
+
+    Rng rng = getThreadRng(threadIdx);
+    FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+    FastUniformIntDistribution<unsigned,31> comboDists[MAX_PLAYERS];
+    FastUniformIntDistribution<unsigned,16> playerDist(0, tPlayers - 1);
+    for (unsigned i = 0; i < tPlayers; ++i)
+        comboDists[i] = FastUniformIntDistribution<unsigned,31>(0, (unsigned)mHandRanges[i].size() - 1);
+
+    uint8_t fixedBoard[BOARD_CARDS];
+    unsigned fixedBoardCount = 0;
+    for (unsigned c = 0; c < CARD_COUNT; ++c) {
+        if (mBoardCards & (1ull << c))
+            fixedBoard[fixedBoardCount++] = c;
+    }
+
+    uint64_t usedCardsMask;
+    unsigned comboIndexes[MAX_PLAYERS];
+    OmahaEvaluator::Subsets playerSubsets[MAX_PLAYERS];
+
+    // Set initial state.
+    if (randomizeHoleCards(usedCardsMask, comboIndexes, rng, comboDists)) {
+        for (unsigned i = 0; i < tPlayers; ++i)
+            playerSubsets[i] = holeSubsets(mHandRanges[i][comboIndexes[i]]);
+
+        // Loop until stopped.
+        for (;;) {
+            // Randomize board with rejection sampling and evaluate for current hole cards.
+            uint8_t board[BOARD_CARDS];
+            std::copy(fixedBoard, fixedBoard + fixedBoardCount, board);
+            uint64_t boardMask = usedCardsMask;
+            for (unsigned i = 0; i < remainingCards; ++i) {
+                unsigned card;
+                do {
+                    card = cardDist(rng);
+                } while (boardMask & (1ull << card));
+                boardMask |= 1ull << card;
+                board[fixedBoardCount + i] = card;
+            }
+            evaluateHands<tPlayers>(playerSubsets, board, &stats);
+
+            // Update results periodically.
+            if ((stats.evalCount & 0xfff) == 0) {
+                bool stop = updateResults(stats, threadIdx, false);
+                stats = BatchResults(tPlayers);
+                if (stop)
+                    break;
+                // Occasional full randomization, same as in EquityCalculator.
+                if (!randomizeHoleCards(usedCardsMask, comboIndexes, rng, comboDists))
+                    break;
+                for (unsigned i = 0; i < tPlayers; ++i)
+                    playerSubsets[i] = holeSubsets(mHandRanges[i][comboIndexes[i]]);
+            }
+
+            // Choose random player and iterate to next valid hand.
+            unsigned playerIdx = playerDist(rng);
+            const std::vector<uint64_t>& range = mHandRanges[playerIdx];
+            unsigned comboIdx = comboIndexes[playerIdx];
+            usedCardsMask -= range[comboIdx];
+            do {
+                if (comboIdx == 0)
+                    comboIdx = (unsigned)range.size();
+                --comboIdx;
+            } while (range[comboIdx] & usedCardsMask);
+            usedCardsMask |= range[comboIdx];
+            comboIndexes[playerIdx] = comboIdx;
+            playerSubsets[playerIdx] = holeSubsets(range[comboIdx]);
+        }
+    }
+
+    updateResults(stats, threadIdx, true);
+}
+
+// Randomize hole cards using rejection sampling. Returns false if maximum number of attempts was reached.
+bool OmahaEquityCalculator::randomizeHoleCards(uint64_t& usedCardsMask, unsigned* comboIndexes, Rng& rng,
+                                               FastUniformIntDistribution<unsigned,31>* comboDists)
+{
+    unsigned n = 0;
+    for(bool ok = false; !ok && n < 1000; ++n) {
+        ok = true;
+        usedCardsMask = mDeadCards | mBoardCards;
+        for (unsigned i = 0; i < mHandRanges.size(); ++i) {
+            unsigned comboIdx = comboDists[i](rng);
+            comboIndexes[i] = comboIdx;
+            uint64_t cards = mHandRanges[i][comboIdx];
+            if (usedCardsMask & cards) {
+                ok = false;
+                break;
+            }
+            usedCardsMask |= cards;
+        }
+    }
+    return n < 1000;
+}
+
+// Evaluates a single showdown and stores the result.
+template<unsigned tPlayers>
+void OmahaEquityCalculator::evaluateHands(const OmahaEvaluator::Subsets* holeSubsets, const uint8_t* board,
+                                          BatchResults* stats)
+{
+    // The board subsets are shared by all players.
+    OmahaEvaluator::Subsets boardSubsets = OmahaEvaluator::boardSubsets(board, BOARD_CARDS);
+    uint16_t ranks[MAX_PLAYERS + SHOWDOWN_PADDING];
+    for (unsigned i = 0; i < tPlayers; ++i)
+        ranks[i] = mEval.evaluate(holeSubsets[i], boardSubsets);
+    addShowdown<tPlayers>(ranks, stats, 1);
+}
+
+// Calculates exact equities by enumerating through all possible combinations.
+template<unsigned tPlayers>
+void OmahaEquityCalculator::enumerate(unsigned threadIdx)
+{
+    uint64_t enumPosition = 0, enumEnd = 0;
+    uint64_t postflopCombos = getPostflopCombinationCount();
+    BatchResults stats(tPlayers);
+
+    uint8_t board[BOARD_CARDS];
+    unsigned boardCount = 0;
+    for (unsigned c = 0; c < CARD_COUNT; ++c) {
+        if (mBoardCards & (1ull << c))
+            board[boardCount++] = c;
+    }
+
+    for (;;++enumPosition) {
+        // Ask for more work if we don't have any.
+        if (enumPosition >= enumEnd) {
+            uint64_t firstBatchSize = std::max<uint64_t>(200000 / postflopCombos, 1);
+            std::tie(enumPosition, enumEnd) = reserveBatch(threadIdx, firstBatchSize);
+            if (enumPosition >= enumEnd)
+                break;
+        }
+
+        // Map enumeration index to actual hands and check duplicate cards.
+        bool ok = true;
+        uint64_t usedCardsMask = mBoardCards | mDeadCards;
+        OmahaEvaluator::Subsets playerSubsets[MAX_PLAYERS];
+        uint64_t pos = enumPosition;
+        for (unsigned i = 0; i < tPlayers; ++i) {
+            uint64_t cards = mHandRanges[i][pos % mHandRanges[i].size()];
+            pos /= mHandRanges[i].size();
+            if (usedCardsMask & cards) {
+                ok = false;
+                break;
+            }
+            usedCardsMask |= cards;
+            playerSubsets[i] = holeSubsets(cards);
+        }
+
+        if (!ok) {
+            ++stats.skippedPreflopCombos;
+        } else {
+            ++stats.uniquePreflopCombos;
+            uint8_t deck[CARD_COUNT];
+            unsigned ndeck = 0;
+            for (unsigned c = 0; c < CARD_COUNT; ++c) {
+                if (!(usedCardsMask & (1ull << c)))
+                    deck[ndeck++] = c;
+            }
+            enumerateBoardRec<tPlayers>(playerSubsets, board, boardCount, deck, ndeck, 0, &stats);
+        }
+
+        if (stats.evalCount >= 10000 || stats.skippedPreflopCombos >= 10000) {
+            bool stop = updateResults(stats, threadIdx, false);
+            stats = BatchResults(tPlayers);
+            if (stop)
+                break;
+        }
+    }
+
+    updateResults(stats, threadIdx, true);
+}
+
+// Enumerates the remaining board cards recursively.
+template<unsigned tPlayers>
+void OmahaEquityCalculator::enumerateBoardRec(const OmahaEvaluator::Subsets* holeSubsets, uint8_t* board,
+                                              unsigned boardCount, const uint8_t* deck, unsigned ndeck,
+                                              unsigned start, BatchResults* stats)
+{
+    if (boardCount == BOARD_CARDS) {
+        evaluateHands<tPlayers>(holeSubsets, board, stats);
+        return;
+    }
+    for (unsigned i = start; i < ndeck; ++i) {
+        board[boardCount] = deck[i];
+        enumerateBoardRec<tPlayers>(holeSubsets, board, boardCount + 1, deck, ndeck, i + 1, stats);
+    }
+}
+
+// Combines the cards of a card mask into hole card subsets.
+OmahaEvaluator::Subsets OmahaEquityCalculator::holeSubsets(uint64_t cardMask) const
+{
+    uint8_t cards[OmahaEvaluator::MAX_HOLE_CARDS];
+    for (unsigned i = 0; i < mHoleCardCount; ++i) {
+        cards[i] = countTrailingZeros(cardMask);
+        cardMask &= cardMask - 1;
+    }
+    return OmahaEvaluator::holeSubsets(cards, mHoleCardCount);
+}
+
+// Number of different preflops with given hand ranges, assuming no conflicts between players' hands. Saturates at
+// INFINITE, because a few random ranges already overflow.
+uint64_t OmahaEquityCalculator::getPreflopCombinationCount()
+{
+    uint64_t combos = 1;
+    for (auto& range : mHandRanges) {
+        if (combos > INFINITE / range.size())
+            return INFINITE;
+        combos *= range.size();
+    }
+    return combos;
+}
+
+// Calculates size of the postflop tree, i.e. n choose k, where n is remaining deck size and k is number
+// of undealt board cards.
+uint64_t OmahaEquityCalculator::getPostflopCombinationCount()
+{
+    unsigned cardsInDeck = CARD_COUNT;
+    cardsInDeck -= bitCount(mDeadCards | mBoardCards);
+    cardsInDeck -= mHoleCardCount * (unsigned)mHandRanges.size();
+    unsigned boardCardsRemaining = BOARD_CARDS - bitCount(mBoardCards);
+    uint64_t postflopCombos = 1;
+    for (unsigned i = 0; i < boardCardsRemaining; ++i)
+        postflopCombos *= cardsInDeck - i;
+    for (unsigned i = 0; i < boardCardsRemaining; ++i)
+        postflopCombos /= i + 1;
+    return postflopCombos;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef OMP_OMAHA_EQUITY_CALCULATOR_H
+#define OMP_OMAHA_EQUITY_CALCULATOR_H
+
+#include "OmahaEvaluator.h"
+#include "EquityCalculatorBase.h"
+#include "Constants.h"
+#include "Util.h"
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace omp {
+
+// Calculates all-in equities in Omaha with 4 or 5 hole cards (PLO4/PLO5). Works like EquityCalculator and uses the
+// same driver, so the results, limits and seeding are the same: exact enumeration splits the preflop combinations
+// between threads and enumerates the remaining board cards, and monte carlo does a random walk over the hole card
+// combinations. There is no preflop lookup cache or isomorphism detection, so enumeration is only practical with
+// small ranges or a known flop.
+class OmahaEquityCalculator : public EquityCalculatorBase
+{
+public:
+    // Start a new calculation. Returns false if calculation is impossible for given hand ranges and board/dead cards,
+    // or if it's an enumeration with more preflop combinations than fit in 64 bits (e.g. 4 random PLO4 hands).
+    // After calling start() succesfully, wait() must be called in order wait for threads to finish.
+    // handRanges: hand ranges for each player, see parseRange()
+    // holeCardCount: 4 or 5
+    // Rest of the parameters are the same as in EquityCalculator::start().
+    bool start(const std::vector<std::string>& handRanges, unsigned holeCardCount, uint64_t boardCards = 0,
+               uint64_t deadCards = 0, bool enumerateAll = false, double stdevTarget = 5e-5,
+               std::function<void(const Results&)> callback = nullptr, double updateInterval = 0.2,
+               unsigned threadCount = 0);
+
+    // Parses an Omaha hand range into a list of card masks, removing hands that contain reserved cards. The range is
+    // a comma separated list of hands with specific cards (e.g. "AsKsJdTd,AcAd7h6h") or "random" for all hands.
+    // Returns an empty list if the syntax is invalid.
+    static std::vector<uint64_t> parseRange(const std::string& text, unsigned holeCardCount,
+                                            uint64_t reservedCards = 0);
+
+private:
+    typedef void (OmahaEquityCalculator::*ThreadFunction)(unsigned threadIdx);
+
+    template<unsigned tPlayers>
+    void enumerate(unsigned threadIdx);
+    template<unsigned tPlayers>
+    void enumerateBoardRec(const OmahaEvaluator::Subsets* holeSubsets, uint8_t* board, unsigned boardCount,
+                           const uint8_t* deck, unsigned ndeck, unsigned start, BatchResults* stats);
+    template<unsigned tPlayers>
+    void simulateRandomWalkMonteCarlo(unsigned threadIdx);
+    bool randomizeHoleCards(uint64_t& usedCardsMask, unsigned* comboIndexes, Rng& rng,
+                            FastUniformIntDistribution<unsigned,31>* comboDists);
+    template<unsigned tPlayers>
+    void evaluateHands(const OmahaEvaluator::Subsets* holeSubsets, const uint8_t* board, BatchResults* stats);
+    OmahaEvaluator::Subsets holeSubsets(uint64_t cardMask) const;
+    uint64_t getPreflopCombinationCount();
+    uint64_t getPostflopCombinationCount();
+
+    // Constant shared data
+    std::vector<std::vector<uint64_t>> mHandRanges; // Card masks of each hand after card removal.
+    unsigned mHoleCardCount;
+    uint64_t mDeadCards, mBoardCards;
+    OmahaEvaluator mEval;
+};
+
+}
+
+#endif // OMP_OMAHA_EQUITY_CALCULATOR_H
@@ -0,0 +1,105 @@
+#ifndef OMP_OMAHA_EVALUATOR_H
+#define OMP_OMAHA_EVALUATOR_H
+
+#include "HandEvaluator.h"
+#include "Hand.h"
+#include "Util.h"
+#include "Constants.h"
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+namespace omp {
+
+// Evaluates Omaha hands, where the best hand must be made of exactly 2 hole cards and 3 board cards. Supports 4 and 5
+// hole cards (PLO4/PLO5) and boards of 3-5 cards. Every 2-card subset of the hole cards is combined with every
+// 3-card subset of the board (60 hands for PLO4 and 100 for PLO5 on the river) and the hands are evaluated with a
+// single batch call. The subsets are precombined Hand objects, so the board subsets can be shared by all players and
+// the hole card subsets by all boards.
+class OmahaEvaluator
+{
+public:
+    static const unsigned MIN_HOLE_CARDS = 4, MAX_HOLE_CARDS = 5;
+    static const unsigned MAX_SUBSETS = 10; // 5 choose 2 and 5 choose 3
+
+    // Precombined subsets of hole cards or board cards.
+    struct Subsets
+    {
+        Hand hands[MAX_SUBSETS];
+        unsigned count = 0;
+        // Bitmask of suits that have enough cards for a flush (2 for hole cards, 3 for board).
+        unsigned flushSuits = 0;
+    };
+
+    // Returns the 2-card subsets of hole cards.
+    static Subsets holeSubsets(const uint8_t* cards, unsigned count)
+    {
+        omp_assert(count >= 2 && count <= MAX_HOLE_CARDS);
+        Subsets s;
+        unsigned suitCounts[SUIT_COUNT] = {};
+        for (unsigned i = 0; i < count; ++i) {
+            if (++suitCounts[cards[i] & SUIT_MASK] == 2)
+                s.flushSuits |= 1 << (cards[i] & SUIT_MASK);
+            for (unsigned j = i + 1; j < count; ++j)
+                s.hands[s.count++] = Hand(std::array<uint8_t,2>{{cards[i], cards[j]}});
+        }
+        return s;
+    }
+
+    // Returns the 3-card subsets of the board. These include Hand::empty(), so they can be combined directly with the
+    // hole card subsets.
+    static Subsets boardSubsets(const uint8_t* cards, unsigned count)
+    {
+        omp_assert(count >= 3 && count <= BOARD_CARDS);
+        Subsets s;
+        unsigned suitCounts[SUIT_COUNT] = {};
+        for (unsigned i = 0; i < count; ++i) {
+            if (++suitCounts[cards[i] & SUIT_MASK] == 3)
+                s.flushSuits |= 1 << (cards[i] & SUIT_MASK);
+            for (unsigned j = i + 1; j < count; ++j) {
+                Hand h = Hand::empty() + cards[i] + cards[j];
+                for (unsigned k = j + 1; k < count; ++k)
+                    s.hands[s.count++] = h + cards[k];
+            }
+        }
+        return s;
+    }
+
+    // Returns the rank of the best hand that can be made from the hole cards and the board. Ranks are the same as
+    // with HandEvaluator.
+    uint16_t evaluate(const Subsets& hole, const Subsets& board) const
+    {
+        Hand hands[MAX_SUBSETS * MAX_SUBSETS];
+        uint16_t ranks[MAX_SUBSETS * MAX_SUBSETS];
+        unsigned count = 0;
+        for (unsigned i = 0; i < board.count; ++i) {
+            for (unsigned j = 0; j < hole.count; ++j)
+                hands[count++] = board.hands[i] + hole.hands[j];
+        }
+
+        // Skip the flush checks when no suit has enough cards in both.
+        if (hole.flushSuits & board.flushSuits)
+            mEval.evaluateBatch<true>(hands, ranks, count);
+        else
+            mEval.evaluateBatch<false>(hands, ranks, count);
+
+        uint16_t best = 0;
+        for (unsigned i = 0; i < count; ++i)
+            best = std::max(best, ranks[i]);
+        return best;
+    }
+
+    // Evaluates a single hand from card indexes.
+    uint16_t evaluate(const uint8_t* holeCards, unsigned holeCount, const uint8_t* boardCards,
+                      unsigned boardCount) const
+    {
+        return evaluate(holeSubsets(holeCards, holeCount), boardSubsets(boardCards, boardCount));
+    }
+
+private:
+    HandEvaluator mEval;
+};
+
+}
+
+#endif // OMP_OMAHA_EVALUATOR_H
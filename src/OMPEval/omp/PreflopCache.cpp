@@ -0,0 +1,244 @@
+#include "PreflopCache.h"
+
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace omp {
+
+static const char CACHE_FILE_MAGIC[8] = {'O', 'M', 'P', 'C', 'A', 'C', 'H', 'E'};
+// Must be increased whenever the layout or the meaning of the keys or values changes.
+static const uint32_t CACHE_FILE_VERSION = 2;
+
+PreflopCache::PreflopCache()
+    : mAllocatedSize(0), mMapping(nullptr), mMappingSize(0), mDeckId(0), mSlots(nullptr), mValues(nullptr),
+      mClockHands(nullptr), mBucketCount(0), mValueSize(0)
+{
+}
+
+PreflopCache::~PreflopCache()
+{
+    close();
+}
+
+void PreflopCache::reset(size_t maxEntries, unsigned valueSize, size_t memoryBudget)
+{
+    omp_assert(valueSize <= MAX_VALUE_SIZE);
+    if (mMapping)
+        close();
+    size_t bucketBytes = blockSize(1, valueSize) - blockSize(0, valueSize);
+    size_t bucketCount = std::min(memoryBudget / bucketBytes, (maxEntries + BUCKET_SIZE - 1) / BUCKET_SIZE);
+    bucketCount = std::max<size_t>(bucketCount, 1);
+
+    size_t size = blockSize(bucketCount, valueSize);
+    if (size > mAllocatedSize) {
+        mMemory.reset(new uint64_t[(size + 7) / 8]);
+        mAllocatedSize = size;
+    }
+    setBlock((char*)mMemory.get(), bucketCount, valueSize);
+
+    // Values don't need to be cleared, because they're only read from slots with a matching key.
+    for (size_t i = 0; i < capacity(); ++i) {
+        mSlots[i].version.store(0, std::memory_order_relaxed);
+        mSlots[i].referenced.store(0, std::memory_order_relaxed);
+        mSlots[i].preflop.store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < mBucketCount; ++i)
+        mClockHands[i].store(0, std::memory_order_relaxed);
+}
+
+bool PreflopCache::open(const std::string& path, unsigned valueSize, size_t fileSize, uint32_t deckId)
+{
+    omp_assert(valueSize <= MAX_VALUE_SIZE);
+    if (mMapping && path == mPath && valueSize == mValueSize && deckId == mDeckId)
+        return true;
+    close();
+
+    #ifdef _WIN32
+    (void)fileSize;
+    return false;
+    #else
+    // Other processes see the same memory, so the atomics must not be emulated with locks.
+    if (!std::atomic<uint64_t>().is_lock_free() || !std::atomic<uint32_t>().is_lock_free())
+        return false;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+
+    // The lock makes sure that only one process initializes a new file and that nobody maps it before that is
+    // done. The entries themselves are synchronized with the atomics.
+    bool ok = false;
+    struct stat st;
+    if (flock(fd, LOCK_EX) == 0 && fstat(fd, &st) == 0) {
+        size_t size = (size_t)st.st_size;
+        bool create = size == 0;
+        if (create) {
+            size_t bucketBytes = blockSize(1, valueSize) - blockSize(0, valueSize);
+            size_t bucketCount = std::max<size_t>((fileSize - std::min(fileSize, blockSize(0, valueSize)))
+                                                  / bucketBytes, 1);
+            size = blockSize(bucketCount, valueSize);
+            if (ftruncate(fd, (off_t)size) != 0)
+                size = 0;
+        }
+        void* p = size >= sizeof(Header) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                         : MAP_FAILED;
+        if (p != MAP_FAILED) {
+            // A new file is all zeros, which is an empty table, so only the header needs to be written.
+            Header* header = (Header*)p;
+            if (create) {
+                header->formatVersion = CACHE_FILE_VERSION;
+                header->valueSize = valueSize;
+                header->deckId = deckId;
+                header->bucketCount = (size - blockSize(0, valueSize)) / (blockSize(1, valueSize)
+                                                                          - blockSize(0, valueSize));
+                std::memcpy(header->magic, CACHE_FILE_MAGIC, sizeof(header->magic));
+            }
+            ok = std::memcmp(header->magic, CACHE_FILE_MAGIC, sizeof(header->magic)) == 0
+                    && header->formatVersion == CACHE_FILE_VERSION && header->valueSize == valueSize && header->deckId == deckId
+                    && header->bucketCount > 0 && blockSize(header->bucketCount, valueSize) == size;
+            if (ok) {
+                mMapping = p;
+                mMappingSize = size;
+                mPath = path;
+                mDeckId = deckId;
+                setBlock((char*)p, header->bucketCount, valueSize);
+            } else {
+                munmap(p, size);
+            }
+        }
+        flock(fd, LOCK_UN);
+    }
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    return ok;
+    #endif
+}
+
+void PreflopCache::close()
+{
+    #ifndef _WIN32
+    if (mMapping)
+        munmap(mMapping, mMappingSize);
+    #endif
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mPath.clear();
+    mSlots = nullptr;
+    mValues = nullptr;
+    mClockHands = nullptr;
+    mBucketCount = 0;
+}
+
+bool PreflopCache::lookup(const Key& key, uint32_t* values) const
+{
+    omp_assert(key.preflop != 0);
+    if (mBucketCount == 0)
+        return false;
+    size_t first = bucketIndex(key) * BUCKET_SIZE;
+    for (size_t i = first; i < first + BUCKET_SIZE; ++i) {
+        Slot& slot = mSlots[i];
+        uint32_t version = slot.version.load(std::memory_order_acquire);
+        if (slot.preflop.load(std::memory_order_relaxed) != key.preflop || (version & 1))
+            continue;
+        Key slotKey = loadKey(slot);
+        if (slotKey.board != key.board || slotKey.dead != key.dead)
+            continue;
+        for (unsigned j = 0; j < mValueSize; ++j)
+            values[j] = mValues[i * mValueSize + j].load(std::memory_order_relaxed);
+        // The key and value are only valid if no writer touched the slot in the meantime.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version)
+            return false;
+        // Avoid writing to the cache line when the bit is already set.
+        if (!slot.referenced.load(std::memory_order_relaxed))
+            slot.referenced.store(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool PreflopCache::store(const Key& key, const uint32_t* values)
+{
+    omp_assert(key.preflop != 0);
+    if (mBucketCount == 0)
+        return false;
+    size_t bucket = bucketIndex(key);
+    size_t first = bucket * BUCKET_SIZE;
+
+    // Nothing to do if another thread has already stored the key. Otherwise use an empty slot if there is one.
+    size_t victim = ~(size_t)0;
+    for (size_t i = first; i < first + BUCKET_SIZE; ++i) {
+        Key slotKey = loadKey(mSlots[i]);
+        if (slotKey.preflop == key.preflop && slotKey.board == key.board && slotKey.dead == key.dead)
+            return false;
+        if (slotKey.preflop == 0 && victim == ~(size_t)0)
+            victim = i;
+    }
+
+    // CLOCK: slots that have been used since the hand last passed them get a second chance. After a full round all
+    // the bits are cleared, so the search always ends in at most two rounds.
+    if (victim == ~(size_t)0) {
+        std::atomic<uint8_t>& hand = mClockHands[bucket];
+        for (unsigned n = 0;; ++n) {
+            size_t i = first + hand.fetch_add(1, std::memory_order_relaxed) % BUCKET_SIZE;
+            if (!mSlots[i].referenced.exchange(0, std::memory_order_relaxed) || n >= BUCKET_SIZE) {
+                victim = i;
+                break;
+            }
+        }
+    }
+
+    // Lock the slot by making the version odd. If another writer has it, this result is just not stored. A process
+    // that dies while holding the lock only makes the slot unusable.
+    Slot& slot = mSlots[victim];
+    uint32_t version = slot.version.load(std::memory_order_relaxed);
+    if ((version & 1) || !slot.version.compare_exchange_strong(version, version + 1, std::memory_order_relaxed))
+        return false;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    bool evicted = slot.preflop.load(std::memory_order_relaxed) != 0;
+    slot.preflop.store(key.preflop, std::memory_order_relaxed);
+    slot.board.store(key.board, std::memory_order_relaxed);
+    slot.dead.store(key.dead, std::memory_order_relaxed);
+    for (unsigned j = 0; j < mValueSize; ++j)
+        mValues[victim * mValueSize + j].store(values[j], std::memory_order_relaxed);
+    // New entries start without the reference bit, so that preflops that are never seen again are evicted first.
+    slot.referenced.store(0, std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+    return evicted;
+}
+
+// Layout of the block: header, slots, values, clock hands.
+size_t PreflopCache::blockSize(size_t bucketCount, unsigned valueSize)
+{
+    size_t slots = bucketCount * BUCKET_SIZE;
+    return sizeof(Header) + slots * (sizeof(Slot) + valueSize * sizeof(uint32_t)) + bucketCount;
+}
+
+void PreflopCache::setBlock(char* block, size_t bucketCount, unsigned valueSize)
+{
+    static_assert(sizeof(Header) % OMP_ALIGNOF(Slot) == 0, "Slots must be aligned.");
+    static_assert(sizeof(Slot) % OMP_ALIGNOF(std::atomic<uint32_t>) == 0, "Values must be aligned.");
+    mBucketCount = bucketCount;
+    mValueSize = valueSize;
+    mSlots = (Slot*)(block + sizeof(Header));
+    mValues = (std::atomic<uint32_t>*)(mSlots + capacity());
+    mClockHands = (std::atomic<uint8_t>*)(mValues + capacity() * valueSize);
+}
+
+// Fibonacci hashing, because preflop ids are far from uniformly distributed. The hash is mapped to the bucket range
+// with a multiplication instead of a modulo.
+size_t PreflopCache::bucketIndex(const Key& key) const
+{
+    uint64_t h = key.preflop ^ (key.board * 0xff51afd7ed558ccdull) ^ (key.dead * 0xc4ceb9fe1a85ec53ull);
+    return (size_t)((((h * 0x9e3779b97f4a7c15ull) >> 32) * mBucketCount) >> 32);
+}
+
+}
@@ -0,0 +1,129 @@
+#ifndef OMP_PREFLOP_CACHE_H
+#define OMP_PREFLOP_CACHE_H
+
+#include "Util.h"
+#include "Constants.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace omp {
+
+// Fixed-memory cache for sharing the results of preflop combinations between enumeration threads. Values are arrays
+// of 32-bit counters, all of the same length, so entries only take as much memory as the current player count needs.
+//
+// The table is set-associative: a key can only be in the BUCKET_SIZE slots of its bucket, and when the bucket is
+// full the victim is chosen with the CLOCK algorithm (a hand goes around the slots and evicts the first one that
+// hasn't been used since the last time the hand passed it). Every slot is a seqlock, so lookups never take a lock or
+// wait: they just miss if the slot is being written at the same time. Writers give up the same way when another
+// writer has the slot locked. The preflop part of keys must be nonzero.
+//
+// The whole table is a single block of memory, which is either allocated by reset() or a shared memory mapping of a
+// file opened with open(). All the synchronization is done with lock-free atomics inside the block, so any number of
+// processes can use the same file at the same time, and the entries stay in the file for later runs.
+class PreflopCache
+{
+public:
+    static const unsigned BUCKET_SIZE = 8;
+
+    // Canonical preflop id together with the board and dead cards in the same suit transformation.
+    struct Key
+    {
+        uint64_t preflop, board, dead;
+    };
+
+    PreflopCache();
+    ~PreflopCache();
+
+    // Removes all entries and sets the size of the values. The table gets as many slots as fit in the memory budget,
+    // but no more than are needed for maxEntries. Must not be called concurrently with other methods.
+    void reset(size_t maxEntries, unsigned valueSize, size_t memoryBudget);
+
+    // Uses the table in a file, which is created with the given size if it doesn't exist. deckId is the ID of the deck
+    // that the values are calculated with. Returns false if the file can't be opened or mapped, or if it has a
+    // different value size or deck or isn't a cache file. The cache is then left empty. Opening the file that is
+    // already open just keeps it. Not supported on Windows.
+    bool open(const std::string& path, unsigned valueSize, size_t fileSize, uint32_t deckId = StandardDeck::ID);
+
+    // Removes the table (unmaps the file or frees the memory).
+    void close();
+
+    // Copies the value of key to values and returns true, or returns false if the key is not found.
+    bool lookup(const Key& key, uint32_t* values) const;
+
+    // Stores a value for key unless it's already stored. Returns true if another entry had to be evicted.
+    bool store(const Key& key, const uint32_t* values);
+
+    // Maximum number of entries.
+    size_t capacity() const
+    {
+        return mBucketCount * BUCKET_SIZE;
+    }
+
+    // Calls f(key, values) for every entry. Must not be called concurrently with store().
+    template<class F>
+    void forEach(F f) const
+    {
+        for (size_t i = 0; i < capacity(); ++i) {
+            Key key = loadKey(mSlots[i]);
+            if (key.preflop) {
+                uint32_t values[MAX_VALUE_SIZE];
+                for (unsigned j = 0; j < mValueSize; ++j)
+                    values[j] = mValues[i * mValueSize + j].load(std::memory_order_relaxed);
+                f(key, values);
+            }
+        }
+    }
+
+private:
+    static const unsigned MAX_VALUE_SIZE = 256;
+
+    struct Slot
+    {
+        // Odd while the slot is being written.
+        std::atomic<uint32_t> version;
+        // Set on every hit, cleared by the clock hand.
+        std::atomic<uint32_t> referenced;
+        std::atomic<uint64_t> preflop, board, dead;
+    };
+
+    // Start of the block. Also the file format, so only fixed size types.
+    struct Header
+    {
+        char magic[8];
+        uint32_t formatVersion;
+        uint32_t valueSize;
+        uint32_t deckId;
+        uint32_t reserved;
+        uint64_t bucketCount;
+    };
+
+    static size_t blockSize(size_t bucketCount, unsigned valueSize);
+    void setBlock(char* block, size_t bucketCount, unsigned valueSize);
+    size_t bucketIndex(const Key& key) const;
+    static Key loadKey(const Slot& slot)
+    {
+        return {slot.preflop.load(std::memory_order_relaxed), slot.board.load(std::memory_order_relaxed),
+                slot.dead.load(std::memory_order_relaxed)};
+    }
+
+    // Allocated memory, or null when the block is a file mapping.
+    std::unique_ptr<uint64_t[]> mMemory;
+    size_t mAllocatedSize;
+    void* mMapping;
+    size_t mMappingSize;
+    std::string mPath;
+    uint32_t mDeckId;
+
+    Slot* mSlots;
+    std::atomic<uint32_t>* mValues;
+    std::atomic<uint8_t>* mClockHands;
+    size_t mBucketCount;
+    unsigned mValueSize;
+};
+
+}
+
+#endif // OMP_PREFLOP_CACHE_H
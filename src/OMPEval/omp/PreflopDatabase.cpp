@@ -0,0 +1,195 @@
+#include "PreflopDatabase.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace omp {
+
+static const char DATABASE_MAGIC[8] = {'O', 'M', 'P', 'P', 'R', 'E', 'D', 'B'};
+static const uint32_t DATABASE_VERSION = 1;
+
+PreflopDatabase::PreflopDatabase()
+    : mMapping(nullptr), mMappingSize(0), mData(nullptr), mIndex(nullptr), mEntryCount(0), mBlockCount(0),
+      mPlayers(0)
+{
+}
+
+PreflopDatabase::~PreflopDatabase()
+{
+    close();
+}
+
+bool PreflopDatabase::open(const std::string& path)
+{
+    close();
+    #ifdef _WIN32
+    (void)path;
+    return false;
+    #else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    size_t size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+    void* p = size >= sizeof(Header) ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    // Check the header and the block index.
+    const uint8_t* data = (const uint8_t*)p;
+    const Header* header = (const Header*)p;
+    const BlockIndex* index = (const BlockIndex*)(data + sizeof(Header));
+    bool ok = std::memcmp(header->magic, DATABASE_MAGIC, sizeof(header->magic)) == 0
+            && header->formatVersion == DATABASE_VERSION && header->players >= 1 && header->players <= MAX_PLAYERS
+            && header->blockCount == (header->entryCount + BLOCK_SIZE - 1) / BLOCK_SIZE
+            && header->blockCount <= (size - sizeof(Header)) / sizeof(BlockIndex);
+    uint64_t dataStart = sizeof(Header) + header->blockCount * sizeof(BlockIndex);
+    for (uint64_t i = 0; ok && i < header->blockCount; ++i) {
+        ok = index[i].offset >= dataStart && index[i].offset < size
+                && (i == 0 || (index[i].offset > index[i - 1].offset && index[i].firstId > index[i - 1].firstId));
+    }
+    // Decode every block once, so that lookups don't need any checks. A block must have its entries with increasing
+    // ids below the first id of the next block and values that fit in 32 bits, and end where the next block starts.
+    unsigned count = ok ? valueCount(header->players) : 0;
+    for (uint64_t i = 0; ok && i < header->blockCount; ++i) {
+        const uint8_t* q = data + index[i].offset;
+        const uint8_t* end = data + (i + 1 < header->blockCount ? index[i + 1].offset : size);
+        uint64_t id = index[i].firstId, x = 0;
+        uint64_t n = std::min<uint64_t>(BLOCK_SIZE, header->entryCount - i * BLOCK_SIZE);
+        for (uint64_t j = 0; ok && j < n; ++j) {
+            ok = readVarint(q, end, x) && (j == 0 ? x == 0 : x > 0 && id + x > id);
+            id += x;
+            for (unsigned k = 0; ok && k < count; ++k)
+                ok = readVarint(q, end, x) && x <= UINT32_MAX;
+        }
+        ok = ok && q == end && (i + 1 == header->blockCount || id < index[i + 1].firstId);
+    }
+    if (!ok) {
+        munmap(p, size);
+        return false;
+    }
+
+    mMapping = p;
+    mMappingSize = size;
+    mData = data;
+    mIndex = index;
+    mEntryCount = (size_t)header->entryCount;
+    mBlockCount = (size_t)header->blockCount;
+    mPlayers = header->players;
+    return true;
+    #endif
+}
+
+void PreflopDatabase::close()
+{
+    #ifndef _WIN32
+    if (mMapping)
+        munmap(mMapping, mMappingSize);
+    #endif
+    mMapping = nullptr;
+    mMappingSize = 0;
+    mData = nullptr;
+    mIndex = nullptr;
+    mEntryCount = mBlockCount = 0;
+    mPlayers = 0;
+}
+
+bool PreflopDatabase::lookup(uint64_t preflopId, uint32_t* values) const
+{
+    if (mBlockCount == 0 || preflopId < mIndex[0].firstId)
+        return false;
+
+    // Last block that starts at or before the id.
+    const BlockIndex* block = std::upper_bound(mIndex, mIndex + mBlockCount, preflopId,
+                                               [](uint64_t id, const BlockIndex& b){ return id < b.firstId; }) - 1;
+    size_t blockIdx = block - mIndex;
+    size_t n = std::min<size_t>(BLOCK_SIZE, mEntryCount - blockIdx * BLOCK_SIZE);
+    unsigned count = valueCount(mPlayers);
+    const uint8_t* p = mData + block->offset;
+    uint64_t id = block->firstId;
+    for (size_t i = 0; i < n; ++i) {
+        id += readVarint(p);
+        if (id > preflopId)
+            return false;
+        if (id == preflopId) {
+            for (unsigned j = 0; j < count; ++j)
+                values[j] = (uint32_t)readVarint(p);
+            return true;
+        }
+        for (unsigned j = 0; j < count; ++j)
+            readVarint(p);
+    }
+    return false;
+}
+
+bool PreflopDatabase::write(const std::string& path, unsigned players, const std::vector<Entry>& entries)
+{
+    omp_assert(players >= 1 && players <= MAX_PLAYERS);
+    size_t blockCount = (entries.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<BlockIndex> index(blockCount);
+    std::vector<uint8_t> data;
+    uint64_t dataStart = sizeof(Header) + blockCount * sizeof(BlockIndex);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        omp_assert(entries[i].second.size() == valueCount(players));
+        omp_assert(i == 0 || entries[i].first > entries[i - 1].first);
+        if (i % BLOCK_SIZE == 0) {
+            index[i / BLOCK_SIZE].firstId = entries[i].first;
+            index[i / BLOCK_SIZE].offset = dataStart + data.size();
+        }
+        writeVarint(data, entries[i].first - (i % BLOCK_SIZE ? entries[i - 1].first : entries[i].first));
+        for (uint32_t v : entries[i].second)
+            writeVarint(data, v);
+    }
+
+    Header header;
+    std::memcpy(header.magic, DATABASE_MAGIC, sizeof(header.magic));
+    header.formatVersion = DATABASE_VERSION;
+    header.players = players;
+    header.entryCount = entries.size();
+    header.blockCount = blockCount;
+
+    // Written to a temporary file first, so that processes that open the database never see a partial file.
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)index.data(), index.size() * sizeof(BlockIndex));
+        out.write((const char*)data.data(), data.size());
+        if (!out)
+            return false;
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+// Reads a varint that must end before end and fit in 64 bits. Returns false if it doesn't.
+bool PreflopDatabase::readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& x)
+{
+    x = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        x |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return shift < 63 || b <= 1;
+    }
+    return false;
+}
+
+void PreflopDatabase::writeVarint(std::vector<uint8_t>& out, uint64_t x)
+{
+    while (x >= 0x80) {
+        out.push_back((uint8_t)(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back((uint8_t)x);
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef OMP_PREFLOP_DATABASE_H
+#define OMP_PREFLOP_DATABASE_H
+
+#include "Util.h"
+#include "Constants.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace omp {
+
+// Read-only database of exact preflop results for one player count, stored in a file that is memory-mapped, so the
+// pages are shared by all processes and only the parts that are used get loaded. Entries are the counters of the
+// preflop cache (wins for each combination of winners, then hand categories 1-9 of each player), keyed by canonical
+// preflop id.
+//
+// Entries are sorted by id and compressed in blocks of BLOCK_SIZE: ids are stored as differences to the previous id
+// and all numbers as varints. A lookup is a binary search in the block index and a scan of one block.
+class PreflopDatabase
+{
+public:
+    static const unsigned BLOCK_SIZE = 64;
+
+    typedef std::pair<uint64_t,std::vector<uint32_t>> Entry;
+
+    PreflopDatabase();
+    ~PreflopDatabase();
+
+    // Maps a database file. Returns false if it can't be opened or isn't a valid database. Not supported on Windows.
+    bool open(const std::string& path);
+    void close();
+
+    // Number of players of the database, 0 if none is open.
+    unsigned players() const
+    {
+        return mPlayers;
+    }
+
+    size_t size() const
+    {
+        return mEntryCount;
+    }
+
+    // Number of counters in each entry.
+    static unsigned valueCount(unsigned players)
+    {
+        return (1 << players) - 1 + players * (HAND_CATEGORY_COUNT - 1);
+    }
+
+    // Copies the values of a preflop and returns true, or returns false if the preflop is not in the database.
+    bool lookup(uint64_t preflopId, uint32_t* values) const;
+
+    // Calls f(preflopId, values) for every entry in order.
+    template<class F>
+    void forEach(F f) const
+    {
+        std::vector<uint32_t> values(valueCount(mPlayers));
+        for (size_t i = 0; i < mBlockCount; ++i) {
+            const uint8_t* p = mData + mIndex[i].offset;
+            uint64_t id = mIndex[i].firstId;
+            size_t n = std::min<size_t>(BLOCK_SIZE, mEntryCount - i * BLOCK_SIZE);
+            for (size_t j = 0; j < n; ++j) {
+                id += readVarint(p);
+                for (uint32_t& v : values)
+                    v = (uint32_t)readVarint(p);
+                f(id, values.data());
+            }
+        }
+    }
+
+    // Writes a database. Entries must be sorted by id, have unique ids and valueCount(players) values each.
+    static bool write(const std::string& path, unsigned players, const std::vector<Entry>& entries);
+
+private:
+    // File format, so only fixed size types.
+    struct Header
+    {
+        char magic[8];
+        uint32_t formatVersion;
+        uint32_t players;
+        uint64_t entryCount;
+        uint64_t blockCount;
+    };
+
+    struct BlockIndex
+    {
+        uint64_t firstId;
+        // Offset of the block from the start of the file.
+        uint64_t offset;
+    };
+
+    static uint64_t readVarint(const uint8_t*& p)
+    {
+        uint64_t x = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            uint8_t b = *p++;
+            x |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return x;
+        }
+    }
+
+    static bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& x);
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t x);
+
+    void* mMapping;
+    size_t mMappingSize;
+    const uint8_t* mData;
+    const BlockIndex* mIndex;
+    size_t mEntryCount, mBlockCount;
+    unsigned mPlayers;
+};
+
+}
+
+#endif // OMP_PREFLOP_DATABASE_H
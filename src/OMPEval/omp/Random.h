@@ -29,12 +29,30 @@ public:
         return result;
     }
 
-    static uint64_t min()
+    // Advances the generator by 2^64 steps. Used for splitting the sequence into non-overlapping streams.
+    void jump()
+    {
+        static const uint64_t JUMP[] = {0xbeac0467eba5facb, 0xd86b048b86aa9922};
+        uint64_t s0 = 0, s1 = 0;
+        for (uint64_t jump : JUMP) {
+            for (unsigned i = 0; i < 64; ++i) {
+                if (jump & (1ull << i)) {
+                    s0 ^= mState[0];
+                    s1 ^= mState[1];
+                }
+                (*this)();
+            }
+        }
+        mState[0] = s0;
+        mState[1] = s1;
+    }
+
+    static constexpr uint64_t min()
     {
         return 0;
     }
 
-    static uint64_t max()
+    static constexpr uint64_t max()
     {
         return ~(uint64_t)0;
     }
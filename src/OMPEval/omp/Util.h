@@ -24,6 +24,13 @@
     #endif
 #endif
 
+// Detect AVX2.
+#ifndef OMP_AVX2
+    #if __AVX2__
+        #define OMP_AVX2 1
+    #endif
+#endif
+
 #if _MSC_VER
     #define OMP_FORCE_INLINE __forceinline
 #else
@@ -43,6 +50,28 @@ inline unsigned countTrailingZeros(unsigned x)
     #endif
 }
 
+inline unsigned countTrailingZeros(unsigned long long x)
+{
+    #if _MSC_VER && _M_X64
+    unsigned long bitIdx;
+    _BitScanForward64(&bitIdx, x);
+    return bitIdx;
+    #elif _MSC_VER
+    return (unsigned)x ? countTrailingZeros((unsigned)x) : 32 + countTrailingZeros((unsigned)(x >> 32));
+    #else
+    return __builtin_ctzll(x);
+    #endif
+}
+
+inline unsigned countTrailingZeros(unsigned long x)
+{
+    #if _MSC_VER
+    return countTrailingZeros((unsigned)x);
+    #else
+    return countTrailingZeros((unsigned long long)x);
+    #endif
+}
+
 inline unsigned countLeadingZeros(unsigned x)
 {
     #if _MSC_VER
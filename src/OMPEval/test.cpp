@@ -1,15 +1,25 @@
 
 #include "omp/HandEvaluator.h"
 #include "omp/EquityCalculator.h"
+#include "omp/OmahaEvaluator.h"
+#include "omp/OmahaEquityCalculator.h"
 #include "omp/Random.h"
 #include "ttest/ttest.h"
 #include <iostream>
 #include <unordered_set>
 #include <unordered_map>
+#include <map>
+#include <fstream>
 #include <vector>
 #include <list>
+#include <array>
+#include <thread>
 #include <numeric>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
 
 using namespace std;
 using namespace omp;
@@ -28,6 +38,7 @@ class UtilTest : public ttest::TestBase
         TTEST_EQUAL(countTrailingZeros((uint32_t)1), 0u);
         TTEST_EQUAL(countTrailingZeros((uint32_t)0x0f000000), 24u);
         TTEST_EQUAL(countTrailingZeros((uint32_t)~0u), 0u);
+        TTEST_EQUAL(countTrailingZeros((uint64_t)1 << 40), 40u);
     }
 
     TTEST_CASE("bitCount")
@@ -230,6 +241,40 @@ class HandEvaluatorTest : public ttest::TestBase
             TTEST_EQUAL(counts[i], expected[i]);
     }
 
+    TTEST_CASE("evaluateBatch() matches evaluate()")
+    {
+        XoroShiro128Plus rng(0);
+        FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+        vector<Hand> hands;
+        for (unsigned i = 0; i < 1000; ++i) {
+            Hand h = Hand::empty();
+            uint64_t usedCards = 0;
+            for (unsigned j = 0; j < i % 8; ++j) {
+                unsigned c;
+                do {
+                    c = cardDist(rng);
+                } while (usedCards & (1ull << c));
+                usedCards |= 1ull << c;
+                h += c;
+            }
+            hands.push_back(h);
+        }
+
+        HandEvaluator::Kernel defaultKernel = HandEvaluator::kernel();
+        for (unsigned k = 0; k < HandEvaluator::KERNEL_COUNT; ++k) {
+            if (!HandEvaluator::setKernel((HandEvaluator::Kernel)k))
+                continue;
+            for (unsigned count : {0u, 1u, 2u, 3u, 5u, 8u, 13u, 17u, 1000u}) {
+                vector<uint16_t> ranks(count + 1, 0xffff);
+                e.evaluateBatch(hands.data(), ranks.data(), count);
+                for (unsigned i = 0; i < count; ++i)
+                    TTEST_EQUAL(ranks[i], e.evaluate(hands[i]));
+                TTEST_EQUAL(ranks[count], 0xffff);
+            }
+        }
+        HandEvaluator::setKernel(defaultKernel);
+    }
+
     TTEST_CASE("enumerate 7 cards hands")
     {
         uint64_t expected[10]{0, 23294460, 58627800, 31433400, 6461620, 6180020, 4047644,
@@ -238,6 +283,433 @@ class HandEvaluatorTest : public ttest::TestBase
         for (unsigned i = 0; i < 10; ++i)
             TTEST_EQUAL(counts[i], expected[i]);
     }
+
+    TTEST_CASE("evaluateCategory() matches evaluate()")
+    {
+        XoroShiro128Plus rng(0);
+        FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+        for (unsigned i = 0; i < 100000; ++i) {
+            Hand h = Hand::empty();
+            uint64_t usedCards = 0;
+            for (unsigned j = 0; j < i % 8; ++j) {
+                unsigned c;
+                do {
+                    c = cardDist(rng);
+                } while (usedCards & (1ull << c));
+                usedCards |= 1ull << c;
+                h += c;
+            }
+            TTEST_EQUAL(e.evaluateCategory(h), e.evaluate(h) / HAND_CATEGORY_OFFSET);
+            TTEST_EQUAL(e.evaluateCategory<false>(h), e.evaluate<false>(h) / HAND_CATEGORY_OFFSET);
+        }
+        // Flushes are rare in random hands, so check all of the flush keys separately.
+        for (unsigned c = 0; c < CARD_COUNT; c += 4) {
+            for (unsigned d = c + 4; d < CARD_COUNT; d += 4) {
+                for (unsigned f = d + 4; f < CARD_COUNT; f += 4) {
+                    Hand h = Hand::empty() + c + d + f + 1 + 5;
+                    for (unsigned g = f + 4; g < CARD_COUNT; g += 4) {
+                        for (unsigned k = g + 4; k < CARD_COUNT; k += 4)
+                            TTEST_EQUAL(e.evaluateCategory(h + g + k), e.evaluate(h + g + k) / HAND_CATEGORY_OFFSET);
+                    }
+                }
+            }
+        }
+    }
+};
+
+class ShortDeckHandEvaluatorTest : public ttest::TestBase
+{
+    ShortDeckHandEvaluator e;
+    uint64_t counts[10]{};
+    static const unsigned FIRST_CARD = 4 * ShortDeck::LOWEST_RANK;
+
+    void enumerate(unsigned cardsLeft, const Hand& h = Hand::empty(), unsigned start = FIRST_CARD)
+    {
+        for (unsigned c = start; c < 52; ++c) {
+            if (cardsLeft == 1)
+                ++counts[e.evaluate(h + c) >> HAND_CATEGORY_SHIFT];
+            else
+                enumerate(cardsLeft - 1, h + c, c + 1);
+        }
+    }
+
+    Hand hand(const string& text)
+    {
+        Hand h = Hand::empty();
+        uint64_t mask = CardRange::getCardMask(text);
+        for (unsigned c = 0; c < CARD_COUNT; ++c) {
+            if (mask & (1ull << c))
+                h += c;
+        }
+        return h;
+    }
+
+    vector<unsigned> randomCards(XoroShiro128Plus& rng, unsigned count)
+    {
+        FastUniformIntDistribution<unsigned,16> cardDist(FIRST_CARD, CARD_COUNT - 1);
+        vector<unsigned> cards;
+        uint64_t usedCards = 0;
+        while (cards.size() < count) {
+            unsigned c = cardDist(rng);
+            if (!(usedCards & (1ull << c)))
+                cards.push_back(c);
+            usedCards |= 1ull << c;
+        }
+        return cards;
+    }
+
+    TTEST_CASE("enumerate 5 cards hands")
+    {
+        uint64_t expected[10]{0, 122400, 193536, 36288, 16128, 6120, 1728, 480, 288, 24};
+        enumerate(5);
+        for (unsigned i = 0; i < 10; ++i)
+            TTEST_EQUAL(counts[i], expected[i]);
+        TTEST_EQUAL(counts[ShortDeck::FULL_HOUSE >> HAND_CATEGORY_SHIFT], 1728u);
+        TTEST_EQUAL(counts[ShortDeck::FLUSH >> HAND_CATEGORY_SHIFT], 480u);
+    }
+
+    TTEST_CASE("hand order")
+    {
+        TTEST_EQUAL(e.evaluate(hand("AsKsQs9s7s")) > e.evaluate(hand("KcKdKhQcQd")), true);
+        TTEST_EQUAL(e.evaluate(hand("AsKsQs9s7s")) / HAND_CATEGORY_OFFSET, ShortDeck::FLUSH / HAND_CATEGORY_OFFSET);
+        TTEST_EQUAL(e.evaluate(hand("As6d7c8h9s")) / HAND_CATEGORY_OFFSET, STRAIGHT / HAND_CATEGORY_OFFSET);
+        TTEST_EQUAL(e.evaluate(hand("As6d7c8h9s")) < e.evaluate(hand("6d7c8h9sTs")), true);
+        TTEST_EQUAL(e.evaluate(hand("As6d7c8h9s")) > e.evaluate(hand("AcAdAhKsQs")), true);
+        TTEST_EQUAL(e.evaluate(hand("As6s7s8s9s")) / HAND_CATEGORY_OFFSET, STRAIGHT_FLUSH / HAND_CATEGORY_OFFSET);
+        TTEST_EQUAL(e.evaluate(hand("As6s7s8s9s")) < e.evaluate(hand("6s7s8s9sTs")), true);
+        TTEST_EQUAL(e.evaluate(hand("As6s7s8s9sTsKd")), e.evaluate(hand("6s7s8s9sTs")));
+        TTEST_EQUAL(e.evaluateCategory(hand("AsKsQs9s7s")), ShortDeck::FLUSH / HAND_CATEGORY_OFFSET);
+        TTEST_EQUAL(e.evaluateCategory(hand("KcKdKhQcQd")), ShortDeck::FULL_HOUSE / HAND_CATEGORY_OFFSET);
+    }
+
+    TTEST_CASE("7 card hands match the best 5 card hand")
+    {
+        XoroShiro128Plus rng(0);
+        for (unsigned i = 0; i < 100000; ++i) {
+            vector<unsigned> cards = randomCards(rng, 7);
+            Hand h = Hand::empty();
+            for (unsigned c : cards)
+                h += c;
+            uint16_t best = 0;
+            for (unsigned a = 0; a < 7; ++a) {
+                for (unsigned b = a + 1; b < 7; ++b) {
+                    Hand h5 = Hand::empty();
+                    for (unsigned j = 0; j < 7; ++j) {
+                        if (j != a && j != b)
+                            h5 += cards[j];
+                    }
+                    best = max(best, e.evaluate(h5));
+                }
+            }
+            TTEST_EQUAL(e.evaluate(h), best);
+            TTEST_EQUAL(e.evaluateCategory(h), best / HAND_CATEGORY_OFFSET);
+        }
+    }
+
+    TTEST_CASE("evaluateBatch() matches evaluate()")
+    {
+        XoroShiro128Plus rng(0);
+        vector<Hand> hands;
+        for (unsigned i = 0; i < 1000; ++i) {
+            Hand h = Hand::empty();
+            for (unsigned c : randomCards(rng, i % 8))
+                h += c;
+            hands.push_back(h);
+        }
+
+        HandEvaluator::Kernel defaultKernel = HandEvaluator::kernel();
+        for (unsigned k = 0; k < HandEvaluator::KERNEL_COUNT; ++k) {
+            if (!HandEvaluator::setKernel((HandEvaluator::Kernel)k))
+                continue;
+            vector<uint16_t> ranks(hands.size());
+            e.evaluateBatch(hands.data(), ranks.data(), hands.size());
+            for (unsigned i = 0; i < hands.size(); ++i)
+                TTEST_EQUAL(ranks[i], e.evaluate(hands[i]));
+        }
+        HandEvaluator::setKernel(defaultKernel);
+    }
+};
+
+class CompactHandEvaluatorTest : public ttest::TestBase
+{
+    CompactHandEvaluator e;
+    HandEvaluator e2;
+
+    // Goes through all hands of n cards and checks that the hands that HandEvaluator ranks equal are also equal here
+    // and that the order of the values is the same.
+    void compareToHandEvaluator(unsigned n)
+    {
+        vector<int> values(1 << 16, -1);
+        unsigned cards[7];
+        for (unsigned i = 0; i < n; ++i)
+            cards[i] = i;
+        for (;;) {
+            Hand h = Hand::empty();
+            for (unsigned i = 0; i < n; ++i)
+                h += cards[i];
+            uint16_t value = e.evaluate(h), value2 = e2.evaluate(h);
+            TTEST_EQUAL(value >> HAND_CATEGORY_SHIFT, value2 >> HAND_CATEGORY_SHIFT);
+            if (values[value2] < 0)
+                values[value2] = value;
+            TTEST_EQUAL(values[value2], value);
+            if (!h.hasFlush())
+                TTEST_EQUAL(e.evaluate<false>(h), value);
+
+            unsigned i = n;
+            while (i > 0 && cards[i - 1] == CARD_COUNT - n + i - 1)
+                --i;
+            if (i == 0)
+                break;
+            ++cards[i - 1];
+            for (; i < n; ++i)
+                cards[i] = cards[i - 1] + 1;
+        }
+        int previous = -1;
+        for (int value : values) {
+            if (value >= 0) {
+                TTEST_EQUAL(value > previous, true);
+                previous = value;
+            }
+        }
+    }
+
+    TTEST_CASE("ranks 5 card hands in the same order as HandEvaluator") { compareToHandEvaluator(5); }
+    TTEST_CASE("ranks 6 card hands in the same order as HandEvaluator") { compareToHandEvaluator(6); }
+    TTEST_CASE("ranks 7 card hands in the same order as HandEvaluator") { compareToHandEvaluator(7); }
+
+    TTEST_CASE("evaluateBatch() matches evaluate()")
+    {
+        XoroShiro128Plus rng(0);
+        FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+        vector<Hand> hands;
+        for (unsigned i = 0; i < 1000; ++i) {
+            Hand h = Hand::empty();
+            uint64_t usedCards = 0;
+            for (unsigned j = 0; j < 5 + i % 3; ++j) {
+                unsigned c;
+                do {
+                    c = cardDist(rng);
+                } while (usedCards & (1ull << c));
+                usedCards |= 1ull << c;
+                h += c;
+            }
+            hands.push_back(h);
+        }
+        vector<uint16_t> ranks(hands.size());
+        e.evaluateBatch(hands.data(), ranks.data(), hands.size());
+        for (unsigned i = 0; i < hands.size(); ++i)
+            TTEST_EQUAL(ranks[i], e.evaluate(hands[i]));
+    }
+};
+
+class PreflopCacheTest : public ttest::TestBase
+{
+    PreflopCache cache;
+
+    static PreflopCache::Key key(uint64_t preflop, uint64_t board = 0)
+    {
+        return {preflop, board, 0};
+    }
+
+    TTEST_BEFORE()
+    {
+        cache.reset(1000, 4, 1 << 20);
+    }
+
+    TTEST_CASE("stores and finds values")
+    {
+        uint32_t v[4];
+        TTEST_EQUAL(cache.lookup(key(5), v), false);
+        uint32_t v1[4] = {1, 2, 3, 4}, v2[4] = {5, 6, 7, 8};
+        cache.store(key(5), v1);
+        cache.store(key(5), v2);
+        TTEST_EQUAL(cache.lookup(key(5), v), true);
+        TTEST_EQUAL(v[3], 4u);
+        TTEST_EQUAL(cache.lookup(key(5, 1), v), false);
+        cache.store(key(5, 1), v2);
+        TTEST_EQUAL(cache.lookup(key(5, 1), v), true);
+        TTEST_EQUAL(v[3], 8u);
+        cache.reset(1000, 4, 1 << 20);
+        TTEST_EQUAL(cache.lookup(key(5), v), false);
+    }
+
+    TTEST_CASE("stays within the memory budget")
+    {
+        cache.reset(1000000, 4, 1 << 16);
+        TTEST_EQUAL(cache.capacity() * 48 <= (1u << 16), true);
+        TTEST_EQUAL(cache.capacity() * 48 > (1u << 15), true);
+        cache.reset(100, 4, 1 << 20);
+        TTEST_EQUAL(cache.capacity(), 104u);
+    }
+
+    TTEST_CASE("evicts entries that are not used")
+    {
+        cache.reset(1, 4, 1 << 20);
+        TTEST_EQUAL(cache.capacity(), (size_t)PreflopCache::BUCKET_SIZE);
+        uint32_t v[4] = {1, 1, 1, 1};
+        cache.store(key(1000), v);
+        unsigned evictions = 0;
+        for (uint64_t id = 1; id <= 100; ++id) {
+            TTEST_EQUAL(cache.lookup(key(1000), v), true);
+            v[0] = (uint32_t)id;
+            evictions += cache.store(key(id), v);
+        }
+        TTEST_EQUAL(evictions, 100u - (PreflopCache::BUCKET_SIZE - 1));
+        TTEST_EQUAL(cache.lookup(key(100), v), true);
+        TTEST_EQUAL(v[0], 100u);
+    }
+
+    TTEST_CASE("concurrent stores and lookups")
+    {
+        cache.reset(400000, 4, 1 << 24);
+        vector<thread> threads;
+        bool ok[4] = {};
+        for (unsigned t = 0; t < 4; ++t) {
+            threads.emplace_back([this,t,&ok]{
+                bool valid = true;
+                for (unsigned i = 1; i <= 50000; ++i) {
+                    uint32_t id = i * 4 + t % 2; // Two threads store each key.
+                    uint32_t v[4] = {id, id, id, id};
+                    cache.store(key(id), v);
+                    // Can miss if another thread is writing the same slot.
+                    if (cache.lookup(key(id), v) && (v[0] != id || v[3] != id))
+                        valid = false;
+                }
+                ok[t] = valid;
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        for (unsigned t = 0; t < 4; ++t)
+            TTEST_EQUAL(ok[t], true);
+        unsigned found = 0;
+        for (uint32_t id = 4; id <= 200001; id += (id & 1) ? 3 : 1) {
+            uint32_t v[4];
+            if (cache.lookup(key(id), v)) {
+                TTEST_EQUAL(v[0], id);
+                ++found;
+            }
+        }
+        TTEST_EQUAL(found > 99000, true);
+    }
+
+    #ifndef _WIN32
+    TTEST_CASE("entries persist in a file")
+    {
+        const char* path = "preflop-cache-test.tmp";
+        std::remove(path);
+        uint32_t v[4] = {1, 2, 3, 4};
+        TTEST_EQUAL(cache.open(path, 4, 1 << 16), true);
+        TTEST_EQUAL(cache.capacity() * 48 <= (1u << 16), true);
+        cache.store(key(7, 3), v);
+        size_t capacity = cache.capacity();
+        cache.close();
+
+        PreflopCache other;
+        TTEST_EQUAL(other.open(path, 5, 1 << 16), false);
+        TTEST_EQUAL(other.open(path, 4, 1 << 16, ShortDeck::ID), false);
+        TTEST_EQUAL(other.open(path, 4, 1 << 20), true);
+        TTEST_EQUAL(other.capacity(), capacity);
+        TTEST_EQUAL(other.lookup(key(7, 3), v), true);
+        TTEST_EQUAL(other.lookup(key(7), v), false);
+        TTEST_EQUAL(v[3], 4u);
+        // A second mapping of the same file sees new entries immediately.
+        TTEST_EQUAL(cache.open(path, 4, 1 << 16), true);
+        v[3] = 5;
+        cache.store(key(8), v);
+        TTEST_EQUAL(other.lookup(key(8), v), true);
+        TTEST_EQUAL(v[3], 5u);
+        other.close();
+        cache.reset(1000, 4, 1 << 20);
+        std::remove(path);
+    }
+    #endif
+};
+
+class PreflopDatabaseTest : public ttest::TestBase
+{
+    const char* path = "preflop-database-test.tmp";
+
+    TTEST_BEFORE()
+    {
+        std::remove(path);
+    }
+
+    #ifndef _WIN32
+    TTEST_CASE("finds written entries")
+    {
+        std::vector<PreflopDatabase::Entry> entries;
+        unsigned valueCount = PreflopDatabase::valueCount(3);
+        for (uint64_t id = 10; id < 10000; id += 7)
+            entries.emplace_back(id, std::vector<uint32_t>(valueCount, (uint32_t)(id * 1000)));
+        TTEST_EQUAL(PreflopDatabase::write(path, 3, entries), true);
+        PreflopDatabase db;
+        TTEST_EQUAL(db.open(path), true);
+        TTEST_EQUAL(db.players(), 3u);
+        TTEST_EQUAL(db.size(), entries.size());
+        std::vector<uint32_t> v(valueCount);
+        for (uint64_t id = 0; id < 10010; ++id) {
+            bool found = db.lookup(id, v.data());
+            TTEST_EQUAL(found, id >= 10 && id < 10000 && id % 7 == 3);
+            if (found)
+                TTEST_EQUAL(v[valueCount - 1], id * 1000);
+        }
+        size_t count = 0;
+        db.forEach([&](uint64_t id, const uint32_t* values){
+            TTEST_EQUAL(id, entries[count].first);
+            TTEST_EQUAL(values[0], entries[count++].second[0]);
+        });
+        TTEST_EQUAL(count, entries.size());
+        db.close();
+        std::remove(path);
+    }
+
+    TTEST_CASE("rejects invalid files")
+    {
+        PreflopDatabase db;
+        TTEST_EQUAL(db.open(path), false);
+        std::ofstream(path) << "not a database";
+        TTEST_EQUAL(db.open(path), false);
+        TTEST_EQUAL(db.players(), 0u);
+        std::remove(path);
+    }
+
+    TTEST_CASE("rejects files with corrupted blocks")
+    {
+        std::vector<PreflopDatabase::Entry> entries;
+        for (uint64_t id = 1; id <= 4 * PreflopDatabase::BLOCK_SIZE; ++id)
+            entries.emplace_back(id * 1000, std::vector<uint32_t>(PreflopDatabase::valueCount(2), (uint32_t)id << 20));
+        TTEST_EQUAL(PreflopDatabase::write(path, 2, entries), true);
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        // The header has 32 bytes and is followed by the index, where each block has its first id and offset.
+        uint64_t offsets[3];
+        for (unsigned i = 0; i < 3; ++i)
+            std::memcpy(&offsets[i], file.data() + 32 + 16 * (i + 1) + 8, 8);
+
+        PreflopDatabase db;
+        std::vector<std::vector<char>> corrupted(4, file);
+        // Varints of the second block that run into the third one.
+        std::fill(corrupted[0].begin() + offsets[0], corrupted[0].begin() + offsets[1], (char)0x80);
+        // An entry that ends in the middle of a varint.
+        corrupted[1][offsets[1] - 1] |= 0x80;
+        // A block that has bytes left over after its entries.
+        offsets[1] += 1;
+        std::memcpy(corrupted[2].data() + 32 + 16 * 2 + 8, &offsets[1], 8);
+        // A value that doesn't fit in 32 bits.
+        for (unsigned i = 0; i < 5; ++i)
+            corrupted[3][offsets[0] + 2 + i] = (char)0xff;
+        for (auto& bytes : corrupted) {
+            std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+            TTEST_EQUAL(db.open(path), false);
+        }
+        std::ofstream(path, std::ios::binary).write(file.data(), file.size());
+        TTEST_EQUAL(db.open(path), true);
+        db.close();
+        std::remove(path);
+    }
+    #endif
 };
 
 class EquityCalculatorTest : public ttest::TestBase
@@ -268,8 +740,12 @@ class EquityCalculatorTest : public ttest::TestBase
         return td;
     }(); // Workaround for MSVC2013's incomplete initializer list support.
 
-    void enumTest(const TestCase& tc)
+    template<class TEquityCalculator = EquityCalculator>
+    void enumTest(const TestCase& tc, typename TEquityCalculator::Enumeration enumeration
+                  = TEquityCalculator::ENUMERATION_AUTO)
     {
+        TEquityCalculator eq;
+        eq.setEnumeration(enumeration);
         std::vector<CardRange> ranges2(tc.ranges.begin(), tc.ranges.end());
         if (!eq.start(ranges2, CardRange::getCardMask(tc.board), CardRange::getCardMask(tc.dead), true))
                 throw ttest::TestException("Invalid hand ranges!");
@@ -277,6 +753,10 @@ class EquityCalculatorTest : public ttest::TestBase
         auto results = eq.getResults();
         for (unsigned i = 0; i < (1u << tc.ranges.size()); ++i)
             TTEST_EQUAL(results.winsByPlayerMask[i], tc.expectedResults[i]);
+        for (unsigned i = 0; i < tc.ranges.size(); ++i) {
+            uint64_t hands = accumulate(begin(results.handCategories[i]), end(results.handCategories[i]), 0ull);
+            TTEST_EQUAL(hands, results.hands);
+        }
     }
 
     void monteCarloTest(const TestCase& tc)
@@ -303,6 +783,30 @@ class EquityCalculatorTest : public ttest::TestBase
             throw ttest::TestException("Didn't converge to correct results in time!");
     }
 
+    // Enumerates with another engine and with preflop-major enumeration on a calculator of its own, and checks that
+    // both give the same wins and hand categories. Returns the results of the other engine first.
+    std::array<EquityCalculator::Results,2> compareEnumerations(const std::vector<CardRange>& ranges,
+            uint64_t board = 0, uint64_t dead = 0,
+            EquityCalculator::Enumeration other = EquityCalculator::ENUMERATION_BOARD_MAJOR, unsigned threadCount = 0)
+    {
+        EquityCalculator eq;
+        std::array<EquityCalculator::Results,2> results;
+        for (unsigned i = 0; i < 2; ++i) {
+            eq.setEnumeration(i ? EquityCalculator::ENUMERATION_PREFLOP_MAJOR : other);
+            if (!eq.start(ranges, board, dead, true, 0, nullptr, 0.2, threadCount))
+                throw ttest::TestException("Invalid hand ranges!");
+            eq.wait();
+            results[i] = eq.getResults();
+        }
+        for (unsigned i = 0; i < (1u << ranges.size()); ++i)
+            TTEST_EQUAL(results[1].winsByPlayerMask[i], results[0].winsByPlayerMask[i]);
+        for (unsigned i = 0; i < ranges.size(); ++i) {
+            for (unsigned j = 0; j < HAND_CATEGORY_COUNT; ++j)
+                TTEST_EQUAL(results[1].handCategories[i][j], results[0].handCategories[i][j]);
+        }
+        return results;
+    }
+
     TTEST_BEFORE()
     {
         eq.setTimeLimit(0);
@@ -366,6 +870,105 @@ class EquityCalculatorTest : public ttest::TestBase
         TTEST_EQUAL(r.hands >= 3000000 && r.hands <= 3000000 + 16 * 0x1000, true);
     }
 
+    TTEST_CASE("seeded monte carlo is reproducible")
+    {
+        // Stopped by the hand limit and by the stdev target.
+        for (unsigned i = 0; i < 2; ++i) {
+            eq.setHandLimit(i ? 0 : 1000000);
+            EquityCalculator::Results results[3];
+            for (unsigned j = 0; j < 3; ++j) {
+                eq.setSeed(j < 2 ? 123 : 124);
+                eq.start({"AK", "QQ", "random"}, 0, 0, false, i ? 1e-3 : 0, nullptr, 0.2, 3);
+                eq.wait();
+                results[j] = eq.getResults();
+            }
+            TTEST_EQUAL(results[0].hands, results[1].hands);
+            for (unsigned j = 0; j < 8; ++j)
+                TTEST_EQUAL(results[0].winsByPlayerMask[j], results[1].winsByPlayerMask[j]);
+            TTEST_EQUAL(results[0].equity[0] != results[2].equity[0], true);
+        }
+        eq.setSeed(0);
+    }
+
+    TTEST_CASE("seeded monte carlo counts each showdown once")
+    {
+        // Each of the 3 threads stops after the batch of 4096 showdowns that reaches its share of 10000 hands.
+        eq.setSeed(123);
+        eq.setHandLimit(30000);
+        eq.start({"AK", "QQ"}, 0, 0, false, 0, nullptr, 0.2, 3);
+        eq.wait();
+        eq.setSeed(0);
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.hands, 3u * 3 * 4096);
+        TTEST_EQUAL(r.evaluations, r.hands);
+    }
+
+    TTEST_CASE("periodic updates merge the results of all threads")
+    {
+        eq.setHandLimit(0);
+        uint64_t lastHands = 0;
+        bool ordered = true, consistent = true;
+        auto check = [&](const EquityCalculator::Results& r){
+            uint64_t hands = 0;
+            for (unsigned i = 0; i < 4; ++i)
+                hands += r.winsByPlayerMask[i];
+            consistent &= hands == r.hands && r.intervalHands == r.hands - lastHands;
+            ordered &= r.hands >= lastHands;
+            lastHands = r.hands;
+        };
+        eq.start({"random", "AK"}, 0, 0, false, 1e-4, check, 0.01, 8);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.finished && ordered && consistent && r.hands == lastHands, true);
+        TTEST_EQUAL(r.stdev < 1e-4, true);
+    }
+
+    TTEST_CASE("hand categories")
+    {
+        eq.start({"AA", "76s"}, CardRange::getCardMask("Ah5h4h3c9d"), 0, true);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.handCategories[0][THREE_OF_A_KIND >> HAND_CATEGORY_SHIFT], 12u);
+        TTEST_EQUAL(r.handCategories[1][STRAIGHT >> HAND_CATEGORY_SHIFT], 9u);
+        TTEST_EQUAL(r.handCategories[1][FLUSH >> HAND_CATEGORY_SHIFT], 3u);
+        TTEST_EQUAL(r.hands, 12u);
+    }
+
+    TTEST_CASE("short deck")
+    {
+        // Flush beats full house in short deck.
+        ShortDeckEquityCalculator eq2;
+        eq2.start({"AsKs", "9h9d"}, CardRange::getCardMask("QsQh9s8s7c"), 0, true);
+        eq2.wait();
+        TTEST_EQUAL(eq2.getResults().wins[0], 1u);
+        eq.start({"AsKs", "9h9d"}, CardRange::getCardMask("QsQh9s8s7c"), 0, true);
+        eq.wait();
+        TTEST_EQUAL(eq.getResults().wins[1], 1u);
+
+        // Cards below six are not in the deck.
+        TTEST_EQUAL(eq2.start({"AA", "55"}), false);
+        TTEST_EQUAL(eq2.start({"AA", "KK"}, CardRange::getCardMask("2c")), false);
+        eq2.start({"AK", "random"}, CardRange::getCardMask("AcKc6d"), 0, true);
+        eq2.wait();
+        TTEST_EQUAL(eq2.getResults().hands, 9u * 465 * 406); // 31 choose 2 hands and 29 choose 2 boards
+    }
+
+    TTEST_CASE("short deck monte carlo deals from the live deck")
+    {
+        // A third of the cards are blocked preflop, so the board is dealt from a live deck.
+        ShortDeckEquityCalculator eq2;
+        eq2.start({"AK", "QQ", "JT"}, 0, 0, true);
+        eq2.wait();
+        auto exact = eq2.getResults();
+        eq2.setHandLimit(4000000);
+        eq2.start({"AK", "QQ", "JT"});
+        eq2.wait();
+        auto r = eq2.getResults();
+        TTEST_EQUAL(r.hands >= 4000000, true);
+        for (unsigned i = 0; i < 3; ++i)
+            TTEST_EQUAL(std::abs(r.equity[i] - exact.equity[i]) < 2e-3, true);
+    }
+
     TTEST_CASE("test 1 - enumeration") { enumTest(TESTDATA[0]); }
     TTEST_CASE("test 1 - monte carlo") { monteCarloTest(TESTDATA[0]); }
     TTEST_CASE("test 2 - enumeration") { enumTest(TESTDATA[1]); }
@@ -378,6 +981,520 @@ class EquityCalculatorTest : public ttest::TestBase
     TTEST_CASE("test 5 - monte carlo") { monteCarloTest(TESTDATA[4]); }
     TTEST_CASE("test 6 - enumeration") { enumTest(TESTDATA[5]); }
     TTEST_CASE("test 6 - monte carlo") { monteCarloTest(TESTDATA[5]); }
+    TTEST_CASE("test 2 - enumeration with CompactHandEvaluator") { enumTest<CompactEquityCalculator>(TESTDATA[1]); }
+    TTEST_CASE("test 4 - enumeration with CompactHandEvaluator") { enumTest<CompactEquityCalculator>(TESTDATA[3]); }
+    TTEST_CASE("test 2 - board-major enumeration with CompactHandEvaluator")
+    {
+        enumTest<CompactEquityCalculator>(TESTDATA[1], CompactEquityCalculator::ENUMERATION_BOARD_MAJOR);
+    }
+
+    TTEST_CASE("board-major enumeration matches preflop-major")
+    {
+        for (auto& tc : TESTDATA) {
+            enumTest(tc, EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+            enumTest(tc, EquityCalculator::ENUMERATION_BOARD_MAJOR);
+        }
+    }
+
+    TTEST_CASE("heads-up preflops use the precalculated results")
+    {
+        auto results = compareEnumerations({"KK+,AQs,T9s,72o", "JJ-99,AK,KQs"});
+        TTEST_EQUAL(results[1].evaluations, 0u);
+        TTEST_EQUAL(results[1].cacheMisses, 0u);
+    }
+
+    TTEST_CASE("heads-up preflops use the precalculated results by default")
+    {
+        // Wide enough ranges for board-major enumeration to need fewer evaluations than enumerating every preflop.
+        eq.start({"22+,AKs", "random"}, 0, 0, true);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.progress, 1.0);
+        TTEST_EQUAL(r.evaluations, 0u);
+        TTEST_EQUAL(r.cacheMisses, 0u);
+        TTEST_EQUAL(r.cacheHits, r.preflopCombos);
+    }
+
+    TTEST_CASE("automatic enumeration picks the faster engine")
+    {
+        // Board-major enumeration takes from seconds to minutes without board cards, so an engine that runs out of
+        // time is the slower one.
+        struct Query { std::vector<CardRange> ranges; const char* board; const char* dead; };
+        const Query queries[] = {{{"22+,AKs", "random"}, "", ""}, {{"random", "random"}, "", ""},
+                                 {{"random", "random"}, "Ks7d2h", ""}, {{"22+,AKs", "random"}, "Ks7d2h", ""},
+                                 {{"AK", "QQ"}, "", "2c"}, {{"AA,KK", "QQ,JJ"}, "", "2c3d"}};
+        EquityCalculator eq2;
+        eq2.setTimeLimit(2);
+        for (auto& q : queries) {
+            uint64_t board = CardRange::getCardMask(q.board), dead = CardRange::getCardMask(q.dead);
+            double times[2];
+            for (unsigned i = 0; i < 2; ++i) {
+                eq2.setEnumeration(i ? EquityCalculator::ENUMERATION_BOARD_MAJOR
+                                     : EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+                eq2.start(q.ranges, board, dead, true);
+                eq2.wait();
+                auto r = eq2.getResults();
+                times[i] = r.progress == 1 ? r.time : INFINITY;
+            }
+            eq2.setEnumeration(EquityCalculator::ENUMERATION_AUTO);
+            eq2.start(q.ranges, board, dead, true);
+            eq2.wait();
+            auto r = eq2.getResults();
+            // Only preflop-major enumeration uses the preflop cache.
+            TTEST_EQUAL(r.cacheHits + r.cacheMisses > 0, times[0] < times[1]);
+        }
+    }
+
+    TTEST_CASE("many threads share the work of both enumerations")
+    {
+        // More threads than cores, so threads finish at different times and steal from each other.
+        for (auto& tc : {TESTDATA[1], TESTDATA[2], TESTDATA[5]}) {
+            std::vector<CardRange> ranges(tc.ranges.begin(), tc.ranges.end());
+            uint64_t board = CardRange::getCardMask(tc.board), dead = CardRange::getCardMask(tc.dead);
+            auto results = compareEnumerations(ranges, board, dead, EquityCalculator::ENUMERATION_BOARD_MAJOR, 16);
+            for (auto& r : results) {
+                TTEST_EQUAL(r.progress, 1.0);
+                for (unsigned j = 0; j < (1u << tc.ranges.size()); ++j)
+                    TTEST_EQUAL(r.winsByPlayerMask[j], tc.expectedResults[j]);
+            }
+        }
+    }
+
+    TTEST_CASE("preflop enumeration uses one preflop of each suit class")
+    {
+        // The ranges are small enough to be combined into one range of the 648 preflops without conflicts. All
+        // suits are interchangeable, so they fall into 42 classes.
+        const TestCase& tc = TESTDATA[5];
+        std::vector<CardRange> ranges(tc.ranges.begin(), tc.ranges.end());
+        eq.start(ranges, 0, 0, true);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.preflopCombos, 42u);
+        for (unsigned i = 0; i < (1u << tc.ranges.size()); ++i)
+            TTEST_EQUAL(r.winsByPlayerMask[i], tc.expectedResults[i]);
+
+        // Only diamonds and spades are interchangeable, so the classes of the 576 preflops have 1 or 2 preflops.
+        eq.start({"AK", "QQ", "JJ"}, CardRange::getCardMask("2c3h"), 0, true);
+        eq.wait();
+        r = eq.getResults();
+        TTEST_EQUAL(r.preflopCombos, 296u);
+    }
+
+    TTEST_CASE("preflop enumeration only visits preflops that don't share cards")
+    {
+        // Too many preflops for one combined range, so the second range is combined with the third one and
+        // conflicts between them and the first range remain. The board has all suits, so there are no suit
+        // symmetries and every preflop is enumerated.
+        std::vector<CardRange> ranges(3, CardRange("KK+,AK"));
+        uint64_t board = CardRange::getCardMask("2c3h4d5s");
+        uint64_t preflops = 0;
+        for (auto& h0 : ranges[0].combinations()) {
+            for (auto& h1 : ranges[1].combinations()) {
+                for (auto& h2 : ranges[2].combinations()) {
+                    uint64_t mask = 0;
+                    for (auto& h : {h0, h1, h2})
+                        mask |= (1ull << h[0]) | (1ull << h[1]);
+                    preflops += bitCount(mask) == 6;
+                }
+            }
+        }
+
+        auto results = compareEnumerations(ranges, board, 0, EquityCalculator::ENUMERATION_BOARD_MAJOR, 2);
+        TTEST_EQUAL(results[1].skippedPreflopCombos, 0u);
+        TTEST_EQUAL(results[1].preflopCombos, preflops);
+        TTEST_EQUAL(results[1].hands, preflops * 42);
+        TTEST_EQUAL(results[1].progress, 1.0);
+    }
+
+    TTEST_CASE("preflops with interchangeable suits enumerate fewer boards")
+    {
+        // Clubs and diamonds are interchangeable, and so are hearts and spades.
+        auto results = compareEnumerations({"AcAd", "KcKd", "QhQs"});
+        TTEST_EQUAL(results[1].hands, 1370754u);
+        TTEST_EQUAL(results[1].evaluations * 10 < results[1].hands, true);
+    }
+
+    TTEST_CASE("canonical preflops don't depend on the order of players")
+    {
+        XoroShiro128Plus rng(0);
+        FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+        for (unsigned n = 1; n <= MAX_PLAYERS; ++n) {
+            for (unsigned i = 0; i < 1000; ++i) {
+                std::array<std::array<uint8_t,2>,MAX_PLAYERS> hands, permuted;
+                uint64_t usedCards = 0;
+                for (unsigned j = 0; j < 2 * n; ++j) {
+                    unsigned c;
+                    do {
+                        c = cardDist(rng);
+                    } while (usedCards & (1ull << c));
+                    usedCards |= 1ull << c;
+                    hands[j / 2][j % 2] = (uint8_t)c;
+                }
+                for (unsigned j = 0; j < n; ++j)
+                    permuted[(j + i) % n] = hands[j];
+                uint64_t id = EquityCalculator::canonicalizePreflop(hands.data(), n);
+                TTEST_EQUAL(EquityCalculator::canonicalizePreflop(permuted.data(), n), id);
+                TTEST_EQUAL(std::equal(hands.begin(), hands.begin() + n, permuted.begin()), true);
+            }
+        }
+    }
+
+    #ifndef _WIN32
+    TTEST_CASE("3-player preflops use the preflop database")
+    {
+        // Database of the canonical preflops of the test case, built like genpreflopdb does.
+        const TestCase& tc = TESTDATA[5];
+        std::vector<CardRange> ranges(tc.ranges.begin(), tc.ranges.end());
+        std::map<uint64_t,std::array<std::array<uint8_t,2>,3>> preflops;
+        for (auto& h0 : ranges[0].combinations()) {
+            for (auto& h1 : ranges[1].combinations()) {
+                for (auto& h2 : ranges[2].combinations()) {
+                    std::array<std::array<uint8_t,2>,3> hands = {{h0, h1, h2}};
+                    uint64_t mask = 0;
+                    for (auto& h : hands)
+                        mask |= (1ull << h[0]) | (1ull << h[1]);
+                    if (bitCount(mask) == 6)
+                        preflops[EquityCalculator::canonicalizePreflop(hands.data(), 3)] = hands;
+                }
+            }
+        }
+        std::vector<PreflopDatabase::Entry> entries;
+        for (auto& p : preflops) {
+            std::vector<CardRange> hands;
+            for (auto& h : p.second)
+                hands.push_back(CardRange(std::vector<std::array<uint8_t,2>>{h}));
+            eq.start(hands, 0, 0, true);
+            eq.wait();
+            auto r = eq.getResults();
+            entries.emplace_back(p.first, std::vector<uint32_t>(r.winsByPlayerMask + 1, r.winsByPlayerMask + 8));
+            for (unsigned i = 0; i < 3; ++i)
+                entries.back().second.insert(entries.back().second.end(), r.handCategories[i] + 1,
+                                             r.handCategories[i] + HAND_CATEGORY_COUNT);
+        }
+        const char* path = "preflop-database-test.tmp";
+        TTEST_EQUAL(PreflopDatabase::write(path, 3, entries), true);
+
+        EquityCalculator eq2;
+        TTEST_EQUAL(eq2.setPreflopDatabase(path), true);
+        eq2.start(ranges, 0, 0, true);
+        eq2.wait();
+        auto r = eq2.getResults();
+        std::remove(path);
+        TTEST_EQUAL(r.evaluations, 0u);
+        for (unsigned i = 0; i < (1u << tc.ranges.size()); ++i)
+            TTEST_EQUAL(r.winsByPlayerMask[i], tc.expectedResults[i]);
+        for (unsigned i = 0; i < tc.ranges.size(); ++i) {
+            uint64_t hands = accumulate(begin(r.handCategories[i]), end(r.handCategories[i]), 0ull);
+            TTEST_EQUAL(hands, r.hands);
+        }
+    }
+    #endif
+
+    TTEST_CASE("cached preflops are not reused with a different board")
+    {
+        eq.setEnumeration(EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+        eq.start({"AK", "QQ"}, CardRange::getCardMask("2c3c"), 0, true);
+        eq.wait();
+        eq.start({"AK", "QQ"}, CardRange::getCardMask("AcAd"), 0, true);
+        eq.wait();
+        auto r1 = eq.getResults();
+        EquityCalculator eq2;
+        eq2.setEnumeration(EquityCalculator::ENUMERATION_PREFLOP_MAJOR);
+        eq2.start({"AK", "QQ"}, CardRange::getCardMask("AcAd"), 0, true);
+        eq2.wait();
+        auto r2 = eq2.getResults();
+        eq.setEnumeration(EquityCalculator::ENUMERATION_AUTO);
+        for (unsigned i = 0; i < 4; ++i)
+            TTEST_EQUAL(r1.winsByPlayerMask[i], r2.winsByPlayerMask[i]);
+    }
+
+    TTEST_CASE("small preflop cache evicts entries but gives the same results")
+    {
+        const TestCase& tc = TESTDATA[5];
+        std::vector<CardRange> ranges(tc.ranges.begin(), tc.ranges.end());
+        eq.setCacheSize(1 << 12);
+        eq.start(ranges, 0, 0, true);
+        eq.wait();
+        eq.setCacheSize((size_t)128 << 20);
+        auto r = eq.getResults();
+        for (unsigned i = 0; i < (1u << tc.ranges.size()); ++i)
+            TTEST_EQUAL(r.winsByPlayerMask[i], tc.expectedResults[i]);
+        TTEST_EQUAL(r.cacheHits + r.cacheMisses, r.preflopCombos - r.skippedPreflopCombos);
+        TTEST_EQUAL(r.cacheEvictions > 0, true);
+        TTEST_EQUAL(r.cacheMisses, r.evaluatedPreflopCombos);
+    }
+
+    #ifndef _WIN32
+    TTEST_CASE("persistent cache is reused by another calculator")
+    {
+        const TestCase& tc = TESTDATA[5];
+        std::vector<CardRange> ranges(tc.ranges.begin(), tc.ranges.end());
+        std::string path = "./preflop-" + std::to_string(tc.ranges.size()) + ".cache";
+        std::remove(path.c_str());
+        for (unsigned i = 0; i < 2; ++i) {
+            EquityCalculator eq2;
+            eq2.setCacheDirectory(".");
+            eq2.setCacheSize(1 << 24);
+            eq2.start(ranges, 0, 0, true);
+            eq2.wait();
+            auto r = eq2.getResults();
+            for (unsigned j = 0; j < (1u << tc.ranges.size()); ++j)
+                TTEST_EQUAL(r.winsByPlayerMask[j], tc.expectedResults[j]);
+            TTEST_EQUAL(r.cacheMisses > 0, i == 0);
+            TTEST_EQUAL(r.evaluations > 0, i == 0);
+        }
+        std::remove(path.c_str());
+    }
+
+    TTEST_CASE("persistent cache is not shared by different decks")
+    {
+        // Dead cards from two to five give the same keys as the short deck.
+        std::vector<CardRange> ranges{"AK", "99,JTs"};
+        const char* paths[] = {"./preflop-2.cache", "./preflop-short-2.cache"};
+        for (const char* path : paths)
+            std::remove(path);
+        eq.start(ranges, 0, ShortDeck::UNUSED_CARDS, true);
+        eq.wait();
+        auto expected = eq.getResults();
+
+        ShortDeckEquityCalculator shortDeck;
+        shortDeck.setCacheDirectory(".");
+        shortDeck.start(ranges, 0, 0, true);
+        shortDeck.wait();
+        EquityCalculator standard;
+        standard.setCacheDirectory(".");
+        standard.start(ranges, 0, ShortDeck::UNUSED_CARDS, true);
+        standard.wait();
+        auto r = standard.getResults();
+        TTEST_EQUAL(r.cacheHits, 0u);
+        for (unsigned i = 0; i < 4; ++i)
+            TTEST_EQUAL(r.winsByPlayerMask[i], expected.winsByPlayerMask[i]);
+        TTEST_EQUAL(r.equity[0], expected.equity[0]);
+        for (const char* path : paths)
+            std::remove(path);
+    }
+    #endif
+
+    TTEST_CASE("heads-up turn and river with wide ranges")
+    {
+        for (const char* board : {"Ks7d2h4c", "Ks7d2h4c4s"}) {
+            // Automatic choice of the engine. The sweep only evaluates each combo once per river.
+            auto results = compareEnumerations({"22+,A2s+,KTo+", "random"}, CardRange::getCardMask(board), 0,
+                                               EquityCalculator::ENUMERATION_AUTO);
+            TTEST_EQUAL(results[0].evaluations < results[1].evaluations / 10, true);
+        }
+
+        // Board-major evaluations are counted in showdowns of two ranked combos.
+        std::vector<CardRange> ranges{"22+,A2s+,KTo+", "random"};
+        uint64_t board = CardRange::getCardMask("Ks7d2h4c4s");
+        uint64_t combos = 0;
+        for (auto& range : ranges) {
+            for (auto& combo : range.combinations())
+                combos += !(board & ((1ull << combo[0]) | (1ull << combo[1])));
+        }
+        eq.setEnumeration(EquityCalculator::ENUMERATION_BOARD_MAJOR);
+        eq.start(ranges, board, 0, true, 0, nullptr, 0.2, 1);
+        eq.wait();
+        eq.setEnumeration(EquityCalculator::ENUMERATION_AUTO);
+        TTEST_EQUAL(eq.getResults().evaluations, combos / 2);
+    }
+};
+
+class OmahaEvaluatorTest : public ttest::TestBase
+{
+    OmahaEvaluator e;
+    HandEvaluator e2;
+
+    vector<uint8_t> cards(const string& text)
+    {
+        vector<uint8_t> v;
+        uint64_t mask = CardRange::getCardMask(text);
+        for (unsigned c = 0; c < CARD_COUNT; ++c) {
+            if (mask & (1ull << c))
+                v.push_back(c);
+        }
+        return v;
+    }
+
+    // Best rank of all 2+3 card combinations, evaluated one by one.
+    unsigned bruteForce(const vector<uint8_t>& hole, const vector<uint8_t>& board)
+    {
+        unsigned best = 0;
+        for (unsigned a = 0; a < hole.size(); ++a)
+            for (unsigned b = a + 1; b < hole.size(); ++b)
+                for (unsigned c = 0; c < board.size(); ++c)
+                    for (unsigned d = c + 1; d < board.size(); ++d)
+                        for (unsigned f = d + 1; f < board.size(); ++f)
+                            best = max<unsigned>(best, e2.evaluate(Hand::empty() + hole[a] + hole[b] + board[c]
+                                                                   + board[d] + board[f]));
+        return best;
+    }
+
+    TTEST_CASE("uses exactly two hole cards")
+    {
+        auto hole = cards("AcAdAhAs"), board = cards("KcKdKh2s3s");
+        TTEST_EQUAL(e.evaluate(hole.data(), 4, board.data(), 5) / HAND_CATEGORY_OFFSET, 7u);
+        hole = cards("As8s7d6d"), board = cards("2s3s4s5c9d");
+        TTEST_EQUAL(e.evaluate(hole.data(), 4, board.data(), 5) / HAND_CATEGORY_OFFSET, 6u);
+        hole = cards("As8h7d6d"), board = cards("2s3s4s5s9d");
+        TTEST_EQUAL(e.evaluate(hole.data(), 4, board.data(), 5) / HAND_CATEGORY_OFFSET, 5u);
+    }
+
+    TTEST_CASE("matches brute force evaluation")
+    {
+        XoroShiro128Plus rng(0);
+        FastUniformIntDistribution<unsigned,16> cardDist(0, CARD_COUNT - 1);
+        for (unsigned i = 0; i < 20000; ++i) {
+            unsigned holeCount = 4 + i % 2, boardCount = 3 + i % 3;
+            vector<uint8_t> v;
+            uint64_t usedCards = 0;
+            while (v.size() < holeCount + boardCount) {
+                unsigned c = cardDist(rng);
+                if (!(usedCards & (1ull << c)))
+                    v.push_back(c);
+                usedCards |= 1ull << c;
+            }
+            vector<uint8_t> hole(v.begin(), v.begin() + holeCount), board(v.begin() + holeCount, v.end());
+            TTEST_EQUAL(e.evaluate(hole.data(), holeCount, board.data(), boardCount), bruteForce(hole, board));
+        }
+    }
+};
+
+class OmahaEquityCalculatorTest : public ttest::TestBase
+{
+    TTEST_CASE("parseRange()")
+    {
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("random", 4).size(), 270725u);
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("random", 5).size(), 2598960u);
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("AsKsQsJs, AcKcQcJc", 4).size(), 2u);
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("AsKsQsJs,AcKcQcJc", 4, CardRange::getCardMask("As")).size(), 1u);
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("AsKsQs", 4).size(), 0u);
+        TTEST_EQUAL(OmahaEquityCalculator::parseRange("AsKsQsJs", 5).size(), 0u);
+    }
+
+    TTEST_CASE("start() returns false for invalid parameters")
+    {
+        OmahaEquityCalculator eq;
+        TTEST_EQUAL(eq.start({"AsKsQsJs", "random"}, 3), false);
+        TTEST_EQUAL(eq.start({"AsKsQsJs", "AsKsQsJs"}, 4, 0, 0, true), true);
+        eq.wait();
+        TTEST_EQUAL(eq.getResults().hands, 0u);
+        TTEST_EQUAL(eq.start({"AsKsQsJs", "AcKc"}, 4), false);
+        TTEST_EQUAL(eq.start({"random", "random", "random", "random", "random", "random"}, 5, 0, 0xffffffff), false);
+    }
+
+    TTEST_CASE("preflop count that overflows 64 bits")
+    {
+        // 270725^4 preflops can't be enumerated, but monte carlo works and reports a saturated count.
+        OmahaEquityCalculator eq;
+        vector<string> ranges(4, "random");
+        TTEST_EQUAL(eq.start(ranges, 4, 0, 0, true), false);
+        eq.setHandLimit(100000);
+        TTEST_EQUAL(eq.start(ranges, 4, 0, 0, false, 0), true);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.preflopCombos, ~0ull);
+        TTEST_EQUAL(r.hands >= 100000, true);
+    }
+
+    TTEST_CASE("seeded monte carlo")
+    {
+        OmahaEquityCalculator eq;
+        eq.setHandLimit(200000);
+        OmahaEquityCalculator::Results results[3];
+        for (unsigned i = 0; i < 3; ++i) {
+            eq.setSeed(i < 2 ? 123 : 124);
+            eq.start({"AsKsJdTd", "random", "random"}, 4, 0, 0, false, 0, nullptr, 0.2, 3);
+            eq.wait();
+            results[i] = eq.getResults();
+        }
+        TTEST_EQUAL(results[0].hands, results[1].hands);
+        for (unsigned i = 0; i < 8; ++i)
+            TTEST_EQUAL(results[0].winsByPlayerMask[i], results[1].winsByPlayerMask[i]);
+        TTEST_EQUAL(results[0].equity[0] != results[2].equity[0], true);
+    }
+
+    TTEST_CASE("river showdown")
+    {
+        OmahaEquityCalculator eq;
+        eq.start({"AcAdAhAs", "QcQdJcJd"}, 4, CardRange::getCardMask("KcKdKh2s3s"), 0, true);
+        eq.wait();
+        auto r = eq.getResults();
+        TTEST_EQUAL(r.hands, 1u);
+        TTEST_EQUAL(r.winsByPlayerMask[1], 1u);
+        TTEST_EQUAL(r.handCategories[0][FULL_HOUSE >> HAND_CATEGORY_SHIFT], 1u);
+        TTEST_EQUAL(r.handCategories[1][FULL_HOUSE >> HAND_CATEGORY_SHIFT], 1u);
+    }
+
+    TTEST_CASE("enumeration and monte carlo")
+    {
+        // Expected results by enumerating the turn and river with brute force evaluation.
+        HandEvaluator e;
+        vector<string> hands{"AsKsJdTd", "9h8h7c6c", "QhQcAd2c"};
+        uint64_t board = CardRange::getCardMask("Kh9d3h");
+        vector<uint64_t> masks;
+        uint64_t used = board;
+        for (auto& h : hands) {
+            masks.push_back(CardRange::getCardMask(h));
+            used |= masks.back();
+        }
+        uint64_t expected[1 << 3] = {};
+        for (unsigned t = 0; t < CARD_COUNT; ++t) {
+            for (unsigned r = t + 1; r < CARD_COUNT; ++r) {
+                if (used & ((1ull << t) | (1ull << r)))
+                    continue;
+                uint64_t fullBoard = board | 1ull << t | 1ull << r;
+                unsigned best = 0, winners = 0;
+                for (unsigned p = 0; p < hands.size(); ++p) {
+                    unsigned rank = 0;
+                    for (uint64_t h = masks[p]; h; h &= h - 1) {
+                        for (uint64_t h2 = h & (h - 1); h2; h2 &= h2 - 1) {
+                            for (uint64_t b1 = fullBoard; b1; b1 &= b1 - 1) {
+                                for (uint64_t b2 = b1 & (b1 - 1); b2; b2 &= b2 - 1) {
+                                    for (uint64_t b3 = b2 & (b2 - 1); b3; b3 &= b3 - 1) {
+                                        rank = max<unsigned>(rank, e.evaluate(Hand::empty()
+                                                + countTrailingZeros(h) + countTrailingZeros(h2)
+                                                + countTrailingZeros(b1) + countTrailingZeros(b2)
+                                                + countTrailingZeros(b3)));
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    if (rank > best)
+                        best = rank, winners = 0;
+                    if (rank == best)
+                        winners |= 1 << p;
+                }
+                ++expected[winners];
+            }
+        }
+
+        OmahaEquityCalculator eq;
+        eq.start(hands, 4, board, 0, true);
+        eq.wait();
+        auto r = eq.getResults();
+        for (unsigned i = 0; i < (1u << 3); ++i)
+            TTEST_EQUAL(r.winsByPlayerMask[i], expected[i]);
+
+        double hands0 = accumulate(begin(expected), end(expected), 0.0);
+        bool timeout = false;
+        auto callback = [&](const OmahaEquityCalculator::Results& r){
+            double maxErr = 0;
+            for (unsigned i = 0; i < (1u << 3); ++i)
+                maxErr = max(std::abs(expected[i] / hands0 - (double)r.winsByPlayerMask[i] / r.hands), maxErr);
+            if (maxErr < 2e-3)
+                eq.stop();
+            if (r.time > 10) {
+                timeout = true;
+                eq.stop();
+            }
+        };
+        eq.start(hands, 4, board, 0, false, 0, callback, 0.1);
+        eq.wait();
+        if (timeout)
+            throw ttest::TestException("Didn't converge to correct results in time!");
+    }
 };
 
 void printBuildInfo()
@@ -395,10 +1512,17 @@ void printBuildInfo()
     #if OMP_SSE4
     cout << "SSE4" << endl;
     #endif
+    #if OMP_AVX2
+    cout << "AVX2" << endl;
+    #endif
+    HandEvaluator eval;
+    cout << "Evaluator kernel: " << HandEvaluator::kernelName(HandEvaluator::kernel()) << endl;
 }
 
-int main()
+// Usage: test [--json FILE]. With --json the benchmark results are also written to FILE.
+int main(int argc, char** argv)
 {
+    const char* jsonFile = argc > 2 && string(argv[1]) == "--json" ? argv[2] : nullptr;
     printBuildInfo();
 
     cout << endl << "=== Tests ===" << endl;
@@ -408,11 +1532,23 @@ int main()
     HandTest().run();
     cout << "HandEvaluator:" << endl;
     HandEvaluatorTest().run();
+    cout << "ShortDeckHandEvaluator:" << endl;
+    ShortDeckHandEvaluatorTest().run();
+    cout << "CompactHandEvaluator:" << endl;
+    CompactHandEvaluatorTest().run();
+    cout << "PreflopCache:" << endl;
+    PreflopCacheTest().run();
+    cout << "PreflopDatabase:" << endl;
+    PreflopDatabaseTest().run();
     cout << "EquityCalculator:" << endl;
     EquityCalculatorTest().run();
+    cout << "OmahaEvaluator:" << endl;
+    OmahaEvaluatorTest().run();
+    cout << "OmahaEquityCalculator:" << endl;
+    OmahaEquityCalculatorTest().run();
 
     cout << endl << endl << "=== Benchmarks ===" << endl;
-    void benchmark();
-    benchmark();
+    void benchmark(const char* jsonFile);
+    benchmark(jsonFile);
     cout << endl << "Done." << endl;
 }
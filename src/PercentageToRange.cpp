@@ -67,9 +67,9 @@ std::string PercentageToRange::percentage_to_str(const std::string percentage){
     //We catch exceptions here because we don't "trust" the program calling
     //this method to necessarily do it themselves, but throw them as our
     //own errors to display the problem easily
-  } catch (std::out_of_range oor){
+  } catch (const std::out_of_range&){
     throw std::string("out of range percentage range " + percentage);
-  } catch (std::invalid_argument ia){
+  } catch (const std::invalid_argument&){
     //This will occurr if there is anything before the number itself, e.g.
     //input "fdssa60%"
     throw std::string("invalid percentage range " + percentage);
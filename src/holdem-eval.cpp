@@ -24,7 +24,8 @@ string progname; //global scope to be accessed outside of main
 std::cerr by default, but can be changed with optional argument. */
 void print_usage(ostream& outs = cerr){
   outs << "usage: " << progname << " [-ha] [--format] [--mc] [-b BOARD] "
-       << "[-d DEAD] [-e ERROR] [-t TIME] range1 range2 [range3...]" << endl;
+       << "[-d DEAD] [-e ERROR] [-t TIME] [--cache DIR] [--preflop-db FILE] "
+       << "[--seed SEED] range1 range2 [range3...]" << endl;
   outs << "\th: prints this help information and exits" << endl;
   outs << "\ta: print advanced statistics" << endl;
   outs << "\tformat: heavily abridges results printing" << endl;
@@ -33,6 +34,10 @@ void print_usage(ostream& outs = cerr){
   outs << "\tdead: the dead cards (e.g. Ad2s)" << endl;
   outs << "\te: margin of error, as proportion or percentage" << endl;
   outs << "\tt: maximum time for evaluation (0 for infinite)" << endl;
+  outs << "\tcache: directory for results shared between runs" << endl;
+  outs << "\tpreflop-db: database of precalculated preflop results" << endl;
+  outs << "\tseed: monte-carlo seed, repeats the same results (0 for random)"
+       << endl;
   outs << "\trange1, range2, etc.: range to be included in analysis" << endl;
   outs << "\tMaximum of 6 total ranges" << endl;
   outs << "\tRanges can be input in EquiLab/Pokerstove syntax";
@@ -130,6 +135,9 @@ int main(int argc, char **argv){
   bool monte_carlo = false;
   bool print_advanced_info = false; bool format_results = false;
   double err_margin = 1e-4; double time_max = 30;
+  string cache_dir; //empty: results are only cached in memory
+  string preflop_db; //empty: no database
+  uint64_t seed = 0; //0: random seed
 
   static struct option long_options[] = {
     {"board", required_argument, 0, 'b'},
@@ -142,6 +150,9 @@ int main(int argc, char **argv){
     {"help", no_argument, 0, 'h'},
     {"advanced", no_argument, 0, 'a'},
     {"format", no_argument, 0, 'f'},
+    {"cache", required_argument, 0, 'c'},
+    {"preflop-db", required_argument, 0, 'p'},
+    {"seed", required_argument, 0, 's'},
     {0, 0, 0, 0} //required by getopt_long
   };
   int opt_character;
@@ -167,9 +178,9 @@ int main(int argc, char **argv){
           if ((trail != "") && (trail.at(0) == '%')){
             err_margin /= 100; //error margin inputted as a percentage
           }
-        } catch (out_of_range oor) {
+        } catch (const out_of_range&) {
           fail_prog("Out of range error margin " + cpp_err, 2, false);
-        } catch (invalid_argument ia) {
+        } catch (const invalid_argument&) {
           fail_prog("Invalid error margin argument " + cpp_err, 2, false);
         }
         break;
@@ -179,9 +190,9 @@ int main(int argc, char **argv){
         string cpp_time = optarg;
         try {
           time_max = stod(cpp_time);
-        } catch (out_of_range oor) {
+        } catch (const out_of_range&) {
           fail_prog("Out of range maximum time " + cpp_time, 2, false);
-        } catch (invalid_argument ia) {
+        } catch (const invalid_argument&) {
           fail_prog("Invalid maximum time argument " + cpp_time, 2, false);
         }
         break;
@@ -197,6 +208,29 @@ int main(int argc, char **argv){
       case 'f':
         format_results = true;
         break;
+      case 'c':
+        cache_dir = optarg;
+        break;
+      case 'p':
+        preflop_db = optarg;
+        break;
+      case 's':
+      {
+        string cpp_seed = optarg;
+        //stoull would accept a sign or leading whitespace and wrap
+        //negative numbers around, so only plain digits are allowed
+        if (cpp_seed.find_first_not_of("0123456789") != string::npos) {
+          fail_prog("Invalid seed argument " + cpp_seed, 2, false);
+        }
+        try {
+          seed = stoull(cpp_seed);
+        } catch (const out_of_range&) {
+          fail_prog("Out of range seed " + cpp_seed, 2, false);
+        } catch (const invalid_argument&) {
+          fail_prog("Invalid seed argument " + cpp_seed, 2, false);
+        }
+        break;
+      }
       default:
         //getopt prints the error message for us
         //./holdem-eval: invalid option -- '(option)'
@@ -225,6 +259,10 @@ int main(int argc, char **argv){
   //by the library, so we falsify our boolean
   EquityCalculator eq;
   eq.setTimeLimit(time_max);
+  eq.setCacheDirectory(cache_dir);
+  eq.setSeed(seed);
+  if (!eq.setPreflopDatabase(preflop_db))
+    fail_prog("invalid preflop database " + preflop_db, 9, false);
   //Before we call eq.wait(), we make sure that eq doesn't just bail out on us
   //If start returns false, something went wrong
   if (!eq.start(ranges, board, dead, !monte_carlo, err_margin)){
@@ -309,6 +347,8 @@ int main(int argc, char **argv){
       cout.precision(6);
       cout << "Standard deviation: " << r.stdev << endl;
     }
+    cout << "Evaluator kernel: "
+         << HandEvaluator::kernelName(HandEvaluator::kernel()) << "." << endl;
   }
 
   return EXIT_SUCCESS;